@@ -10,26 +10,163 @@
 #ifndef __FAULT_RECORDER_H
 #define __FAULT_RECORDER_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// FaultRecordCheck return values
+#define FAULT_RECORD_CHECK_NONE         (0)     ///< No new fault record
+#define FAULT_RECORD_CHECK_FAULT        (1)     ///< New fault record (fault reset)
+#define FAULT_RECORD_CHECK_LOOP         (2)     ///< New fault record, reset loop detected
+
+/// Fault record summary (FaultRecordCheck).
+typedef struct {
+  uint32_t exception;                   ///< Exception number of the recorded fault (0 = no new record or not recorded)
+  uint32_t pc;                          ///< Return address (PC) of the faulting code
+  uint32_t hang;                        ///< == 1 - hang was recorded (FaultRecordHang)
+  uint32_t interrupted;                 ///< == 1 - recording was interrupted (reset, lockup or nested fault)
+  uint32_t boot_count;                  ///< Number of boots since power-on
+  uint32_t fault_count;                 ///< Number of consecutive fault resets
+} FaultRecordSummary_t;
+
+/// Exit action function (called with the counter value by which it must return).
+typedef void (*FaultRecordExitAction_t) (uint32_t deadline);
+
 // Fault Recorder callback functions -------------------------------------------
 
 /// Callback function called after fault information was recorded.
 extern void FaultRecordOnExit (void);
 
+/// Callback function called after PC sample was taken.
+extern void FaultRecordSampleOnExit (void);
+
+/// Callback function called after stack headroom was checked.
+extern void FaultRecordStackMonitorOnExit (void);
+
+/// Callback function called before the first exit action (arm or reload the watchdog).
+extern void FaultRecordExitWatchdog (uint32_t timeout);
+
 // Fault Recorder functions ----------------------------------------------------
 
 /// Record fault information.
 extern void FaultRecord (void);
 
+/// Record hang information (from watchdog early warning interrupt handler).
+extern void FaultRecordHang (void);
+
+/// Record fault information (HardFault handler entry, same as FaultRecord).
+extern void FaultRecordHardFault (void);
+
+/// Record fault information (MemManage fault handler entry, Mainline only).
+extern void FaultRecordMemManage (void);
+
+/// Record fault information (BusFault handler entry, Mainline only).
+extern void FaultRecordBusFault (void);
+
+/// Record fault information (UsageFault handler entry, Mainline only).
+extern void FaultRecordUsageFault (void);
+
+/// Record fault information (SecureFault handler entry, Armv8/8.1-M Mainline Secure World only).
+extern void FaultRecordSecureFault (void);
+
 /// Print recorded fault information.
 extern void FaultRecordPrint (void);
 
 /// Clear recorded fault information.
 extern void FaultRecordClear (void);
 
+/// Check for new fault record and reset loop (fast, without printing).
+extern int32_t FaultRecordCheck (FaultRecordSummary_t *summary);
+
+/// Reset the consecutive fault reset counter.
+extern void FaultRecordCheckReset (void);
+
+/// Register exit action executed before system reset.
+extern int32_t FaultRecordExitActionRegister (FaultRecordExitAction_t func, uint32_t budget, uint32_t code_start, uint32_t code_end);
+
+/// Execute registered exit actions (called by default FaultRecordOnExit).
+extern void FaultRecordExitRun (void);
+
+/// Check if exit action deadline has passed.
+extern int32_t FaultRecordExitTimeout (uint32_t deadline);
+
+/// Write data to the print ring buffer.
+extern int32_t FaultRecordRingWrite (const char *data, uint32_t len);
+
+/// Format output and write it to the print ring buffer.
+extern int32_t FaultRecordRingPrintf (const char *format, ...);
+
+/// Attach data to the transferred fault record.
+extern int32_t FaultRecordTransportAttach (const void *data, uint32_t len);
+
+/// Start or resume the chunked transfer of the recorded fault information.
+extern int32_t FaultRecordTransportStart (uint32_t mtu);
+
+/// Build the next chunk packet to be sent.
+extern int32_t FaultRecordTransportNext (uint8_t *pkt, uint32_t size);
+
+/// Process an acknowledgement packet received from the receiver.
+extern int32_t FaultRecordTransportAck (const uint8_t *pkt, uint32_t len);
+
+/// Take PC sample of the interrupted code (branch to it from a periodic interrupt handler).
+extern void FaultRecordSample (void);
+
+/// Print PC samples.
+extern void FaultRecordSamplePrint (void);
+
+/// Clear PC samples.
+extern void FaultRecordSampleClear (void);
+
+/// Register stack for stack usage measurement upon fault recording.
+extern int32_t FaultRecordStackRegister (void *base, uint32_t size);
+
+/// Paint stack and register it for stack usage measurement upon fault recording.
+extern int32_t FaultRecordStackPaint (void *base, uint32_t size);
+
+/// Check stack headroom and record near-miss (branch to it from a periodic interrupt handler).
+extern void FaultRecordStackMonitor (void);
+
+/// Set the stack limits checked by the stack monitor (current core).
+extern int32_t FaultRecordStackMonitorLimit (const void *msp_limit, const void *psp_limit);
+
+/// Print stack near-miss records.
+extern void FaultRecordStackMonitorPrint (void);
+
+/// Clear stack near-miss records.
+extern void FaultRecordStackMonitorClear (void);
+
+/// Append recorded fault information to the compressed fault history.
+extern int32_t FaultRecordHistoryAdd (void);
+
+/// Print compressed fault history.
+extern void FaultRecordHistoryPrint (void);
+
+/// Clear compressed fault history.
+extern void FaultRecordHistoryClear (void);
+
+/// Encode recorded fault information as CBOR into buffer.
+extern int32_t FaultRecordEncodeCBOR (uint8_t *buf, uint32_t size);
+
+/// Encode recorded fault information as JSON into buffer.
+extern int32_t FaultRecordEncodeJSON (char *buf, uint32_t size);
+
+// Non-secure callable functions -----------------------------------------------
+// (provided by Secure image compiled with FR_NS_ACCESS = 1, called from Non-secure image)
+
+/// Get summary of the recorded fault information.
+extern int32_t FaultRecordSummary_S (FaultRecordSummary_t *summary);
+
+/// Encode recorded fault information as CBOR into Non-secure buffer.
+extern int32_t FaultRecordEncodeCBOR_S (uint8_t *buf, uint32_t size);
+
+/// Encode recorded fault information as JSON into Non-secure buffer.
+extern int32_t FaultRecordEncodeJSON_S (char *buf, uint32_t size);
+
+/// Clear recorded fault information.
+extern void FaultRecordClear_S (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,688 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - fault record database
+#
+# Append-only columnar store of decoded fault records with a query CLI.
+#
+# Records are read from FaultRecordEncodeJSON or FaultRecordEncodeCBOR output
+# (also as fetched with the Non-secure callable functions) or FaultRecordPrint logs.
+# Each column is a file of 32-bit little-endian values (build ID and device ID
+# are dictionary encoded), so queries only touch the columns they use and
+# memory-map them instead of loading them:
+#   - equality on pc, lr, addr scans the column with a byte search (runs at
+#     memory bandwidth),
+#   - exception, build and device have secondary indexes (posting lists of
+#     row numbers per value),
+#   - cfsr and hfsr have a posting list per set bit, so --cfsr-bit and
+#     --hfsr-bit queries read row numbers instead of testing every row,
+#   - per-block min/max (zone maps) skip blocks on range queries (time).
+# Matching rows are produced by generators, so neither the candidate rows nor
+# the result are held in memory (--count and --group-by stream over them).
+# Rows become visible when the row count in meta.json is updated, after all
+# columns were appended, so an interrupted append leaves the database valid.
+#
+# The selftest command tests this script: it decodes fixed example outputs in
+# the FaultRecordPrint, FaultRecordEncodeJSON and FaultRecordEncodeCBOR formats,
+# stores them in a temporary database and checks the decoded records and the
+# results of a set of queries (FaultRecorder.c is tested by Test/run_tests.py).
+#
+# Usage:
+#   fr_db.py --db DIR add [--device ID] [--time 2026-10-18T10:00] logs/*.json
+#   fr_db.py --db DIR query --exception BusFault --pc 0x08001234 --build 0fb407ef --since 2026-10-11
+#   fr_db.py --db DIR query --cfsr-bit PRECISERR --group-by pc
+#   fr_db.py --db DIR stats
+#   fr_db.py selftest
+# -----------------------------------------------------------------------------
+
+import argparse
+import calendar
+import heapq
+import json
+import mmap
+import os
+import re
+import struct
+import sys
+import tempfile
+import time
+from array import array
+from collections import Counter, defaultdict
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fr_records import EXCEPTIONS, decode_cbor, read_maps      # noqa: E402
+
+COLUMNS = ['exception', 'cfsr', 'hfsr', 'pc', 'lr', 'addr', 'build', 'device', 'time']
+DICT_COLUMNS = ('build', 'device')                  # dictionary encoded (value = dictionary index)
+INDEXED = ('exception', 'build', 'device')          # secondary indexes
+BIT_INDEXED = ('cfsr', 'hfsr')                      # posting lists per set bit (index name <column>_bit)
+BLOCK = 65536                                       # rows per zone map block
+
+CFSR_BITS = {'IACCVIOL': 0, 'DACCVIOL': 1, 'MUNSTKERR': 3, 'MSTKERR': 4, 'MLSPERR': 5, 'MMARVALID': 7,
+             'IBUSERR': 8, 'PRECISERR': 9, 'IMPRECISERR': 10, 'UNSTKERR': 11, 'STKERR': 12, 'LSPERR': 13,
+             'BFARVALID': 15, 'UNDEFINSTR': 16, 'INVSTATE': 17, 'INVPC': 18, 'NOCP': 19, 'STKOF': 20,
+             'UNALIGNED': 24, 'DIVBYZERO': 25}
+HFSR_BITS = {'VECTTBL': 1, 'FORCED': 30, 'DEBUGEVT': 31}
+
+
+def fault_address(cfsr, mmfar, bfar):
+    if cfsr & (1 << CFSR_BITS['BFARVALID']):
+        return bfar
+    if cfsr & (1 << CFSR_BITS['MMARVALID']):
+        return mmfar
+    return 0
+
+
+def parse_time(text):
+    for fmt in ('%Y-%m-%dT%H:%M:%S', '%Y-%m-%dT%H:%M', '%Y-%m-%d'):
+        try:
+            return calendar.timegm(time.strptime(text, fmt))
+        except ValueError:
+            pass
+    return int(text, 0)
+
+
+def map_record(rec):
+    """Decoded record of a FaultRecordEncodeJSON/FaultRecordEncodeCBOR map (or FaultRecordPrint log record)."""
+    cfsr = rec.get('CFSR', 0)
+    return {'exception': rec.get('exception', 0), 'cfsr': cfsr, 'hfsr': rec.get('HFSR', 0),
+            'pc': rec.get('ReturnAddress', 0), 'lr': rec.get('LR', 0),
+            'addr': fault_address(cfsr, rec.get('MMFAR', 0), rec.get('BFAR', 0)),
+            'build': rec.get('build_id', '')}
+
+
+def read_records(path):
+    """Yield decoded records (dict with exception, cfsr, hfsr, pc, lr, addr, build) of a JSON/CBOR output or text log,
+    stack near-miss records are skipped."""
+    yield from (map_record(rec) for rec in read_maps(path) if not rec.get('near_miss'))
+
+
+class FaultDB:
+    """Append-only columnar fault record database."""
+
+    def __init__(self, path):
+        self.path = path
+        os.makedirs(os.path.join(path, 'idx'), exist_ok=True)
+        meta = os.path.join(path, 'meta.json')
+        self.rows = 0
+        self.bit_index = True           # bit posting lists cover all rows
+        if os.path.exists(meta):
+            with open(meta) as f:
+                info = json.load(f)
+            self.rows = info['rows']
+            self.bit_index = info.get('bit_index', False)
+        self.dicts = {}
+        for col in DICT_COLUMNS:
+            self.dicts[col] = []
+            name = os.path.join(path, col + '.dict')
+            if os.path.exists(name):
+                with open(name) as f:
+                    self.dicts[col] = f.read().splitlines()
+        self.dict_ids = {col: {v: i for i, v in enumerate(vals)} for col, vals in self.dicts.items()}
+        self.zones = self._read_zones()
+        self.maps = {}
+
+    def _file(self, col):
+        return os.path.join(self.path, col + '.u32')
+
+    def _read_zones(self):
+        zones = array('I')
+        name = os.path.join(self.path, 'zones.u32')
+        if os.path.exists(name):
+            with open(name, 'rb') as f:
+                zones.frombytes(f.read())
+        num = (self.rows + BLOCK - 1) // BLOCK
+        return zones[:num * 2 * len(COLUMNS)]
+
+    def append(self, records):
+        """Append records (dicts with all COLUMNS, build and device as strings)."""
+        if not records:
+            return
+        cols = {col: array('I') for col in COLUMNS}
+        postings = defaultdict(lambda: array('I'))
+        if not self.bit_index:
+            # Database created without bit posting lists: build them for the existing rows first
+            for name in os.listdir(os.path.join(self.path, 'idx')):
+                if name.startswith(tuple(col + '_bit_' for col in BIT_INDEXED)):
+                    os.remove(os.path.join(self.path, 'idx', name))
+            for col in BIT_INDEXED:
+                for row, val in enumerate(self.column(col)):
+                    self._add_bits(postings, col, val, row)
+        for n, rec in enumerate(records):
+            row = self.rows + n
+            for col in COLUMNS:
+                val = rec[col]
+                if col in DICT_COLUMNS:
+                    if val not in self.dict_ids[col]:
+                        self.dict_ids[col][val] = len(self.dicts[col])
+                        self.dicts[col].append(val)
+                    val = self.dict_ids[col][val]
+                cols[col].append(val & 0xFFFFFFFF)
+                if col in INDEXED:
+                    postings[(col, val)].append(row)
+                if col in BIT_INDEXED:
+                    self._add_bits(postings, col, val, row)
+        for col in DICT_COLUMNS:
+            with open(os.path.join(self.path, col + '.dict'), 'w') as f:
+                f.write(''.join(v + '\n' for v in self.dicts[col]))
+        # Remove data of an interrupted append, then append columns and postings
+        if os.path.exists(self._file(COLUMNS[0])) and os.path.getsize(self._file(COLUMNS[0])) > self.rows * 4:
+            for name in os.listdir(os.path.join(self.path, 'idx')):
+                name = os.path.join(self.path, 'idx', name)
+                with open(name, 'ab') as f:
+                    f.truncate(4 * self._posting_len(name, self.rows))
+        for col in COLUMNS:
+            with open(self._file(col), 'ab') as f:
+                f.truncate(self.rows * 4)
+                cols[col].tofile(f)
+        for (col, val), rows in postings.items():
+            with open(os.path.join(self.path, 'idx', '%s_%x.u32' % (col, val)), 'ab') as f:
+                rows.tofile(f)
+        # Zone maps (min, max per column and block)
+        for n in range(len(records)):
+            row = self.rows + n
+            base = (row // BLOCK) * 2 * len(COLUMNS)
+            if row % BLOCK == 0:
+                self.zones.extend([0xFFFFFFFF, 0] * len(COLUMNS))
+            for c, col in enumerate(COLUMNS):
+                val = cols[col][n]
+                if val < self.zones[base + 2 * c]:
+                    self.zones[base + 2 * c] = val
+                if val > self.zones[base + 2 * c + 1]:
+                    self.zones[base + 2 * c + 1] = val
+        with open(os.path.join(self.path, 'zones.u32'), 'wb') as f:
+            self.zones.tofile(f)
+        # Commit
+        self.rows += len(records)
+        self.bit_index = True
+        with open(os.path.join(self.path, 'meta.json.tmp'), 'w') as f:
+            json.dump({'rows': self.rows, 'columns': COLUMNS, 'block': BLOCK, 'bit_index': True}, f)
+        os.replace(os.path.join(self.path, 'meta.json.tmp'), os.path.join(self.path, 'meta.json'))
+
+    @staticmethod
+    def _add_bits(postings, col, val, row):
+        """Add row to the posting lists of the set bits of val."""
+        while val:
+            low = val & -val
+            postings[(col + '_bit', low.bit_length() - 1)].append(row)
+            val ^= low
+
+    @staticmethod
+    def _posting_len(name, rows):
+        """Number of committed entries of a posting list (ascending row numbers below rows)."""
+        if not os.path.exists(name):
+            return 0
+        n = os.path.getsize(name) // 4
+        with open(name, 'rb') as f:
+            while n:
+                f.seek(4 * (n - 1))
+                if struct.unpack('<I', f.read(4))[0] < rows:
+                    break
+                n -= 1
+        return n
+
+    def column(self, col):
+        """Memory-mapped column (memoryview of 32-bit values, committed rows only)."""
+        if col not in self.maps:
+            if self.rows == 0:
+                self.maps[col] = memoryview(array('I'))
+            else:
+                with open(self._file(col), 'rb') as f:
+                    mm = mmap.mmap(f.fileno(), self.rows * 4, access=mmap.ACCESS_READ)
+                self.maps[col] = memoryview(mm).cast('I')
+        return self.maps[col]
+
+    def posting_size(self, col, val):
+        name = os.path.join(self.path, 'idx', '%s_%x.u32' % (col, val))
+        return os.path.getsize(name) // 4 if os.path.exists(name) else 0
+
+    def posting(self, col, val):
+        """Yield the committed rows of a posting list (ascending), read in blocks."""
+        name = os.path.join(self.path, 'idx', '%s_%x.u32' % (col, val))
+        if not os.path.exists(name) or os.path.getsize(name) == 0:
+            return
+        with open(name, 'rb') as f:
+            while True:
+                post = array('I')
+                post.frombytes(f.read(4 * BLOCK))
+                if not post:
+                    return
+                for r in post:
+                    if r >= self.rows:
+                        return
+                    yield r
+
+    def scan_equal(self, col, val):
+        """Yield rows with column == val (byte search over the memory-mapped column)."""
+        if self.rows == 0:
+            return
+        raw = self.column(col).obj
+        pattern = struct.pack('<I', val)
+        pos = raw.find(pattern, 0, self.rows * 4)
+        while pos >= 0:
+            if pos % 4 == 0:
+                yield pos // 4
+                pos = raw.find(pattern, pos + 4, self.rows * 4)
+            else:
+                pos = raw.find(pattern, pos + 1, self.rows * 4)
+
+    def blocks(self, ranges):
+        """Row ranges of the blocks whose zone maps may satisfy ranges {column: (min, max)}."""
+        for b in range((self.rows + BLOCK - 1) // BLOCK):
+            base = b * 2 * len(COLUMNS)
+            if all(self.zones[base + 2 * COLUMNS.index(col) + 1] >= lo and
+                   self.zones[base + 2 * COLUMNS.index(col)] <= hi for col, (lo, hi) in ranges.items()):
+                yield b * BLOCK, min((b + 1) * BLOCK, self.rows)
+
+
+class Query:
+    """Conjunction of column predicates."""
+
+    def __init__(self, db):
+        self.db = db
+        self.equal = {}                 # column -> set of accepted values
+        self.ranges = {}                # column -> (min, max)
+        self.masks = []                 # (column, mask): all mask bits set
+
+    def match(self, row):
+        for col, vals in self.equal.items():
+            if self.db.column(col)[row] not in vals:
+                return False
+        for col, (lo, hi) in self.ranges.items():
+            if not lo <= self.db.column(col)[row] <= hi:
+                return False
+        for col, mask in self.masks:
+            if self.db.column(col)[row] & mask != mask:
+                return False
+        return True
+
+    def rows(self):
+        """Yield matching rows (ascending)."""
+        db = self.db
+        # Smallest candidate set of the indexed equality predicates and the set bit predicates
+        indexes = [(col, self.equal[col]) for col in INDEXED if col in self.equal]
+        if db.bit_index:
+            indexes += [(col + '_bit', [bit]) for col, mask in self.masks for bit in range(32) if mask >> bit & 1]
+        index_col, index_vals, index_size = None, (), 0
+        for col, vals in indexes:
+            size = sum(db.posting_size(col, v) for v in vals)
+            if index_col is None or size < index_size:
+                index_col, index_vals, index_size = col, vals, size
+        scan_col = next((col for col in ('pc', 'addr', 'lr') if len(self.equal.get(col, ())) == 1), None)
+        # Use the posting list if small, else the byte search over a column, else scan blocks
+        if index_col is not None and (scan_col is None or index_size <= BLOCK):
+            cands = heapq.merge(*(db.posting(index_col, v) for v in index_vals))
+        elif scan_col is not None:
+            cands = db.scan_equal(scan_col, next(iter(self.equal[scan_col])))
+        else:
+            return self.scan_blocks()
+        return (r for r in cands if self.match(r))
+
+    def scan_blocks(self):
+        """Scan blocks not excluded by zone maps, filtering each block by the first predicate column."""
+        db = self.db
+        if self.masks:
+            col, mask = self.masks[0]
+            cond = lambda v: v & mask == mask                           # noqa: E731
+        elif self.ranges:
+            col, (lo, hi) = next(iter(self.ranges.items()))
+            cond = lambda v: lo <= v <= hi                              # noqa: E731
+        elif self.equal:
+            col, vals = next(iter(self.equal.items()))
+            cond = vals.__contains__
+        else:
+            yield from range(db.rows)
+            return
+        for start, end in db.blocks(self.ranges):
+            values = db.column(col)[start:end]
+            yield from (r for r in (start + i for i, v in enumerate(values) if cond(v)) if self.match(r))
+
+
+def cmd_add(db, args):
+    when = parse_time(args.time) if args.time else None
+    records = []
+    for path in args.files:
+        ftime = when if when is not None else int(os.path.getmtime(path))
+        for rec in read_records(path):
+            rec['device'] = args.device or os.path.basename(os.path.dirname(os.path.abspath(path)))
+            rec['time'] = ftime
+            records.append(rec)
+    db.append(records)
+    print('Added %u records (%u total).' % (len(records), db.rows))
+    return 0
+
+
+def make_query(db, args):
+    """Query of the query command arguments."""
+    q = Query(db)
+    if args.exception:
+        q.equal['exception'] = {EXCEPTIONS.get(e, None) or int(e, 0) for e in args.exception}
+    for col in ('pc', 'lr', 'addr'):
+        if getattr(args, col) is not None:
+            q.equal[col] = {int(v, 0) for v in getattr(args, col)}
+    for col, values in (('build', args.build), ('device', args.device)):
+        if values:
+            ids = {i for i, v in enumerate(db.dicts[col]) if any(v.startswith(p.lower() if col == 'build' else p)
+                                                                  for p in values)}
+            q.equal[col] = ids
+    if args.since or args.until:
+        q.ranges['time'] = (parse_time(args.since) if args.since else 0,
+                            parse_time(args.until) if args.until else 0xFFFFFFFF)
+    for name in args.cfsr_bit or []:
+        q.masks.append(('cfsr', 1 << CFSR_BITS[name.upper()]))
+    for name in args.hfsr_bit or []:
+        q.masks.append(('hfsr', 1 << HFSR_BITS[name.upper()]))
+    return q
+
+
+def cmd_query(db, args):
+    q = make_query(db, args)
+    t0 = time.perf_counter()
+    rows = q.rows()
+
+    def value(col, row, raw=False):
+        v = row if raw else db.column(col)[row]
+        if col in DICT_COLUMNS:
+            return db.dicts[col][v]
+        if col == 'time':
+            return time.strftime('%Y-%m-%dT%H:%M:%S', time.gmtime(v))
+        if col == 'exception':
+            return str(v)
+        return '0x%08X' % v
+
+    matched = 0
+    if args.group_by:
+        column = db.column(args.group_by)
+        groups = Counter(column[r] for r in rows)
+        matched = sum(groups.values())
+        elapsed = time.perf_counter() - t0
+        for key, num in groups.most_common(args.limit or None):
+            print('%10u  %s' % (num, value(args.group_by, key, raw=True)))
+    elif args.count:
+        matched = sum(1 for _ in rows)
+        elapsed = time.perf_counter() - t0
+    else:
+        print('  '.join('%-10s' % c for c in COLUMNS))
+        for r in rows:
+            if not args.limit or matched < args.limit:
+                print('  '.join('%-10s' % value(c, r) for c in COLUMNS))
+            matched += 1
+        elapsed = time.perf_counter() - t0
+    print('%u of %u records matched (%.3f s)' % (matched, db.rows, elapsed), file=sys.stderr)
+    return 0
+
+
+def cmd_stats(db, args):
+    size = sum(os.path.getsize(os.path.join(root, f)) for root, _, files in os.walk(db.path) for f in files)
+    print('Records:   %u' % db.rows)
+    print('Builds:    %u' % len(db.dicts['build']))
+    print('Devices:   %u' % len(db.dicts['device']))
+    print('Size:      %u bytes' % size)
+    return 0
+
+
+# Decoder fixtures for the selftest command: example outputs in the FaultRecordPrint,
+# FaultRecordEncodeJSON and FaultRecordEncodeCBOR formats and the records they decode to.
+SELFTEST_TIME = '2026-10-18T10:00'
+
+# Two-core print and JSON output (decoding only; the slot selection of the fault entry
+# is tested by the multicore test of Test/run_tests.py)
+SELFTEST_DUAL_CORE_LOG = """
+--- Last recorded Fault information (v0.1) ---
+
+  Exception Handler: BusFault
+  Mode:              Thread
+  Core:              1
+  Timestamp:         0x000107D0
+  Build ID:          0fb407ef00112233445566778899aabbccddeeff
+  Fault:             BusFault - Data access failure due to bus fault (precise), fault address 0x40021018
+
+   - PC:             0x08002410
+   - MSP:            0x20007FC0
+   - PSP:            0x20002F20
+
+  Exception stacked state context:
+   - R0:             0x20000401
+   - R1:             0x00000000
+   - R2:             0x00000000
+   - R3:             0x00000000
+   - R12:            0x00000000
+   - LR:             0x080023F9
+   - ReturnAddress:  0x08002410
+   - xPSR:           0x01000000
+
+  Fault registers:
+   - CFSR:           0x00008200
+   - HFSR:           0x00000000
+   - DFSR:           0x00000000
+   - MMFAR:          0x40021018
+   - BFAR:           0x40021018
+   - AFSR:           0x00000000
+
+
+--- Last recorded Fault information (v0.1) ---
+
+  Exception Handler: UsageFault
+  Mode:              Thread
+  Core:              0
+  Timestamp:         0x00012C40
+  Build ID:          0fb407ef00112233445566778899aabbccddeeff
+  Fault:             UsageFault - Divide by 0
+
+   - PC:             0x08001A3E
+   - MSP:            0x20007FC0
+   - PSP:            0x20003F20
+
+  Exception stacked state context:
+   - R0:             0x20000400
+   - R1:             0x00000000
+   - R2:             0x00000000
+   - R3:             0x00000000
+   - R12:            0x00000000
+   - LR:             0x08001A05
+   - ReturnAddress:  0x08001A3E
+   - xPSR:           0x01000000
+
+  Fault registers:
+   - CFSR:           0x02000000
+   - HFSR:           0x00000000
+   - DFSR:           0x00000000
+   - MMFAR:          0x00000000
+   - BFAR:           0x00000000
+   - AFSR:           0x00000000
+"""
+
+SELFTEST_DUAL_CORE_JSON = """
+[{"version_major":0,"version_minor":1,"secure":false,"hang":false,"near_miss":false,"exception":5,"state_context_valid":true,"R0":536871937,"R1":0,"R2":0,"R3":0,"R12":0,"LR":134226937,"ReturnAddress":134226960,"xPSR":16777216,"EXC_xPSR":5,"EXC_RETURN":4294967293,"MSP":536903616,"PSP":536882976,"CFSR":33280,"HFSR":0,"DFSR":0,"MMFAR":1073877016,"BFAR":1073877016,"AFSR":0,"core_id":1,"timestamp":67536,"build_id":"0fb407ef00112233445566778899aabbccddeeff","faults":["CFSR.PRECISERR","CFSR.BFARVALID"]},
+ {"version_major":0,"version_minor":1,"secure":false,"hang":false,"near_miss":false,"exception":6,"state_context_valid":true,"R0":536871936,"R1":0,"R2":0,"R3":0,"R12":0,"LR":134224389,"ReturnAddress":134224446,"xPSR":16777216,"EXC_xPSR":6,"EXC_RETURN":4294967293,"MSP":536903616,"PSP":536887072,"CFSR":33554432,"HFSR":0,"DFSR":0,"MMFAR":0,"BFAR":0,"AFSR":0,"core_id":0,"timestamp":76864,"build_id":"0fb407ef00112233445566778899aabbccddeeff","faults":["CFSR.DIVBYZERO"]}]
+"""
+
+SELFTEST_DUAL_CORE = [
+    {'exception': 5, 'cfsr': 0x00008200, 'hfsr': 0, 'pc': 0x08002410, 'lr': 0x080023F9, 'addr': 0x40021018,
+     'build': '0fb407ef00112233445566778899aabbccddeeff'},
+    {'exception': 6, 'cfsr': 0x02000000, 'hfsr': 0, 'pc': 0x08001A3E, 'lr': 0x08001A05, 'addr': 0,
+     'build': '0fb407ef00112233445566778899aabbccddeeff'}]
+
+# Armv8-M Secure record (JSON and CBOR)
+SELFTEST_SECURE_JSON = """
+[{"version_major":0,"version_minor":1,"secure":true,"hang":false,"near_miss":false,"exception":5,"state_context_valid":true,"R0":537391104,"R1":0,"R2":0,"R3":0,"R12":0,"LR":268438667,"ReturnAddress":268440116,"xPSR":16777216,"EXC_xPSR":5,"EXC_RETURN":4294967293,"MSP":805339056,"PSP":805322336,"CFSR":33280,"HFSR":0,"DFSR":0,"MMFAR":0,"BFAR":537391104,"AFSR":0,"IntegritySignature":0,"R4":0,"R5":0,"R6":0,"R7":0,"R8":0,"R9":0,"R10":0,"R11":0,"MSPLIM":805335040,"PSPLIM":805318656,"SFSR":0,"SFAR":0,"build_id":"4d0c1e5a00000000111111112222222233333333","faults":["CFSR.PRECISERR","CFSR.BFARVALID"]}]
+"""
+
+SELFTEST_SECURE_CBOR = bytes.fromhex(
+    '9fbf0000010102f503f404f4050506f5071a2007f000080009000a000b000c1a10000c8b0d1a100012340e1a01000000'
+    '0f05101afffffffd111a30007fb0121a30003e60131982001400181800181900181a1a2007f000181b00181c00181d00'
+    '181e00181f0018200018210018220018230018240018251a3000700018261a30003000182700182800182b7828346430'
+    '63316535613030303030303030313131313131313132323232323232323333333333333333159f0a0fffffff')
+
+SELFTEST_SECURE = [
+    {'exception': 5, 'cfsr': 0x00008200, 'hfsr': 0, 'pc': 0x10001234, 'lr': 0x10000C8B, 'addr': 0x2007F000,
+     'build': '4d0c1e5a00000000111111112222222233333333'}]
+
+# Armv8.1-M print, JSON and CBOR output with FP/MVE context, PACBTI UsageFault and RAS error
+# (decoding only; the capture by the fault entries is tested by the ext_context and armv81m
+# tests of Test/run_tests.py)
+SELFTEST_ARMV81M_LOG = """
+--- Last recorded Fault information (v0.1) ---
+
+  Exception Handler: Non-Secure - UsageFault
+  State:             Non-Secure
+  Mode:              Thread
+  Fault:             UsageFault - Execution of Thumb instruction with Thumb mode turned off
+  PACBTI:            Branch target identification failure (indirect branch to an instruction that is not a BTI landing pad)
+  Fault:             RAS error - unrecoverable error (UET), syndrome 0x0001
+
+   - PC:             0x10003C80
+   - MSP:            0x20000FC0
+   - MSPLIM:         0x20000800
+   - PSP:            0x20010E48
+   - PSPLIM:         0x20010000
+   - CONTROL:        0x00000056
+
+  Exception stacked state context:
+   - R0:             0x20010F00
+   - R1:             0x00000040
+   - R2:             0x00000000
+   - R3:             0x00000000
+   - R12:            0x00000000
+   - LR:             0x10002A3D
+   - ReturnAddress:  0x10003C80
+   - xPSR:           0x01200000
+
+  Floating-point context:
+   - Q0:             0x3F8300003F8200003F8100003F800000
+   - Q1:             0x3F8700003F8600003F8500003F840000
+   - Q2:             0x3F8B00003F8A00003F8900003F880000
+   - Q3:             0x3F8F00003F8E00003F8D00003F8C0000
+   - Q4:             0x3F9300003F9200003F9100003F900000
+   - Q5:             0x3F9700003F9600003F9500003F940000
+   - Q6:             0x3F9B00003F9A00003F9900003F980000
+   - Q7:             0x3F9F00003F9E00003F9D00003F9C0000
+   - FPSCR:          0x03000000
+   - VPR:            0x000F00FF
+
+  Fault registers:
+   - CFSR:           0x00020000
+   - HFSR:           0x00000000
+   - DFSR:           0x00000000
+   - MMFAR:          0x00000000
+   - BFAR:           0x00000000
+   - AFSR:           0x00000000
+   - RFSR:           0x80010011
+"""
+
+SELFTEST_ARMV81M_JSON = """
+[{"version_major":0,"version_minor":1,"secure":false,"hang":false,"near_miss":false,"exception":6,"state_context_valid":true,"R0":536940288,"R1":64,"R2":0,"R3":0,"R12":0,"LR":268446269,"ReturnAddress":268450944,"xPSR":18874368,"EXC_xPSR":6,"EXC_RETURN":4294967212,"MSP":536874944,"PSP":536940104,"CFSR":131072,"HFSR":0,"DFSR":0,"MMFAR":0,"BFAR":0,"AFSR":0,"IntegritySignature":0,"R4":0,"R5":0,"R6":0,"R7":0,"R8":0,"R9":0,"R10":0,"R11":0,"MSPLIM":536872960,"PSPLIM":536936448,"SFSR":0,"SFAR":0,"CONTROL":86,"RFSR":2147549201,"ext_context":1,
+ "S0":1065353216,"S1":1065418752,"S2":1065484288,"S3":1065549824,"S4":1065615360,"S5":1065680896,"S6":1065746432,"S7":1065811968,"S8":1065877504,"S9":1065943040,"S10":1066008576,"S11":1066074112,"S12":1066139648,"S13":1066205184,"S14":1066270720,"S15":1066336256,"S16":1066401792,"S17":1066467328,"S18":1066532864,"S19":1066598400,"S20":1066663936,"S21":1066729472,"S22":1066795008,"S23":1066860544,"S24":1066926080,"S25":1066991616,"S26":1067057152,"S27":1067122688,"S28":1067188224,"S29":1067253760,"S30":1067319296,"S31":1067384832,"FPSCR":50331648,"VPR":983295,
+ "faults":["CFSR.INVSTATE","RFSR.V"]}]
+"""
+
+SELFTEST_ARMV81M_CBOR = bytes.fromhex(
+    '9fbf0000010102f403f404f4050606f5071a20010f0008184009000a000b000c1a10002a3d0d1a10003c800e1a012000'
+    '000f06101affffffac111a20000fc0121a20010e48131a000200001400181800181900181a00181b00181c00181d0018'
+    '1e00181f0018200018210018220018230018240018251a2000080018261a2001000018270018280018291856182a1a80'
+    '010011183901183a1a3f800000183b1a3f810000183c1a3f820000183d1a3f830000183e1a3f840000183f1a3f850000'
+    '18401a3f86000018411a3f87000018421a3f88000018431a3f89000018441a3f8a000018451a3f8b000018461a3f8c00'
+    '0018471a3f8d000018481a3f8e000018491a3f8f0000184a1a3f900000184b1a3f910000184c1a3f920000184d1a3f93'
+    '0000184e1a3f940000184f1a3f95000018501a3f96000018511a3f97000018521a3f98000018531a3f99000018541a3f'
+    '9a000018551a3f9b000018561a3f9c000018571a3f9d000018581a3f9e000018591a3f9f0000185a1a03000000185b1a'
+    '000f00ff159f11181fffffff')
+
+SELFTEST_ARMV81M = [
+    {'exception': 6, 'cfsr': 0x00020000, 'hfsr': 0, 'pc': 0x10003C80, 'lr': 0x10002A3D, 'addr': 0, 'build': ''}]
+
+# (file name, content, decoded records)
+SELFTEST_INPUTS = [
+    ('dual_core.log', SELFTEST_DUAL_CORE_LOG, SELFTEST_DUAL_CORE),
+    ('dual_core.json', SELFTEST_DUAL_CORE_JSON, SELFTEST_DUAL_CORE),
+    ('secure.json', SELFTEST_SECURE_JSON, SELFTEST_SECURE),
+    ('secure.cbor', SELFTEST_SECURE_CBOR, SELFTEST_SECURE),
+    ('armv81m.log', SELFTEST_ARMV81M_LOG, SELFTEST_ARMV81M),
+    ('armv81m.json', SELFTEST_ARMV81M_JSON, SELFTEST_ARMV81M),
+    ('armv81m.cbor', SELFTEST_ARMV81M_CBOR, SELFTEST_ARMV81M)]
+
+# (query arguments, matching rows of the records appended in SELFTEST_INPUTS order)
+SELFTEST_QUERIES = [
+    (['--exception', 'BusFault'], [0, 2, 4, 5]),
+    (['--pc', '0x08001A3E'], [1, 3]),
+    (['--exception', 'UsageFault'], [1, 3, 6, 7, 8]),
+    (['--lr', '0x10002A3D', '--cfsr-bit', 'INVSTATE'], [6, 7, 8]),
+    (['--addr', '0x40021018'], [0, 2]),
+    (['--cfsr-bit', 'DIVBYZERO'], [1, 3]),
+    (['--cfsr-bit', 'PRECISERR', '--cfsr-bit', 'BFARVALID'], [0, 2, 4, 5]),
+    (['--hfsr-bit', 'FORCED'], []),
+    (['--build', '0fb407ef'], [0, 1, 2, 3]),
+    (['--device', 'dual_core.json', '--exception', 'UsageFault'], [3]),
+    (['--addr', '0x2007F000', '--build', '4d0c1e5a'], [4, 5]),
+    (['--device', 'secure.cbor', '--cfsr-bit', 'BFARVALID'], [5]),
+    (['--since', SELFTEST_TIME], [0, 1, 2, 3, 4, 5, 6, 7, 8]),
+    (['--until', '2026-10-17'], [])]
+
+
+def cmd_selftest(args):
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        db = FaultDB(os.path.join(tmp, 'db'))
+        for name, content, expected in SELFTEST_INPUTS:
+            path = os.path.join(tmp, name)
+            with open(path, 'wb') as f:
+                f.write(content if isinstance(content, bytes) else content.encode('ascii'))
+            records = list(read_records(path))
+            ok = records == expected
+            failed += not ok
+            print('Decode %-28s %u records %s' % (name, len(records), 'ok' if ok else 'FAILED'))
+            for rec in records:
+                rec['device'] = name
+                rec['time'] = parse_time(SELFTEST_TIME)
+            db.append(records)
+        # CBOR and JSON encodings of the same records decode to the same maps (all fields)
+        maps = {name: decode_cbor(content) if isinstance(content, bytes) else json.loads(content)
+                for name, content, _ in SELFTEST_INPUTS if not name.endswith('.log')}
+        for name in (name for name in maps if name.endswith('.cbor')):
+            ok = maps[name] == maps[name[:-len('.cbor')] + '.json']
+            failed += not ok
+            print('Fields %-28s %u keys %s' % (name, sum(len(rec) for rec in maps[name]), 'ok' if ok else 'FAILED'))
+        for argv, expected in SELFTEST_QUERIES:
+            rows = list(make_query(db, make_parser().parse_args(['query'] + argv)).rows())
+            ok = rows == expected
+            failed += not ok
+            print('Query  %-28s rows %s %s' % (' '.join(argv), rows, 'ok' if ok else 'FAILED'))
+    print('Selftest %s' % ('passed' if failed == 0 else 'FAILED'))
+    return 0 if failed == 0 else 1
+
+
+def make_parser():
+    parser = argparse.ArgumentParser(description='Fault Recorder fault record database.')
+    parser.add_argument('--db', default=os.environ.get('FR_DB', 'faultdb'), help='database directory')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('add', help='append records from FaultRecordEncodeJSON/CBOR outputs or FaultRecordPrint logs')
+    p.add_argument('files', nargs='+')
+    p.add_argument('--device', help='device ID (default: name of the directory of each file)')
+    p.add_argument('--time', help='record time (default: modification time of each file)')
+    p = sub.add_parser('query', help='query records (all given conditions must match)')
+    p.add_argument('--exception', action='append', help='exception name or number')
+    p.add_argument('--pc', action='append', help='return address')
+    p.add_argument('--lr', action='append', help='link register')
+    p.add_argument('--addr', action='append', help='fault address (BFAR/MMFAR if valid)')
+    p.add_argument('--build', action='append', help='build ID (prefix)')
+    p.add_argument('--device', action='append', help='device ID (prefix)')
+    p.add_argument('--since', help='earliest time (YYYY-MM-DD[THH:MM[:SS]] or seconds)')
+    p.add_argument('--until', help='latest time')
+    p.add_argument('--cfsr-bit', action='append', help='CFSR bit set, for example PRECISERR')
+    p.add_argument('--hfsr-bit', action='append', help='HFSR bit set, for example FORCED')
+    p.add_argument('--group-by', choices=COLUMNS, help='count matching records per value of a column')
+    p.add_argument('--count', action='store_true', help='only count matching records')
+    p.add_argument('--limit', type=int, default=0, help='maximum number of rows or groups shown')
+    sub.add_parser('stats', help='show database statistics')
+    sub.add_parser('selftest', help='decode reference outputs into a temporary database and check queries')
+    return parser
+
+
+def main():
+    args = make_parser().parse_args()
+    if args.cmd == 'selftest':
+        return cmd_selftest(args)
+    db = FaultDB(args.db)
+    return {'add': cmd_add, 'query': cmd_query, 'stats': cmd_stats}[args.cmd](db, args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
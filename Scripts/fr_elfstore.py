@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - firmware ELF store indexed by build ID
+#
+# Keeps firmware ELF files in a directory tree keyed by their build ID (GNU
+# build-id note, or a linker provided image hash read from the ELF file), so
+# the ELF that produced a fault record (FR_BUILD_ID_SYMBOL) is found with a
+# single directory lookup, also for records holding a truncated build ID
+# (FR_BUILD_ID_LEN).
+#
+# Store layout: <store>/<first 8 hex digits>/<build ID>.elf and an
+# append-only <store>/index.tsv (build ID, added time, original file).
+#
+# Usage:
+#   fr_elfstore.py --store DIR add app.elf [more.elf ...]
+#   fr_elfstore.py --store DIR add --hash-symbol __image_hash --hash-len 32 app.elf
+#   fr_elfstore.py --store DIR lookup 00112233445566778899aabbccddeeff01234567
+#   fr_elfstore.py --store DIR list
+#   fr_elfstore.py --store DIR resolve fault1.log fault2.json fault3.cbor ...
+# -----------------------------------------------------------------------------
+
+import argparse
+import os
+import shutil
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fr_profile import ElfSymbols      # noqa: E402
+from fr_records import read_maps        # noqa: E402
+
+KEY_LEN = 8                             # hex digits of the build ID used as directory key
+NT_GNU_BUILD_ID = 3
+
+
+def elf_sections(data):
+    if len(data) < 0x34 or data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+        raise ValueError('not a 32-bit little-endian ELF file')
+    e_shoff, = struct.unpack_from('<I', data, 0x20)
+    e_shentsize, e_shnum = struct.unpack_from('<HH', data, 0x2E)
+    if e_shnum != 0 and (e_shentsize < 40 or e_shoff + e_shnum * e_shentsize > len(data)):
+        raise ValueError('truncated ELF file (section headers outside the file)')
+    return [struct.unpack_from('<IIIIIIIIII', data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+
+
+def gnu_build_id(data):
+    """Return the GNU build-id note descriptor of an ELF file (or None)."""
+    for sh in elf_sections(data):
+        if sh[1] != 7:                  # SHT_NOTE
+            continue
+        ofs, end = sh[4], sh[4] + sh[5]
+        while ofs + 12 <= end:
+            namesz, descsz, ntype = struct.unpack_from('<III', data, ofs)
+            name = data[ofs + 12:ofs + 12 + namesz]
+            desc = ofs + 12 + ((namesz + 3) & ~3)
+            if ntype == NT_GNU_BUILD_ID and name == b'GNU\0':
+                return data[desc:desc + descsz]
+            ofs = desc + ((descsz + 3) & ~3)
+    return None
+
+
+def symbol_bytes(data, symbol, length):
+    """Return length bytes at the address of symbol, read from the loaded sections of an ELF file."""
+    sections = elf_sections(data)
+    addr = None
+    for sh in sections:
+        if sh[1] != 2:                  # SHT_SYMTAB
+            continue
+        strtab = sections[sh[6]]
+        for ofs in range(sh[4], sh[4] + sh[5], sh[9] or 16):
+            st_name, st_value = struct.unpack_from('<II', data, ofs)
+            end = data.index(b'\0', strtab[4] + st_name)
+            if data[strtab[4] + st_name:end].decode('ascii', 'replace') == symbol:
+                addr = st_value
+    if addr is None:
+        raise ValueError('symbol %s not found' % symbol)
+    for sh in sections:
+        if sh[1] == 1 and sh[3] <= addr and addr + length <= sh[3] + sh[5]:     # SHT_PROGBITS
+            return data[sh[4] + addr - sh[3]:sh[4] + addr - sh[3] + length]
+    raise ValueError('symbol %s is not in a section with contents' % symbol)
+
+
+class ElfStore:
+    """Firmware ELF files indexed by build ID."""
+
+    def __init__(self, path):
+        self.path = path
+        self.symbols = {}
+
+    def add(self, elf, build_id):
+        key = build_id.hex()
+        folder = os.path.join(self.path, key[:KEY_LEN])
+        dst = os.path.join(folder, key + '.elf')
+        os.makedirs(folder, exist_ok=True)
+        if not os.path.exists(dst):
+            shutil.copyfile(elf, dst + '.tmp')
+            os.replace(dst + '.tmp', dst)
+            with open(os.path.join(self.path, 'index.tsv'), 'a') as f:
+                f.write('%s\t%s\t%s\n' % (key, time.strftime('%Y-%m-%dT%H:%M:%S'), os.path.abspath(elf)))
+        return dst
+
+    def lookup(self, build_id):
+        """Return the ELF file of a (possibly truncated) build ID given as hex string, or None."""
+        build_id = build_id.lower()
+        if len(build_id) < KEY_LEN:
+            return None
+        folder = os.path.join(self.path, build_id[:KEY_LEN])
+        path = os.path.join(folder, build_id + '.elf')
+        if os.path.exists(path):
+            return path
+        if os.path.isdir(folder):
+            for name in os.listdir(folder):
+                if name.startswith(build_id) and name.endswith('.elf'):
+                    return os.path.join(folder, name)
+        return None
+
+    def symbolizer(self, build_id):
+        """Return ElfSymbols of the ELF of a build ID (cached over a batch of records), or None."""
+        if build_id not in self.symbols:
+            path = self.lookup(build_id)
+            self.symbols[build_id] = ElfSymbols(path) if path else None
+        return self.symbols[build_id]
+
+
+def read_records(path):
+    """Yield (build_id, [(name, address)]) of the fault records in a FaultRecordPrint log or JSON/CBOR output."""
+    for rec in read_maps(path):
+        addrs = [(name, rec[name]) for name in ('ReturnAddress', 'LR') if name in rec]
+        addrs += [('#%u' % i, a) for i, a in enumerate(rec.get('backtrace', []))]
+        yield rec.get('build_id'), addrs
+
+
+def cmd_add(store, args):
+    for elf in args.elf:
+        try:
+            with open(elf, 'rb') as f:
+                data = f.read()
+            if args.hash_symbol:
+                build_id = symbol_bytes(data, args.hash_symbol, args.hash_len)
+            else:
+                build_id = gnu_build_id(data)
+        except (OSError, ValueError, struct.error) as e:
+            print('%s: %s' % (elf, e if not isinstance(e, struct.error) else 'invalid ELF file'), file=sys.stderr)
+            return 1
+        if not build_id:
+            print('%s: no build ID (link with --build-id or use --hash-symbol)' % elf, file=sys.stderr)
+            return 1
+        print('%s  %s' % (build_id.hex(), store.add(elf, build_id)))
+    return 0
+
+
+def cmd_lookup(store, args):
+    path = store.lookup(args.build_id)
+    if path is None:
+        print('Build ID %s not found.' % args.build_id, file=sys.stderr)
+        return 1
+    print(path)
+    return 0
+
+
+def cmd_list(store, args):
+    index = os.path.join(store.path, 'index.tsv')
+    if os.path.exists(index):
+        with open(index) as f:
+            sys.stdout.write(f.read())
+    return 0
+
+
+def cmd_resolve(store, args):
+    rc = 0
+    for log in args.log:
+        try:
+            records = list(read_records(log))
+        except (OSError, ValueError) as e:
+            print('%s: %s' % (log, e), file=sys.stderr)
+            rc = 1
+            continue
+        for n, (build_id, addrs) in enumerate(records):
+            syms = store.symbolizer(build_id) if build_id else None
+            if syms is None:
+                rc = 1
+            print('%s [%u]: build ID %s -> %s' % (log, n, build_id or 'not recorded',
+                  store.lookup(build_id) if syms else 'no ELF'))
+            for name, addr in addrs:
+                print('   - %-15s 0x%08X  %s' % (name + ':', addr, syms.lookup(addr) if syms else ''))
+    return rc
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Firmware ELF store indexed by build ID.')
+    parser.add_argument('--store', default=os.environ.get('FR_ELF_STORE', 'elfstore'),
+                        help='store directory (default: $FR_ELF_STORE or ./elfstore)')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('add', help='add ELF files')
+    p.add_argument('elf', nargs='+')
+    p.add_argument('--hash-symbol', help='use the image hash at this symbol instead of the GNU build-id')
+    p.add_argument('--hash-len', type=int, default=32, help='image hash length in bytes')
+    p = sub.add_parser('lookup', help='print the ELF file of a build ID (may be truncated)')
+    p.add_argument('build_id')
+    sub.add_parser('list', help='list stored ELF files')
+    p = sub.add_parser('resolve', help='find the ELF of each record and symbolize its addresses')
+    p.add_argument('log', nargs='+', help='FaultRecordPrint logs or FaultRecordEncodeJSON/CBOR output')
+    args = parser.parse_args()
+    store = ElfStore(args.store)
+    return {'add': cmd_add, 'lookup': cmd_lookup, 'list': cmd_list, 'resolve': cmd_resolve}[args.cmd](store, args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
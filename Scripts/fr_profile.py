@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - PC sample profile folding
+#
+# Folds PC samples taken by FaultRecordSample into a flat profile, using the
+# function symbols of the application ELF file.
+#
+# Samples are read from the text output of FaultRecordSamplePrint (log file) or
+# from a binary memory dump of the SampleBuf variable (--bin).
+#
+# --selftest folds reference samples (FaultRecordSamplePrint output and a
+# SampleBuf dump) with a generated ELF file and checks the profile.
+#
+# Usage:
+#   fr_profile.py app.elf samples.log
+#   fr_profile.py --callers app.elf samples.log
+#   fr_profile.py --bin app.elf SampleBuf.bin
+#   fr_profile.py --selftest
+# -----------------------------------------------------------------------------
+
+import argparse
+import bisect
+import os
+import re
+import struct
+import sys
+import tempfile
+from collections import Counter
+
+SAMPLE_RE = re.compile(r'^\s*0x([0-9A-Fa-f]{8})\s+0x([0-9A-Fa-f]{8})\s*$')
+HEADER_RE = re.compile(r'^--- PC samples')
+
+
+class ElfSymbols:
+    """Function symbols of a 32-bit little-endian ELF file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            raise ValueError('%s: not a 32-bit little-endian ELF file' % path)
+        e_shoff, = struct.unpack_from('<I', data, 0x20)
+        e_shentsize, e_shnum = struct.unpack_from('<HH', data, 0x2E)
+        sections = [struct.unpack_from('<IIIIIIIIII', data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+        funcs = {}
+        for sh in sections:
+            sh_type, sh_offset, sh_size, sh_link, sh_entsize = sh[1], sh[4], sh[5], sh[6], sh[9]
+            if sh_type != 2:                # SHT_SYMTAB
+                continue
+            strtab = sections[sh_link]
+            str_ofs = strtab[4]
+            for ofs in range(sh_offset, sh_offset + sh_size, sh_entsize or 16):
+                st_name, st_value, st_size, st_info = struct.unpack_from('<IIIB', data, ofs)
+                if (st_info & 0x0F) != 2:   # STT_FUNC
+                    continue
+                end = data.index(b'\0', str_ofs + st_name)
+                name = data[str_ofs + st_name:end].decode('ascii', 'replace')
+                addr = st_value & ~1
+                # Prefer global symbols over local aliases at the same address
+                if addr not in funcs or (st_info >> 4) == 1:
+                    funcs[addr] = (name, st_size)
+        self.addrs = sorted(funcs)
+        self.funcs = [funcs[a] for a in self.addrs]
+
+    def lookup(self, addr):
+        if addr == 0:
+            return '<secure>'
+        addr &= ~1
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i >= 0:
+            name, size = self.funcs[i]
+            if (addr - self.addrs[i]) < max(size, 1):
+                return name
+        return '<unknown>'
+
+
+def read_log(path):
+    samples = []
+    in_samples = False
+    with open(path, 'r', errors='replace') as f:
+        for line in f:
+            if HEADER_RE.match(line.strip()):
+                in_samples = True
+                continue
+            m = SAMPLE_RE.match(line)
+            if in_samples and m:
+                samples.append((int(m.group(1), 16), int(m.group(2), 16)))
+    return samples
+
+
+def read_bin(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    count, = struct.unpack_from('<I', data, 0)
+    num = (len(data) - 4) // 8
+    if num == 0:
+        return []
+    pairs = [struct.unpack_from('<II', data, 4 + 8 * i) for i in range(num)]
+    if count < num:
+        return pairs[:count]
+    start = count % num
+    return pairs[start:] + pairs[:start]
+
+
+def fold(syms, samples):
+    """Samples per function, and per function the samples per caller (function of the sampled LR)."""
+    funcs = Counter()
+    callers = {}
+    for pc, lr in samples:
+        func = syms.lookup(pc)
+        funcs[func] += 1
+        callers.setdefault(func, Counter())[syms.lookup(lr)] += 1
+    return funcs, callers
+
+
+def make_elf(funcs):
+    """32-bit little-endian ELF file with a symbol table of funcs [(name, address, size, binding)]."""
+    strtab = b'\0'
+    symtab = bytes(16)                  # STN_UNDEF
+    funcs = sorted(funcs, key=lambda func: func[3])     # local symbols first
+    for name, addr, size, bind in funcs:
+        symtab += struct.pack('<IIIBBH', len(strtab), addr, size, (bind << 4) | 2, 0, 1)
+        strtab += name.encode('ascii') + b'\0'
+    sym_ofs = 52
+    str_ofs = sym_ofs + len(symtab)
+    sh_ofs = (str_ofs + len(strtab) + 3) & ~3
+    header = b'\x7fELF\x01\x01\x01' + bytes(9)
+    header += struct.pack('<HHIIIIIHHHHHH', 2, 40, 1, 0, 0, sh_ofs, 0x05000000, 52, 0, 0, 40, 3, 0)
+    sections = bytes(40)
+    locals_num = 1 + sum(1 for func in funcs if func[3] == 0)
+    sections += struct.pack('<10I', 0, 2, 0, 0, sym_ofs, len(symtab), 2, locals_num, 4, 16)    # SHT_SYMTAB
+    sections += struct.pack('<10I', 0, 3, 0, 0, str_ofs, len(strtab), 0, 0, 1, 0)             # SHT_STRTAB
+    return (header + symtab + strtab).ljust(sh_ofs, b'\0') + sections
+
+
+# Reference samples for --selftest: FaultRecordSamplePrint output and SampleBuf dump of a host
+# build of FaultRecorder.c (FR_SAMPLE_NUM = 8, 11 samples taken, so the oldest 3 are overwritten)
+SELFTEST_FUNCS = [('main', 0x08000400, 0x40, 1), ('Worker_Thread', 0x08000440, 0x80, 1),
+                  ('memcpy_local', 0x08000500, 0x20, 0), ('memcpy', 0x08000500, 0x20, 1)]
+
+SELFTEST_LOG = """
+--- PC samples (8 of 11) ---
+
+  0x08000450 0x08000415
+  0x08000460 0x08000415
+  0x08000508 0x08000471
+  0x0800050C 0x08000471
+  0x08000510 0x08000417
+  0x08000470 0x08000415
+  0x00000000 0x00000000
+  0x08000600 0x08000415
+
+"""
+
+SELFTEST_BIN = ('0b000000700400081504000800000000000000000006000815040008500400081504000860'
+                '0400081504000808050008710400080c050008710400081005000817040008')
+
+SELFTEST_SAMPLES = [(0x08000450, 0x08000415), (0x08000460, 0x08000415), (0x08000508, 0x08000471),
+                    (0x0800050C, 0x08000471), (0x08000510, 0x08000417), (0x08000470, 0x08000415),
+                    (0x00000000, 0x00000000), (0x08000600, 0x08000415)]
+
+SELFTEST_PROFILE = {'Worker_Thread': 3, 'memcpy': 3, '<secure>': 1, '<unknown>': 1}
+
+SELFTEST_CALLERS = {'Worker_Thread': {'main': 3}, 'memcpy': {'Worker_Thread': 2, 'main': 1},
+                    '<secure>': {'<secure>': 1}, '<unknown>': {'main': 1}}
+
+
+def selftest():
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        elf = os.path.join(tmp, 'app.elf')
+        with open(elf, 'wb') as f:
+            f.write(make_elf(SELFTEST_FUNCS))
+        syms = ElfSymbols(elf)
+        for name, data, reader in (('samples.log', SELFTEST_LOG.encode('ascii'), read_log),
+                                   ('SampleBuf.bin', bytes.fromhex(SELFTEST_BIN), read_bin)):
+            path = os.path.join(tmp, name)
+            with open(path, 'wb') as f:
+                f.write(data)
+            samples = reader(path)
+            funcs, callers = fold(syms, samples)
+            ok = samples == SELFTEST_SAMPLES and funcs == SELFTEST_PROFILE and callers == SELFTEST_CALLERS
+            failed += not ok
+            print('%-14s %u samples, %u functions %s' % (name, len(samples), len(funcs), 'ok' if ok else 'FAILED'))
+    print('Selftest %s' % ('passed' if failed == 0 else 'FAILED'))
+    return 0 if failed == 0 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Fold Fault Recorder PC samples into a flat profile.')
+    parser.add_argument('elf', nargs='?', help='application ELF file')
+    parser.add_argument('samples', nargs='?', help='log with FaultRecordSamplePrint output, or SampleBuf dump (--bin)')
+    parser.add_argument('--bin', action='store_true', help='samples file is a binary dump of SampleBuf')
+    parser.add_argument('--callers', action='store_true', help='show callers (from sampled LR) of each function')
+    parser.add_argument('--top', type=int, default=0, help='show only the top N functions')
+    parser.add_argument('--selftest', action='store_true', help='fold reference samples and check the profile')
+    args = parser.parse_args()
+    if args.selftest:
+        return selftest()
+    if args.samples is None:
+        parser.error('the following arguments are required: elf, samples')
+
+    syms = ElfSymbols(args.elf)
+    samples = read_bin(args.samples) if args.bin else read_log(args.samples)
+    if not samples:
+        print('No samples found.')
+        return 1
+
+    funcs, callers = fold(syms, samples)
+    total = len(samples)
+    print('Samples: %u' % total)
+    print('')
+    print('     %   Samples  Function')
+    for i, (func, num) in enumerate(funcs.most_common()):
+        if args.top and i >= args.top:
+            break
+        print('%6.2f%% %9u  %s' % (100.0 * num / total, num, func))
+        if args.callers:
+            for caller, cnum in callers[func].most_common():
+                print('%17s    <- %s (%u)' % ('', caller, cnum))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
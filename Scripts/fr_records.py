@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - structured output decoder
+#
+# Reads fault records from FaultRecordEncodeCBOR or FaultRecordEncodeJSON
+# output or FaultRecordPrint logs into the maps of FaultRecordEncodeJSON
+# output (shared by fr_db.py and fr_elfstore.py). CBOR map keys and fault
+# flags are small integer IDs; KEYS and FLAGS map them to the JSON names
+# (same order and values as the FR_KEY_* defines, FieldDesc and FlagDesc in
+# FaultRecorder.c). IDs are never reused: new keys and flags are appended.
+# Maps read from logs hold the printed registers, exception, build_id,
+# backtrace and near_miss.
+#
+# Usage (as module):
+#   from fr_records import read_maps
+#   records = read_maps('record.cbor')
+# Usage (command line, prints the records as JSON):
+#   fr_records.py record.cbor
+#   fr_records.py fault.log
+# -----------------------------------------------------------------------------
+
+import json
+import re
+import sys
+
+EXCEPTIONS = {'HardFault': 3, 'MemManage': 4, 'BusFault': 5, 'UsageFault': 6, 'SecureFault': 7}
+
+# Key ID -> JSON key
+KEYS = (['version_major', 'version_minor', 'secure', 'hang', 'near_miss', 'exception', 'state_context_valid',
+         'R0', 'R1', 'R2', 'R3', 'R12', 'LR', 'ReturnAddress', 'xPSR',
+         'EXC_xPSR', 'EXC_RETURN', 'MSP', 'PSP', 'CFSR', 'HFSR', 'faults', 'core_id', 'timestamp',
+         'DFSR', 'MMFAR', 'BFAR', 'AFSR',
+         'IntegritySignature', 'R4', 'R5', 'R6', 'R7', 'R8', 'R9', 'R10', 'R11', 'MSPLIM', 'PSPLIM',
+         'SFSR', 'SFAR', 'CONTROL', 'RFSR', 'build_id',
+         'near_miss_stack', 'near_miss_limit', 'near_miss_headroom', 'near_miss_event',
+         'backtrace_sp', 'backtrace', 'stacks', 'base', 'size', 'unused', 'exit_actions', 'status', 'elapsed',
+         'ext_context'] +
+        ['S%u' % i for i in range(32)] + ['FPSCR', 'VPR'])
+
+# Flag ID -> JSON fault flag
+FLAGS = ['HFSR.VECTTBL', 'HFSR.FORCED', 'HFSR.DEBUGEVT',
+         'CFSR.IACCVIOL', 'CFSR.DACCVIOL', 'CFSR.MUNSTKERR', 'CFSR.MSTKERR', 'CFSR.MLSPERR', 'CFSR.MMARVALID',
+         'CFSR.IBUSERR', 'CFSR.PRECISERR', 'CFSR.IMPRECISERR', 'CFSR.UNSTKERR', 'CFSR.STKERR', 'CFSR.LSPERR',
+         'CFSR.BFARVALID', 'CFSR.UNDEFINSTR', 'CFSR.INVSTATE', 'CFSR.INVPC', 'CFSR.NOCP', 'CFSR.STKOF',
+         'CFSR.UNALIGNED', 'CFSR.DIVBYZERO',
+         'SFSR.INVEP', 'SFSR.INVIS', 'SFSR.INVER', 'SFSR.AUVIOL', 'SFSR.INVTRAN', 'SFSR.LSPERR', 'SFSR.SFARVALID',
+         'SFSR.LSERR', 'RFSR.V']
+
+
+def cbor_decode(data, pos=0):
+    """Decode the CBOR data item at pos (types written by FaultRecordEncodeCBOR), return (value, next pos)."""
+    if pos >= len(data):
+        raise ValueError('truncated CBOR data')
+    major, info = data[pos] >> 5, data[pos] & 0x1F
+    pos += 1
+    if major == 7:
+        if info not in (20, 21, 22):
+            raise ValueError('unsupported CBOR simple value %u' % info)
+        return (False, True, None)[info - 20], pos
+    if info < 24:
+        val = info
+    elif info <= 27:
+        num = 1 << (info - 24)
+        if pos + num > len(data):
+            raise ValueError('truncated CBOR data')
+        val = int.from_bytes(data[pos:pos + num], 'big')
+        pos += num
+    elif info == 31 and major in (4, 5):
+        val = None                      # indefinite length, terminated by break
+    else:
+        raise ValueError('unsupported CBOR additional information %u' % info)
+    if major == 0:
+        return val, pos
+    if major == 1:
+        return -1 - val, pos
+    if major in (2, 3):
+        if pos + val > len(data):
+            raise ValueError('truncated CBOR data')
+        raw = bytes(data[pos:pos + val])
+        return (raw.decode('utf-8') if major == 3 else raw), pos + val
+    if major not in (4, 5):
+        raise ValueError('unsupported CBOR major type %u' % major)
+    items = []
+    while val is None or len(items) < val * (major - 3):
+        if val is None and pos < len(data) and data[pos] == 0xFF:
+            pos += 1
+            break
+        item, pos = cbor_decode(data, pos)
+        items.append(item)
+    return (items if major == 4 else dict(zip(items[0::2], items[1::2]))), pos
+
+
+def name_keys(value):
+    """Replace key IDs of a decoded CBOR map (and of the maps it holds) and fault flag IDs by their JSON names."""
+    if isinstance(value, list):
+        return [name_keys(item) for item in value]
+    if not isinstance(value, dict):
+        return value
+    named = {}
+    for key, val in value.items():
+        name = KEYS[key] if isinstance(key, int) and key < len(KEYS) else key
+        if name == 'faults':
+            val = [FLAGS[flag] if isinstance(flag, int) and flag < len(FLAGS) else flag for flag in val]
+        named[name] = name_keys(val)
+    return named
+
+
+def decode_cbor(data):
+    """Decode FaultRecordEncodeCBOR output into a list of maps with the FaultRecordEncodeJSON keys."""
+    value, pos = cbor_decode(data)
+    if not isinstance(value, list):
+        raise ValueError('CBOR data is not an array of records')
+    return name_keys(value)
+
+
+def parse_log(text):
+    """Return the maps of the records (fault information and stack near-miss) in a FaultRecordPrint log."""
+    parts = re.split(r'^--- (Last recorded Fault information|Recorded stack near-miss).*$',
+                     text.replace('\r\n', '\n'), flags=re.M)
+    records = []
+    for header, part in zip(parts[1::2], parts[2::2]):
+        part = re.split(r'^--- ', part, flags=re.M)[0]
+        rec = {'near_miss': header.startswith('Recorded')}
+        m = re.search(r'^\s*Exception Handler:\s+(?:Secure - |Non-Secure - )?(.*)$', part, re.M)
+        if m:
+            n = re.search(r'exception number = (\d+)', m.group(1))
+            rec['exception'] = int(n.group(1)) if n else EXCEPTIONS.get(m.group(1).split()[0], 0)
+        for m in re.finditer(r'^\s*- (\w+):\s+0x([0-9A-Fa-f]{8})\s*$', part, re.M):
+            if m.group(1) in KEYS:
+                rec.setdefault(m.group(1), int(m.group(2), 16))
+        m = re.search(r'^\s*Build ID:\s+([0-9a-fA-F]+)', part, re.M)
+        if m:
+            rec['build_id'] = m.group(1).lower()
+        backtrace = [int(m.group(1), 16) for m in re.finditer(r'^\s*- #\d+\s+0x([0-9A-Fa-f]{8})', part, re.M)]
+        if backtrace:
+            rec['backtrace'] = backtrace
+        records.append(rec)
+    return records
+
+
+def read_maps(path):
+    """Return the record maps of a FaultRecordEncodeCBOR/FaultRecordEncodeJSON output or FaultRecordPrint log."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:1] == b'\x9f':              # CBOR indefinite length array
+        return decode_cbor(data)
+    text = data.decode('utf-8', 'replace')
+    if text.lstrip().startswith('['):
+        return json.loads(text)
+    return parse_log(text)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('usage: fr_records.py record.cbor|record.json|record.log', file=sys.stderr)
+        return 2
+    try:
+        records = read_maps(sys.argv[1])
+    except (OSError, ValueError) as e:
+        print('%s: %s' % (sys.argv[1], e), file=sys.stderr)
+        return 1
+    print(json.dumps(records, indent=1))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
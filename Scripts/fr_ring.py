@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - print ring buffer reader
+#
+# Reads the output written by FaultRecordRingWrite/FaultRecordRingPrintf
+# (FR_PRINT with FR_PRINT_RING_SIZE defined) from target memory.
+#
+# The control block is located by its identification string, either in a
+# binary memory dump (--base is the address of the first byte of the dump) or
+# through a GDB remote protocol server (for example QEMU's gdbstub or a debug
+# probe GDB server). Over GDB the read position is written back to the target,
+# which frees the space for new output (drop mode).
+#
+# Usage:
+#   fr_ring.py dump ram.bin
+#   fr_ring.py dump --all ram.bin
+#   fr_ring.py gdb --scan 0x20000000:0x10000 localhost:1234
+#   fr_ring.py gdb --addr 0x20000400 --poll 0.5 localhost:1234
+# -----------------------------------------------------------------------------
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+RING_ID = b'FR RING BUFFER\0'
+HDR_FMT = '<16sIIIII'                   # id, size, flags, wr, rd, dropped
+HDR_LEN = struct.calcsize(HDR_FMT)
+OFS_RD = 28                             # offset of rd in the control block
+FLAG_OVERWRITE = 1
+
+
+class Ring:
+    """Print ring buffer control block."""
+
+    def __init__(self, hdr):
+        rid, self.size, self.flags, self.wr, self.rd, self.dropped = struct.unpack_from(HDR_FMT, hdr)
+        if (rid[:len(RING_ID)] != RING_ID or self.size == 0 or (self.size & (self.size - 1)) != 0 or
+                (self.flags & ~FLAG_OVERWRITE) != 0):
+            raise ValueError('invalid ring buffer control block')
+
+    def span(self, start):
+        """Return (start, lost) of the readable data beginning at start (free running count)."""
+        lost = 0
+        if ((self.wr - start) & 0xFFFFFFFF) > self.size:
+            new = (self.wr - self.size) & 0xFFFFFFFF
+            lost = (new - start) & 0xFFFFFFFF
+            start = new
+        return start, lost
+
+    def extract(self, buf, start):
+        """Extract data between start and wr from the ring data buf."""
+        num = (self.wr - start) & 0xFFFFFFFF
+        ofs = start & (self.size - 1)
+        data = buf[ofs:ofs + num]
+        return data + buf[:num - len(data)]
+
+
+def find_ring(data, with_buffer=True):
+    """Return (offset, Ring) of the first valid control block in data, or (-1, None).
+
+    The identification string also occurs as literal in the code or constant data, so
+    every 4-byte aligned match is tried until one has a valid control block (followed by
+    its data buffer, if with_buffer is set)."""
+    pos = data.find(RING_ID)
+    while pos >= 0:
+        if pos % 4 == 0:
+            try:
+                ring = Ring(data[pos:pos + HDR_LEN])
+            except (ValueError, struct.error):
+                ring = None
+            if ring is not None and (not with_buffer or pos + HDR_LEN + ring.size <= len(data)):
+                return pos, ring
+        pos = data.find(RING_ID, pos + 1)
+    return -1, None
+
+
+def cmd_dump(args):
+    with open(args.file, 'rb') as f:
+        data = f.read()
+    pos, ring = find_ring(data)
+    if pos < 0:
+        print('Ring buffer not found.', file=sys.stderr)
+        return 1
+    buf = data[pos + HDR_LEN:pos + HDR_LEN + ring.size]
+    start = ring.rd
+    if args.all or (ring.flags & FLAG_OVERWRITE):
+        start = (ring.wr - min(ring.wr, ring.size)) & 0xFFFFFFFF
+    start, lost = ring.span(start)
+    print('Ring buffer at 0x%08X: size %u, written %u, dropped %u, overwritten %u'
+          % (args.base + pos, ring.size, ring.wr, ring.dropped, lost), file=sys.stderr)
+    sys.stdout.write(ring.extract(buf, start).decode('ascii', 'replace'))
+    return 0
+
+
+class GdbRemote:
+    """Minimal GDB remote serial protocol client (memory access only)."""
+
+    def __init__(self, target):
+        host, port = target.rsplit(':', 1)
+        self.sock = socket.create_connection((host or 'localhost', int(port)))
+        self.rx = b''
+        self.running = False
+        self.command('?')
+
+    def _recv(self):
+        while True:
+            start = self.rx.find(b'$')
+            end = self.rx.find(b'#', start)
+            if start >= 0 and end >= 0 and len(self.rx) >= end + 3:
+                pkt = self.rx[start + 1:end]
+                self.rx = self.rx[end + 3:]
+                self.sock.sendall(b'+')
+                return pkt.decode('ascii')
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError('connection closed')
+            self.rx += chunk
+
+    def _send(self, pkt):
+        csum = sum(pkt.encode('ascii')) & 0xFF
+        self.sock.sendall(b'$%s#%02x' % (pkt.encode('ascii'), csum))
+
+    def command(self, pkt):
+        self._send(pkt)
+        return self._recv()
+
+    def halt(self):
+        if self.running:
+            self.sock.sendall(b'\x03')
+            self._recv()
+            self.running = False
+
+    def resume(self):
+        self._send('c')
+        self.running = True
+
+    def read(self, addr, size):
+        data = b''
+        while len(data) < size:
+            num = min(size - len(data), 1024)
+            reply = self.command('m%x,%x' % (addr + len(data), num))
+            if not reply or reply.startswith('E'):
+                raise IOError('cannot read memory at 0x%08X' % (addr + len(data)))
+            data += bytes.fromhex(reply)
+        return data
+
+    def write(self, addr, data):
+        reply = self.command('M%x,%x:%s' % (addr, len(data), data.hex()))
+        if reply != 'OK':
+            raise IOError('cannot write memory at 0x%08X' % addr)
+
+    def close(self):
+        self.halt()
+        self.command('D')
+        self.sock.close()
+
+
+def cmd_gdb(args):
+    gdb = GdbRemote(args.target)
+    try:
+        addr = args.addr
+        if addr is None:
+            base, size = (int(v, 0) for v in args.scan.split(':'))
+            pos, _ = find_ring(gdb.read(base, size), with_buffer=False)
+            if pos < 0:
+                print('Ring buffer not found.', file=sys.stderr)
+                return 1
+            addr = base + pos
+        while True:
+            gdb.halt()
+            ring = Ring(gdb.read(addr, HDR_LEN))
+            start, lost = ring.span(ring.rd)
+            if lost:
+                sys.stdout.write('\n[%u bytes overwritten]\n' % lost)
+            if ring.wr != start:
+                buf = gdb.read(addr + HDR_LEN, ring.size)
+                sys.stdout.write(ring.extract(buf, start).decode('ascii', 'replace'))
+                sys.stdout.flush()
+                gdb.write(addr + OFS_RD, struct.pack('<I', ring.wr))
+            if not args.poll:
+                break
+            gdb.resume()
+            time.sleep(args.poll)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        gdb.close()
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Read Fault Recorder print ring buffer output.')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('dump', help='read from a binary memory dump')
+    p.add_argument('file', help='binary memory dump containing the ring buffer')
+    p.add_argument('--base', type=lambda v: int(v, 0), default=0, help='address of the first byte of the dump')
+    p.add_argument('--all', action='store_true', help='show all buffered output, not only unread output')
+    p = sub.add_parser('gdb', help='read through a GDB remote protocol server')
+    p.add_argument('target', help='host:port of the GDB server')
+    g = p.add_mutually_exclusive_group(required=True)
+    g.add_argument('--addr', type=lambda v: int(v, 0), help='address of the ring buffer control block')
+    g.add_argument('--scan', help='address:size of the memory range searched for the control block')
+    p.add_argument('--poll', type=float, default=0.0, help='poll interval in seconds (0 = read once)')
+    args = parser.parse_args()
+    return cmd_dump(args) if args.cmd == 'dump' else cmd_gdb(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
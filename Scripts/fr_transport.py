@@ -0,0 +1,375 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - chunked record transport receiver
+#
+# Receives the chunk packets built by FaultRecordTransportNext, answers with
+# selective acknowledgements (processed by FaultRecordTransportAck) and writes
+# the reassembled data (manifest and regions) when the transfer is complete.
+#
+# Packets are read from stdin and acknowledgements written to stdout, each
+# framed by a 16-bit little-endian length, so the receiver can be connected to
+# any link (radio gateway, serial bridge, pipe). With --state the received
+# chunks are kept in a file, so the receiver can also be restarted.
+#
+# The loopback command runs a sender against the receiver over pipes, with
+# packet loss and sender resets injected, and checks the received data and
+# regions. The sender is a reference implementation of the protocol in Python
+# or, with --sender, FaultRecordTransportStart/Next/Ack of FaultRecorder.c
+# built for the host (Test/transport_sender.c, see Test/run_tests.py).
+#
+# Usage:
+#   fr_transport.py receive -o record.bin [--state rx.state] [--split prefix]
+#   fr_transport.py loopback [--loss 0.3] [--resets 3] [--mtu 32] [--input data.bin]
+#   fr_transport.py loopback --sender build/transport_sender [--loss 0.3] [--resets 3] [--mtu 32]
+# -----------------------------------------------------------------------------
+
+import argparse
+import json
+import os
+import random
+import select
+import struct
+import subprocess
+import sys
+import tempfile
+
+CRC32_INIT = 0xFFFFFFFF
+CRC32_POLY = 0x04C11DB7
+MAGIC = 0x54746C46                      # "FltT"
+TYPE_CHUNK = 0x43                       # "C"
+TYPE_ACK = 0x41                         # "A"
+HDR_LEN = 12
+OVERHEAD = HDR_LEN + 4
+REGION_NAMES = {1: 'FaultInfo', 2: 'FaultNested', 3: 'FaultHistory', 4: 'StackNearMiss'}
+
+
+def crc32(data, crc=CRC32_INIT):
+    """CRC-32 as calculated by FaultRecorder.c (MSB first, no final XOR)."""
+    for byte in data:
+        crc ^= byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ CRC32_POLY) if (crc & 0x80000000) else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def read_frame(f):
+    hdr = f.read(2)
+    if len(hdr) < 2:
+        return None
+    size, = struct.unpack('<H', hdr)
+    return f.read(size)
+
+
+def write_frame(f, pkt):
+    f.write(struct.pack('<H', len(pkt)) + pkt)
+    f.flush()
+
+
+def parse_manifest(data):
+    """Return list of (id, offset, length) of the regions in the transferred data."""
+    magic, num = struct.unpack_from('<II', data, 0)
+    if magic != MAGIC:
+        raise ValueError('invalid manifest')
+    regions = []
+    ofs = 8 + 8 * num
+    for i in range(num):
+        rid, length = struct.unpack_from('<II', data, 8 + 8 * i)
+        regions.append((rid, ofs, length))
+        ofs += length
+    return regions
+
+
+def region_name(rid):
+    return REGION_NAMES.get(rid, 'Attachment%u' % (rid - 0x10))
+
+
+class Receiver:
+    """Reassembles chunks of one session and builds selective acknowledgements."""
+
+    def __init__(self, state_file=None):
+        self.state_file = state_file
+        self.session = None
+        self.complete = False
+        if state_file and os.path.exists(state_file):
+            with open(state_file) as f:
+                st = json.load(f)
+            self._new(st['session'], st['total'], st['chunk_size'])
+            self.data = bytearray.fromhex(st['data'])
+            self.received = set(st['received'])
+
+    def _new(self, session, total, chunk_size):
+        self.session = session
+        self.total = total
+        self.chunk_size = chunk_size
+        self.chunk_num = (total + chunk_size - 1) // chunk_size
+        self.data = bytearray(total)
+        self.received = set()
+        self.complete = False
+
+    def _save(self):
+        if self.state_file:
+            with open(self.state_file, 'w') as f:
+                json.dump({'session': self.session, 'total': self.total, 'chunk_size': self.chunk_size,
+                           'data': self.data.hex(), 'received': sorted(self.received)}, f)
+
+    def ack(self):
+        base = 0
+        while base in self.received:
+            base += 1
+        bitmap = 0
+        for n in range(32):
+            if (base + n) in self.received:
+                bitmap |= 1 << n
+        pkt = struct.pack('<BBHII', TYPE_ACK, 0, base, self.session, bitmap)
+        return pkt + struct.pack('<I', crc32(pkt))
+
+    def chunk(self, pkt):
+        """Process chunk packet; return acknowledgement or None if packet is invalid."""
+        if len(pkt) <= OVERHEAD or pkt[0] != TYPE_CHUNK:
+            return None
+        if struct.unpack_from('<I', pkt, len(pkt) - 4)[0] != crc32(pkt[:-4]):
+            return None
+        chunk_size, seq, session, total = struct.unpack_from('<BHII', pkt, 1)
+        if session != self.session or total != self.total or chunk_size != self.chunk_size:
+            self._new(session, total, chunk_size)
+        ofs = seq * chunk_size
+        payload = pkt[HDR_LEN:-4]
+        if ofs + len(payload) > total or len(payload) != min(chunk_size, total - ofs):
+            return None
+        if seq not in self.received:
+            self.data[ofs:ofs + len(payload)] = payload
+            self.received.add(seq)
+            if len(self.received) == self.chunk_num:
+                self.complete = crc32(self.data) == self.session
+                if not self.complete:
+                    # Data changed during transfer: start over
+                    self.received.clear()
+            self._save()
+        return self.ack()
+
+
+def cmd_receive(args):
+    rx = Receiver(args.state)
+    fin = sys.stdin.buffer
+    fout = sys.stdout.buffer
+    done = None
+    while True:
+        pkt = read_frame(fin)
+        if pkt is None:
+            break
+        ack = rx.chunk(pkt)
+        if ack is None:
+            continue
+        write_frame(fout, ack)
+        if rx.complete and done != rx.session:
+            done = rx.session
+            with open(args.output, 'wb') as f:
+                f.write(rx.data)
+            print('Received session 0x%08X: %u bytes in %u chunks'
+                  % (rx.session, rx.total, rx.chunk_num), file=sys.stderr)
+            for rid, ofs, length in parse_manifest(rx.data):
+                print('  %-14s %6u bytes at offset %u' % (region_name(rid), length, ofs), file=sys.stderr)
+                if args.split:
+                    with open('%s_%s.bin' % (args.split, region_name(rid)), 'wb') as f:
+                        f.write(rx.data[ofs:ofs + length])
+    return 0 if done is not None else 1
+
+
+class Sender:
+    """Reference sender (same algorithm as FaultRecordTransportNext/Ack)."""
+
+    def __init__(self, data, mtu, window, state):
+        self.data = data
+        self.chunk_size = mtu - OVERHEAD
+        self.window = window
+        self.chunk_num = (len(data) + self.chunk_size - 1) // self.chunk_size
+        self.session = crc32(data)
+        self.st = state                 # survives resets, like TransportState
+        if self.st.get('session') != self.session or self.st.get('chunk_size') != self.chunk_size:
+            self.st.update(session=self.session, chunk_size=self.chunk_size, base=0, acked=0)
+        self.next = self.st['base']
+
+    def remaining(self):
+        num = self.chunk_num - self.st['base']
+        return num - sum(1 for i in range(1, min(32, num)) if self.st['acked'] & (1 << i))
+
+    def build(self):
+        base, acked = self.st['base'], self.st['acked']
+        if base >= self.chunk_num:
+            return None
+        end = min(base + self.window, self.chunk_num)
+        seq = self.next
+        for _ in range(self.window):
+            if seq < base or seq >= end:
+                seq = base
+            if not acked & (1 << (seq - base)):
+                break
+            seq += 1
+        self.next = seq + 1
+        ofs = seq * self.chunk_size
+        pkt = struct.pack('<BBHII', TYPE_CHUNK, self.chunk_size, seq, self.session, len(self.data))
+        pkt += self.data[ofs:ofs + self.chunk_size]
+        return pkt + struct.pack('<I', crc32(pkt))
+
+    def process_ack(self, pkt):
+        if len(pkt) != 16 or pkt[0] != TYPE_ACK or struct.unpack_from('<I', pkt, 12)[0] != crc32(pkt[:12]):
+            return
+        _, _, base, session, bitmap = struct.unpack_from('<BBHII', pkt)
+        if session != self.session or base > self.chunk_num:
+            return
+        if base > self.st['base']:
+            shift = base - self.st['base']
+            self.st['acked'] = self.st['acked'] >> shift if shift < 32 else 0
+            self.st['base'] = base
+        else:
+            shift = self.st['base'] - base
+            bitmap = bitmap >> shift if shift < 32 else 0
+        self.st['acked'] |= bitmap
+        while self.st['acked'] & 1:
+            self.st['acked'] >>= 1
+            self.st['base'] += 1
+        self.st['base'] = min(self.st['base'], self.chunk_num)
+
+
+class CSender:
+    """Sender process running FaultRecordTransportStart/Next/Ack of a host build of FaultRecorder.c
+    (Test/transport_sender.c); the transport state is kept in a file over sender resets."""
+
+    def __init__(self, exe, state_file, data_file, mtu):
+        self.proc = subprocess.Popen([exe, state_file, data_file, str(mtu)],
+                                     stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.left, self.chunk_num = struct.unpack('<ii', self._request(b'R'))
+
+    def _request(self, req):
+        write_frame(self.proc.stdin, req)
+        rsp = read_frame(self.proc.stdout)
+        if not rsp:
+            raise RuntimeError('sender %s terminated' % self.proc.args[0])
+        return rsp
+
+    def remaining(self):
+        return self.left
+
+    def build(self):
+        rsp = self._request(b'N')
+        return rsp[4:] or None
+
+    def process_ack(self, pkt):
+        write_frame(self.proc.stdin, pkt)
+        self.left = struct.unpack('<ii', self._request(b'R'))[0]
+
+    def close(self):
+        self.proc.stdin.close()
+        self.proc.stdout.close()
+        self.proc.wait()
+
+
+def make_test_data(size):
+    regions = [(1, os.urandom(size)), (2, os.urandom(20)), (0x10, os.urandom(size // 2))]
+    manifest = struct.pack('<II', MAGIC, len(regions))
+    for rid, data in regions:
+        manifest += struct.pack('<II', rid, len(data))
+    return manifest + b''.join(data for _, data in regions)
+
+
+def loopback(args, tmp):
+    rnd = random.Random(args.seed)
+    output = args.output or os.path.join(tmp, 'loopback_rx.bin')
+    if os.path.exists(output):
+        os.remove(output)
+    split = os.path.join(tmp, 'rx')
+    if args.sender:
+        data_file = os.path.join(tmp, 'sent.bin')
+        state_file = os.path.join(tmp, 'tx.state')
+        new_sender = lambda: CSender(os.path.abspath(args.sender), state_file, data_file, args.mtu)
+    else:
+        if args.input:
+            with open(args.input, 'rb') as f:
+                data = f.read()
+        else:
+            data = make_test_data(args.size)
+        state = {}
+        new_sender = lambda: Sender(data, args.mtu, args.window, state)
+    rx = subprocess.Popen([sys.executable, os.path.abspath(__file__), 'receive', '-o', output, '--split', split],
+                          stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    sender = new_sender()
+    if args.sender:
+        with open(data_file, 'rb') as f:
+            data = f.read()
+    reset_points = sorted(rnd.sample(range(1, max(2, sender.chunk_num)), min(args.resets, sender.chunk_num - 1)))
+    sent = lost = acks = 0
+    limit = 10 * sender.chunk_num + 100    # transfer that does not complete (received data invalid)
+    try:
+        while sender.remaining() > 0 and sent < limit:
+            if reset_points and (sender.chunk_num - sender.remaining()) >= reset_points[0]:
+                reset_points.pop(0)
+                if args.sender:
+                    sender.close()
+                sender = new_sender()
+                print('Sender reset, resuming with %u of %u chunks to send' % (sender.remaining(), sender.chunk_num))
+            pkt = sender.build()
+            if pkt is None:
+                break
+            sent += 1
+            if rnd.random() < args.loss:
+                lost += 1
+            else:
+                write_frame(rx.stdin, pkt)
+            while select.select([rx.stdout], [], [], 0.002)[0]:
+                ack = read_frame(rx.stdout)
+                if ack is None:
+                    break
+                if rnd.random() < args.loss:
+                    continue
+                acks += 1
+                sender.process_ack(ack)
+    finally:
+        if args.sender:
+            sender.close()
+        rx.stdin.close()
+        rx.stdout.read()
+        rx.stdout.close()
+        rx.wait()
+    ok = os.path.exists(output) and sender.remaining() == 0
+    if ok:
+        with open(output, 'rb') as f:
+            ok = f.read() == data
+    if ok:
+        for rid, ofs, length in parse_manifest(data):
+            with open('%s_%s.bin' % (split, region_name(rid)), 'rb') as f:
+                ok = ok and f.read() == data[ofs:ofs + length]
+    print('Chunks: %u, packets sent: %u (%u lost, %.1f%% overhead), acknowledgements processed: %u'
+          % (sender.chunk_num, sent, lost, 100.0 * (sent - sender.chunk_num) / sender.chunk_num, acks))
+    print('Loopback %s' % ('passed' if ok else 'FAILED'))
+    return 0 if ok else 1
+
+
+def cmd_loopback(args):
+    with tempfile.TemporaryDirectory() as tmp:
+        return loopback(args, tmp)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Fault Recorder chunked record transport receiver.')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('receive', help='receive framed chunk packets from stdin, write acknowledgements to stdout')
+    p.add_argument('-o', '--output', required=True, help='file for the received data')
+    p.add_argument('--state', help='file keeping the received chunks (receiver restart)')
+    p.add_argument('--split', help='also write each region to <prefix>_<region>.bin')
+    p = sub.add_parser('loopback', help='run a sender against the receiver with packet loss')
+    p.add_argument('--sender', help='sender program (Test/transport_sender.c build, default: reference sender)')
+    p.add_argument('--input', help='data to transfer by the reference sender (default: random test record)')
+    p.add_argument('--output', help='file for the received data (default: temporary file)')
+    p.add_argument('--size', type=int, default=400, help='size of the random test record region')
+    p.add_argument('--mtu', type=int, default=32, help='packet size in bytes')
+    p.add_argument('--window', type=int, default=8, help='chunks in flight of the reference sender (FR_TRANSPORT_WINDOW)')
+    p.add_argument('--loss', type=float, default=0.3, help='packet loss probability (both directions)')
+    p.add_argument('--resets', type=int, default=2, help='number of sender resets during the transfer')
+    p.add_argument('--seed', type=int, default=None, help='random seed')
+    args = parser.parse_args()
+    return cmd_receive(args) if args.cmd == 'receive' else cmd_loopback(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
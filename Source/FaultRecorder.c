@@ -26,15 +26,142 @@
 #include "RTE_Components.h"
 #include  CMSIS_device_header
 
+#include <stdarg.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 // Overridable macros
+#ifndef FR_PRINT_RING_SIZE
+#define FR_PRINT_RING_SIZE              (0U)    // Print ring buffer size in bytes (power of 2, 0 = ring buffer disabled)
+#endif
+#if   ((FR_PRINT_RING_SIZE & (FR_PRINT_RING_SIZE - 1U)) != 0U)
+#error "FR_PRINT_RING_SIZE must be a power of 2!"
+#endif
+#ifndef FR_PRINT_RING_OVERWRITE
+#define FR_PRINT_RING_OVERWRITE         (1)     // Print ring buffer full: 0 = drop new output (needs a host reader), 1 = overwrite oldest output
+#endif
+#ifndef FR_PRINT_RING_LINE
+#define FR_PRINT_RING_LINE              (128U)  // Maximum length of output formatted by FaultRecordRingPrintf
+#endif
 #ifndef FR_PRINT
+#if   (FR_PRINT_RING_SIZE != 0U)
+#define FR_PRINT(...)                   (void)FaultRecordRingPrintf(__VA_ARGS__)
+#else
 //lint -esym(586, printf) "Suppress: function 'printf' is deprecated [MISRA 2012 Rule 21.6, required]"
 #define FR_PRINT(...)                   printf(__VA_ARGS__)
 #endif
+#endif
+#ifndef FR_CORE_NUM
+#define FR_CORE_NUM                     (1U)    // Number of cores with own fault information slot
+#endif
+#if    (FR_CORE_NUM > 1U)
+#ifndef FR_CORE_ID_ADDR
+#error "FR_CORE_ID_ADDR (address of register containing the core ID) must be defined when FR_CORE_NUM > 1!"
+#endif
+#ifndef FR_CORE_ID_POS
+#define FR_CORE_ID_POS                  (0U)    // Bit position of the core ID in the core ID register
+#endif
+#ifndef FR_CORE_ID_MSK
+#define FR_CORE_ID_MSK                  (0xFFU) // Mask of the core ID (after shifting by FR_CORE_ID_POS)
+#endif
+#endif
+// FR_TIMESTAMP_ADDR: address of a free running counter register (optional), read into the fault
+//                    information upon recording (use a counter shared by all cores on multi-core devices)
+// FR_BUILD_ID_SYMBOL: linker symbol at the firmware build ID (optional), for example at the start of the GNU
+//                     build-id note (linker option --build-id) or at a linker provided image hash, the build
+//                     ID is recorded into the fault information
+#ifdef FR_BUILD_ID_SYMBOL
+#ifndef FR_BUILD_ID_OFS
+#define FR_BUILD_ID_OFS                 (16U)   // Offset of the build ID from FR_BUILD_ID_SYMBOL (16 = GNU note header)
+#endif
+#ifndef FR_BUILD_ID_LEN
+#define FR_BUILD_ID_LEN                 (20U)   // Recorded build ID length in bytes (multiple of 4, 20 = SHA-1 build-id)
+#endif
+#if   ((FR_BUILD_ID_LEN == 0U) || ((FR_BUILD_ID_LEN % 4U) != 0U) || ((FR_BUILD_ID_OFS % 4U) != 0U))
+#error "FR_BUILD_ID_LEN must be a non-zero multiple of 4 and FR_BUILD_ID_OFS a multiple of 4!"
+#endif
+#endif
+#ifndef FR_HISTORY_SIZE
+#define FR_HISTORY_SIZE                 (0U)    // Compressed fault history data size in bytes (0 = history disabled)
+#endif
+#ifndef FR_HISTORY_KEYFRAME_INTERVAL
+#define FR_HISTORY_KEYFRAME_INTERVAL    (8U)    // Fault history keyframe interval (every n-th entry is a keyframe)
+#endif
+#ifndef FR_BACKTRACE_DEPTH
+#define FR_BACKTRACE_DEPTH              (0U)    // Maximum number of recorded backtrace candidates (0 = backtrace disabled)
+#endif
+#if    (FR_BACKTRACE_DEPTH != 0U)
+#ifndef FR_BACKTRACE_SCAN_WORDS
+#define FR_BACKTRACE_SCAN_WORDS         (256U)  // Maximum number of stack words scanned for backtrace candidates
+#endif
+#if   (!defined(FR_BACKTRACE_TEXT_START) || !defined(FR_BACKTRACE_TEXT_END))
+#error "FR_BACKTRACE_TEXT_START and FR_BACKTRACE_TEXT_END (code address range) must be defined when FR_BACKTRACE_DEPTH > 0!"
+#endif
+#endif
+// FR_BACKTRACE_TEXT2_START, FR_BACKTRACE_TEXT2_END: second code address range (optional)
+// FR_BACKTRACE_STACK_END: address above which the stack is not scanned (optional, for example end of RAM)
+#ifndef FR_STACK_NUM
+#define FR_STACK_NUM                    (0U)    // Maximum number of stacks with measured usage (0 = stack usage disabled)
+#endif
+#ifndef FR_STACK_SCAN_WORDS
+#define FR_STACK_SCAN_WORDS             (1024U) // Maximum number of words scanned per stack upon recording
+#endif
+#ifndef FR_STACK_PAINT_PATTERN
+#define FR_STACK_PAINT_PATTERN          (0xCCCCCCCCU) // Stack paint pattern (same as used by CMSIS-RTOS2 RTX)
+#endif
+#if    (FR_STACK_NUM > 255U)
+#error "FR_STACK_NUM must not exceed 255!"
+#endif
+#ifndef FR_STACK_MONITOR_HEADROOM
+#define FR_STACK_MONITOR_HEADROOM       (0U)    // Stack monitor: headroom in bytes below which a near-miss is recorded (0 = stack monitor disabled)
+#endif
+#ifndef FR_SAMPLE_NUM
+#define FR_SAMPLE_NUM                   (0U)    // Number of PC samples in the sampling ring buffer (0 = sampling disabled)
+#endif
+#if   ((FR_SAMPLE_NUM & (FR_SAMPLE_NUM - 1U)) != 0U)
+#error "FR_SAMPLE_NUM must be a power of 2!"
+#endif
+#ifndef FR_EXIT_ACTION_NUM
+#define FR_EXIT_ACTION_NUM              (0U)    // Maximum number of exit actions executed before reset (0 = exit actions disabled)
+#endif
+#if    (FR_EXIT_ACTION_NUM != 0U)
+#ifndef FR_TIMESTAMP_ADDR
+#error "FR_TIMESTAMP_ADDR (counter used for exit action budgets) must be defined when FR_EXIT_ACTION_NUM > 0!"
+#endif
+#ifndef FR_EXIT_DEADLINE
+#error "FR_EXIT_DEADLINE (maximum time from recording to reset, in FR_TIMESTAMP_ADDR counter ticks) must be defined when FR_EXIT_ACTION_NUM > 0!"
+#endif
+#endif
+#ifndef FR_RESET_LOOP_LIMIT
+#define FR_RESET_LOOP_LIMIT             (3U)    // Number of consecutive fault resets reported as reset loop by FaultRecordCheck
+#endif
+// FR_RESET_LOOP_WINDOW: time window in FR_TIMESTAMP_ADDR counter ticks (optional, counter must keep running
+//                       across resets), faults further apart than the window are not counted as consecutive
+#if    (defined(FR_RESET_LOOP_WINDOW) && !defined(FR_TIMESTAMP_ADDR))
+#error "FR_TIMESTAMP_ADDR must be defined when FR_RESET_LOOP_WINDOW is defined!"
+#endif
+#ifndef FR_TRANSPORT_WINDOW
+#define FR_TRANSPORT_WINDOW             (0U)    // Transport: max number of unacknowledged chunks in flight (max 32, 0 = transport disabled)
+#endif
+#if    (FR_TRANSPORT_WINDOW > 32U)
+#error "FR_TRANSPORT_WINDOW must not exceed 32!"
+#endif
+#ifndef FR_TRANSPORT_ATTACH_NUM
+#define FR_TRANSPORT_ATTACH_NUM         (0U)    // Transport: maximum number of attachments (snapshots) sent with the record
+#endif
+#ifndef FR_EMERGENCY_STACK_SIZE
+#define FR_EMERGENCY_STACK_SIZE         (0U)    // Emergency stack size in bytes, per core (0 = emergency stack disabled)
+#endif
+#if   ((FR_EMERGENCY_STACK_SIZE % 8U) != 0U)
+#error "FR_EMERGENCY_STACK_SIZE must be a multiple of 8!"
+#endif
+#ifndef FR_NS_ACCESS
+#define FR_NS_ACCESS                    (0)     // Non-secure callable functions accessing the record (1 = enabled, Secure image only)
+#endif
+#ifndef FR_EXT_CONTEXT
+#define FR_EXT_CONTEXT                  (0)     // Extended (floating-point/MVE) context recording (1 = enabled, devices with FPU or MVE only)
+#endif
 
 // Compiler-specific defines
 #if !defined(__NAKED)
@@ -103,6 +230,28 @@
 #define FR_ARCH_ARMV8x_M_MAIN  (0)
 #endif
 
+// Determine if architecture is Armv8.1-M Mainline architecture
+#if    (defined(__ARM_ARCH_8_1M_MAIN__) && (__ARM_ARCH_8_1M_MAIN__ != 0))
+#define FR_ARCH_ARMV8_1_M_MAIN (1)
+#else
+#define FR_ARCH_ARMV8_1_M_MAIN (0)
+#endif
+
+// Determine if M-profile Vector Extension (MVE) is used
+#if    (defined(__MVE_USED) && (__MVE_USED != 0U))
+#define FR_MVE_EXIST           (1)
+#else
+#define FR_MVE_EXIST           (0)
+#endif
+
+// Determine if extended (floating-point/MVE) context is recorded
+#if   ((FR_EXT_CONTEXT != 0) && (FR_FAULT_REGS_EXIST != 0) && \
+       ((defined(__FPU_USED) && (__FPU_USED != 0U)) || (FR_MVE_EXIST != 0)))
+#define FR_EXT_CONTEXT_EXIST   (1)
+#else
+#define FR_EXT_CONTEXT_EXIST   (0)
+#endif
+
 // Determine if the code is compiled for Secure World
 #if    (defined (__ARM_FEATURE_CMSE) && (__ARM_FEATURE_CMSE == 3))
 #define FR_SECURE              (1)
@@ -110,6 +259,55 @@
 #define FR_SECURE              (0)
 #endif
 
+// Determine if Non-secure callable functions are provided
+#if   ((FR_SECURE != 0) && (FR_NS_ACCESS != 0))
+#define FR_NS_ACCESS_EXIST     (1)
+#else
+#define FR_NS_ACCESS_EXIST     (0)
+#endif
+
+// Determine if record information (core ID, timestamp) is recorded
+#if    ((FR_CORE_NUM > 1U) || defined(FR_TIMESTAMP_ADDR))
+#define FR_RECORD_INFO_EXIST   (1)
+#else
+#define FR_RECORD_INFO_EXIST   (0)
+#endif
+
+// Determine if build ID is recorded
+#ifdef  FR_BUILD_ID_SYMBOL
+#define FR_BUILD_ID_EXIST      (1)
+#else
+#define FR_BUILD_ID_EXIST      (0)
+#endif
+
+// Determine if backtrace is recorded
+#if    (FR_BACKTRACE_DEPTH != 0U)
+#define FR_BACKTRACE_EXIST     (1)
+#else
+#define FR_BACKTRACE_EXIST     (0)
+#endif
+
+// Determine if stack usage is recorded
+#if    (FR_STACK_NUM != 0U)
+#define FR_STACK_USAGE_EXIST   (1)
+#else
+#define FR_STACK_USAGE_EXIST   (0)
+#endif
+
+// Determine if stack monitor (near-miss recording) exists
+#if    (FR_STACK_MONITOR_HEADROOM != 0U)
+#define FR_STACK_MONITOR_EXIST (1)
+#else
+#define FR_STACK_MONITOR_EXIST (0)
+#endif
+
+// Determine if exit actions are executed and their results recorded
+#if    (FR_EXIT_ACTION_NUM != 0U)
+#define FR_EXIT_ACTIONS_EXIST  (1)
+#else
+#define FR_EXIT_ACTIONS_EXIST  (0)
+#endif
+
 #if    (FR_FAULT_REGS_EXIST != 0)
 // Define CFSR mask for detecting state context stacking failure
 #ifndef SCB_CFSR_Stack_Err_Msk
@@ -147,30 +345,165 @@
 #ifndef SAU_SFSR_INVEP_Msk
 #define SAU_SFSR_INVEP_Msk     (1UL)                    // SAU SFSR: INVEP Mask
 #endif
+#endif
 
+// Armv8/8.1-M architecture related defines
+#if    (FR_ARCH_ARMV8x_M != 0)
 #define FR_ASC_INTEGRITY_SIG   (0xFEFA125AU)            // Additional State Context Integrity Signature
 #endif
 
+// Armv8.1-M Mainline architecture related defines
+#if    (FR_ARCH_ARMV8_1_M_MAIN != 0)
+#ifndef CONTROL_UPAC_EN_Msk
+#define CONTROL_UPAC_EN_Msk    (1UL << 7)               // CONTROL: UPAC_EN Mask (unprivileged pointer authentication)
+#endif
+#ifndef CONTROL_PAC_EN_Msk
+#define CONTROL_PAC_EN_Msk     (1UL << 6)               // CONTROL: PAC_EN Mask (privileged pointer authentication)
+#endif
+#ifndef CONTROL_UBTI_EN_Msk
+#define CONTROL_UBTI_EN_Msk    (1UL << 5)               // CONTROL: UBTI_EN Mask (unprivileged branch target identification)
+#endif
+#ifndef CONTROL_BTI_EN_Msk
+#define CONTROL_BTI_EN_Msk     (1UL << 4)               // CONTROL: BTI_EN Mask (privileged branch target identification)
+#endif
+#ifndef CONTROL_nPRIV_Msk
+#define CONTROL_nPRIV_Msk      (1UL)                    // CONTROL: nPRIV Mask
+#endif
+#ifndef xPSR_B_Msk
+#define xPSR_B_Msk             (1UL << 21)              // xPSR: B Mask (branch target identification active)
+#endif
+#endif
+
 // Fault Recorder definitions
 #define FR_FAULT_INFO_VER_MAJOR (0U)                    // Fault Recorder FaultInfo type version.major
-#define FR_FAULT_INFO_VER_MINOR (1U)                    // Fault Recorder FaultInfo type version.minor
+#define FR_FAULT_INFO_VER_MINOR (2U)                    // Fault Recorder FaultInfo type version.minor
 #define FR_FAULT_INFO_TYPE     (FR_FAULT_INFO_VER_MINOR /* Fault Recorder FaultInfo type */ \
                              | (FR_FAULT_INFO_VER_MAJOR <<  8) \
                              | (FR_FAULT_REGS_EXIST     << 16) \
                              | (FR_ARCH_ARMV8x_M        << 17) \
-                             | (FR_SECURE               << 18) )
+                             | (FR_SECURE               << 18) \
+                             | (FR_RECORD_INFO_EXIST    << FR_FAULT_INFO_TYPE_RECORD_INFO_POS) \
+                             | (FR_BACKTRACE_EXIST      << 20) \
+                             | (FR_STACK_USAGE_EXIST    << 21) \
+                             | (FR_EXIT_ACTIONS_EXIST   << 23) \
+                             | (FR_BUILD_ID_EXIST       << 24) \
+                             | (FR_EXT_CONTEXT_EXIST    << FR_FAULT_INFO_TYPE_EXT_CONTEXT_POS) \
+                             | (FR_ARCH_ARMV8_1_M_MAIN  << 26) \
+                             | (FR_STACK_MONITOR_EXIST  << 27) )
+#define FR_FAULT_INFO_TYPE_RECORD_INFO_POS (19U)        // Fault Recorder FaultInfo type: record information bit position
+#define FR_FAULT_INFO_TYPE_HANG_POS (22U)               // Fault Recorder FaultInfo type: hang bit position
+#define FR_FAULT_INFO_TYPE_EXT_CONTEXT_POS (25U)        // Fault Recorder FaultInfo type: extended context bit position
+#define FR_FAULT_INFO_TYPE_NEAR_MISS_POS (28U)          // Fault Recorder FaultInfo type: stack near-miss bit position
 #define FR_MAGIC_NUMBER        (0x52746C46U)            // Fault Recorder Magic number (ASCII "FltR")
+#define FR_MAGIC_NUMBER_BUSY   (0x42746C46U)            // Fault Recorder Magic number while recording (ASCII "FltB")
+#define FR_MAGIC_NUMBER_NESTED (0x4E746C46U)            // Fault Recorder Magic number of nested fault (ASCII "FltN")
+#define FR_MAGIC_NUMBER_SEEN   (0x53746C46U)            // Fault Recorder Magic number after FaultRecordCheck (ASCII "FltS")
+#define FR_MAGIC_NUMBER_ABORT  (0x41746C46U)            // Fault Recorder Magic number of interrupted recording after FaultRecordCheck (ASCII "FltA")
+#define FR_FAULT_INFO_COMPLETE(fi) (((fi)->magic_number == FR_MAGIC_NUMBER) || /* Recording completed */ \
+                                    ((fi)->magic_number == FR_MAGIC_NUMBER_SEEN))
 #define FR_CRC32_INIT_VAL      (0xFFFFFFFFU)            // Fault Recorder CRC-32 initial value
-#define FR_CRC32_DATA_PTR      (&FaultInfo.type)        // Fault Recorder CRC-32 data start
-#define FR_CRC32_DATA_LEN      (sizeof(FaultInfo) -     /* Fault Recorder CRC-32 data length */ \
-                               (sizeof(FaultInfo.magic_number) + sizeof(FaultInfo.crc32)))
+#define FR_CRC32_DATA_PTR(fi) ((const uint8_t *)&(fi)->type) // Fault Recorder CRC-32 data start
+#if    (FR_EXIT_ACTIONS_EXIST != 0)                 // Exit action results are written after recording
+#define FR_CRC32_DATA_LEN      (offsetof(FaultInfo_Type, exit_actions) - /* Fault Recorder CRC-32 data length */ \
+                               (2U * sizeof(uint32_t)))
+#else
+#define FR_CRC32_DATA_LEN      (sizeof(FaultInfo_Type) - /* Fault Recorder CRC-32 data length */ \
+                               (2U * sizeof(uint32_t)))
+#endif
 #define FR_CRC32_POLYNOM       (0x04C11DB7U)            // Fault Recorder CRC-32 polynom
 
+#ifdef FR_TIMESTAMP_ADDR
+#define FR_TIMESTAMP_VALUE()   (*(volatile const uint32_t *)(FR_TIMESTAMP_ADDR)) // Timestamp counter value
+#endif
+
+// Fault recording stages (stored in FaultInfo.crc32 while recording is in progress),
+// values are kept when stages are added (new stages get the next free value)
+#define FR_STAGE_ENTRY         (1U)                     // Slot determination, clearing, record information
+#define FR_STAGE_CONTEXT       (2U)                     // Copying of the stacked state context
+#define FR_STAGE_REGISTERS     (3U)                     // Reading of the core and fault registers
+#define FR_STAGE_BACKTRACE     (4U)                     // Backtrace stack scan
+#define FR_STAGE_STACK_USAGE   (5U)                     // Stack usage measurement
+#define FR_STAGE_CRC           (6U)                     // CRC-32 calculation
+#define FR_STAGE_EXIT          (7U)                     // Exit actions (recording completed)
+#define FR_STAGE_EXT_CONTEXT   (8U)                     // Copying of the extended (floating-point/MVE) context
+
+// Fault entry specialization (FaultRecorderEntry.inc): exception number of the entry
+#define FR_ENTRY_ANY           (0U)                     // Any exception (FaultRecord)
+#define FR_ENTRY_HARDFAULT     (3U)                     // HardFault
+#define FR_ENTRY_MEMMANAGE     (4U)                     // MemManage fault
+#define FR_ENTRY_BUSFAULT      (5U)                     // BusFault
+#define FR_ENTRY_USAGEFAULT    (6U)                     // UsageFault
+#define FR_ENTRY_SECUREFAULT   (7U)                     // SecureFault
+
+// Add offset of the FaultInfo slot of the current core (R4 bits [30:2]) to register rd, using register rt
+#if    (FR_CORE_NUM > 1U)
+#define FR_ASM_ADD_SLOT_OFS(rd, rt)     "lsrs  " #rt ",  r4, #2\n"                 \
+                                        "lsls  " #rt ",  " #rt ", #3\n"            \
+                                        "lsrs  " #rt ",  " #rt ", #1\n"            \
+                                        "adds  " #rd ",  " #rd ", " #rt "\n"
+#else
+#define FR_ASM_ADD_SLOT_OFS(rd, rt)
+#endif
+
+// Switch MSP (and MSPLIM on Armv8/8.1-M) to the emergency stack at offset R1 in FaultStack, using register r0
+#if    (FR_ARCH_ARMV8x_M != 0)
+#define FR_ASM_SET_EMERGENCY_STACK      "ldr   r0,  =%c[FaultStack_addr]\n"        \
+                                        "adds  r1,  r1, r0\n"                      \
+                                        "msr   msplim, r1\n"                       \
+                                        "ldr   r0,  =%c[FaultStack_size]\n"        \
+                                        "adds  r0,  r0, r1\n"                      \
+                                        "msr   msp, r0\n"
+#else
+#define FR_ASM_SET_EMERGENCY_STACK      "ldr   r0,  =%c[FaultStack_addr]\n"        \
+                                        "adds  r1,  r1, r0\n"                      \
+                                        "ldr   r0,  =%c[FaultStack_size]\n"        \
+                                        "adds  r0,  r0, r1\n"                      \
+                                        "msr   msp, r0\n"
+#endif
+
+// Store recording stage into FaultInfo.crc32 of the current core, using registers r0 and r2
+#define FR_ASM_SET_STAGE(stage)         "ldr   r2,  =%c[FaultInfo_crc32_addr]\n"   \
+                                        FR_ASM_ADD_SLOT_OFS(r2, r0)                \
+                                        "movs  r0,  %[" #stage "]\n"               \
+                                        "str   r0,  [r2]\n"
+
+// Fault history definitions
+#if    (FR_HISTORY_SIZE != 0U)
+#define FR_HISTORY_TAG_KEYFRAME (0x4BU)                 // Fault history entry tag: keyframe (ASCII "K")
+#define FR_HISTORY_TAG_DELTA   (0x44U)                  // Fault history entry tag: delta    (ASCII "D")
+#define FR_HISTORY_REC_WORDS   (FR_CRC32_DATA_LEN / 4U) // Fault history record size in 32-bit words
+#define FR_HISTORY_MASK_LEN    ((FR_HISTORY_REC_WORDS + 7U) / 8U)
+#define FR_HISTORY_ENTRY_MAX   (1U + FR_HISTORY_MASK_LEN + (FR_HISTORY_REC_WORDS * 5U))
+#define FR_HISTORY_CRC32_DATA_PTR ((const uint8_t *)&FaultHistory.last_crc32[0])
+#define FR_HISTORY_CRC32_DATA_LEN (offsetof(FaultHistory_Type, data) - offsetof(FaultHistory_Type, last_crc32) + FaultHistory.length)
+#if    (FR_HISTORY_SIZE > 0xFFFFU)
+#error "FR_HISTORY_SIZE must not exceed 65535 bytes!"
+#endif
+#endif
+
 // Helper functions prototypes
+#if ((FR_EXIT_ACTIONS_EXIST != 0) || (FR_STACK_MONITOR_EXIST != 0))
+static uint32_t CoreSlot  (void);
+#endif
+#if (FR_STACK_MONITOR_EXIST != 0)
+static void     StackMonitorRecord (uint32_t exc_return,
+                                    uint32_t below,
+                                    uint32_t msp,
+                                    uint32_t msplim);
+#endif
 static uint32_t CalcCRC32 (      uint32_t init_val,
                            const uint8_t *data_ptr,
                                  uint32_t data_len,
                                  uint32_t polynom);
+#if (FR_HISTORY_SIZE != 0U)
+static uint32_t HistoryEncodeEntry (      uint8_t   tag,
+                                    const uint32_t *ref,
+                                    const uint32_t *rec,
+                                          uint8_t  *ptr_entry);
+static uint32_t HistoryDecodeEntry (const uint8_t  *ptr_entry,
+                                          uint32_t  len,
+                                          uint32_t *rec);
+#endif
 
 // Fault information structure type definition
 typedef struct {
@@ -181,7 +514,17 @@ typedef struct {
   uint16_t fault_regs    :  1;          // == 1 - contains fault registers
   uint16_t armv8m        :  1;          // == 1 - contains Armv8/8.1-M related information
   uint16_t secure        :  1;          // == 1 - recording was done running in Secure World
-  uint16_t reserved      : 13;          // Reserved (0)
+  uint16_t record_info   :  1;          // == 1 - contains record information (core ID, timestamp)
+  uint16_t backtrace     :  1;          // == 1 - contains backtrace
+  uint16_t stack_usage   :  1;          // == 1 - contains stack usage
+  uint16_t hang          :  1;          // == 1 - hang was recorded (FaultRecordHang), not a fault
+  uint16_t exit_actions  :  1;          // == 1 - contains exit action results
+  uint16_t build_id      :  1;          // == 1 - contains build ID
+  uint16_t ext_context   :  1;          // == 1 - contains extended (floating-point/MVE) context
+  uint16_t armv81m       :  1;          // == 1 - contains Armv8.1-M related information
+  uint16_t stack_monitor :  1;          // == 1 - contains stack near-miss information
+  uint16_t near_miss     :  1;          // == 1 - stack near-miss was recorded (FaultRecordStackMonitor), not a fault
+  uint16_t reserved      :  3;          // Reserved (0)
 } FaultInfoType_Type;
 
 // State context (same as Basic Stack Frame) type definition
@@ -196,6 +539,23 @@ typedef struct {
   uint32_t xPSR;                        // Program Status Register value before exception
 } StateContext_Type;
 
+#if (FR_EXT_CONTEXT_EXIST != 0)
+// Extended context state values
+#define FR_EXT_CONTEXT_NONE           (0U)      // Not stacked (or state context not valid)
+#define FR_EXT_CONTEXT_STACKED        (1U)      // S0..S15, FPSCR, VPR copied from the stack, S16..S31 read from the registers
+#define FR_EXT_CONTEXT_LAZY           (2U)      // Read from the registers (lazy state preservation was pending)
+#define FR_EXT_CONTEXT_PARTIAL        (3U)      // S0..S15, FPSCR, VPR copied from the stack, FPU access disabled (no S16..S31)
+#define FR_EXT_CONTEXT_NO_ACCESS      (4U)      // Lazy state preservation was pending, but FPU access is disabled
+
+// Extended context (floating-point/MVE registers of the interrupted code) type definition
+typedef struct {
+  uint32_t S[32];                       // S0..S31 register values before exception (Q0..Q7 with MVE)
+  uint32_t FPSCR;                       // Floating-point Status and Control Register value before exception
+  uint32_t VPR;                         // Vector Predication Status and Control Register value (MVE only, else 0)
+  uint32_t state;                       // Extended context state (FR_EXT_CONTEXT_...)
+} ExtendedContext_Type;
+#endif
+
 // Additional state context type definition (only for Armv8/8.1-M arch)
 typedef struct {
   uint32_t IntegritySignature;          // Integrity Signature
@@ -240,12 +600,75 @@ typedef struct {
   uint32_t SCB_SFAR;                    // System Control Block - Secure Fault Address Register value
 } Armv8mFaultRegisters_Type;
 
+// Additional Armv8.1-M arch specific Registers type definition
+typedef struct {
+  uint32_t CONTROL;                     // Control Register value of the faulting Security state (PACBTI enables)
+  uint32_t SCB_RFSR;                    // System Control Block - RAS Fault Status Register value (0 if not available)
+} Armv81mRegisters_Type;
+
+// Record information type definition
+typedef struct {
+  uint32_t core_id;                     // ID of the core that recorded the fault information
+  uint32_t timestamp;                   // Value of the FR_TIMESTAMP_ADDR counter upon recording
+} RecordInfo_Type;
+
+#if (FR_BACKTRACE_EXIST != 0)
+// Backtrace type definition
+typedef struct {
+  uint32_t sp;                          // Stack address where scanning started (0 = stack not scanned)
+  uint32_t count;                       // Number of candidate return addresses
+  uint32_t addr[FR_BACKTRACE_DEPTH];    // Candidate return addresses, innermost call first
+} Backtrace_Type;
+#endif
+
+#if (FR_STACK_USAGE_EXIST != 0)
+// Stack usage type definition
+typedef struct {
+  uint32_t base;                        // Stack base (lowest address), 0 = not registered
+  uint32_t size;                        // Stack size in bytes
+  uint32_t unused;                      // Number of bytes from base with intact paint pattern
+} StackUsage_Type;
+#endif
+
+#if (FR_STACK_MONITOR_EXIST != 0)
+// Stack monitor: monitored stack values
+#define FR_STACK_MONITOR_MSP          (0U)      // Main    Stack Pointer
+#define FR_STACK_MONITOR_PSP          (1U)      // Process Stack Pointer
+
+// Stack near-miss type definition (only in records written by FaultRecordStackMonitor)
+typedef struct {
+  uint32_t stack;                       // Stack whose headroom dropped below FR_STACK_MONITOR_HEADROOM (FR_STACK_MONITOR_...)
+  uint32_t limit;                       // Stack limit (lowest address) the stack pointer was compared against
+  int32_t  headroom;                    // Stack pointer - limit in bytes (negative = beyond the limit)
+  uint32_t event;                       // Number of the near-miss event since boot (1 = first)
+} StackNearMiss_Type;
+#endif
+
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+// Exit action status values
+#define FR_EXIT_ACTION_NOT_RUN        (0U)      // Not executed
+#define FR_EXIT_ACTION_RUNNING        (1U)      // Started, but did not return (reset while executing)
+#define FR_EXIT_ACTION_DONE           (2U)      // Completed within its budget
+#define FR_EXIT_ACTION_OVERRUN        (3U)      // Completed, but exceeded its budget
+#define FR_EXIT_ACTION_SKIP_FAULT     (4U)      // Skipped, fault occurred in the code range of the action
+#define FR_EXIT_ACTION_SKIP_DEADLINE  (5U)      // Skipped, budget does not fit before the deadline
+
+// Exit action result type definition
+typedef struct {
+  uint32_t status;                      // Exit action status (FR_EXIT_ACTION_...)
+  uint32_t elapsed;                     // Time taken by the action (FR_TIMESTAMP_ADDR counter ticks)
+} ExitActionResult_Type;
+#endif
+
 // Fault information type definition
 typedef struct {
   uint32_t                    magic_number;
   uint32_t                    crc32;
   FaultInfoType_Type          type;
   StateContext_Type           state_context;
+#if (FR_EXT_CONTEXT_EXIST != 0)
+  ExtendedContext_Type        extended_context; // Must directly follow state_context (see FaultRecord)
+#endif
   CommonRegisters_Type        common_registers;
 #if (FR_FAULT_REGS_EXIST != 0)
   FaultRegisters_Type         fault_registers;
@@ -257,22 +680,251 @@ typedef struct {
 #if (FR_ARCH_ARMV8x_M_MAIN != 0)
   Armv8mFaultRegisters_Type   armv8_m_fault_registers;
 #endif
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+  Armv81mRegisters_Type       armv8_1_m_registers;
+#endif
+#if (FR_RECORD_INFO_EXIST != 0)
+  RecordInfo_Type             record_info;
+#endif
+#if (FR_BUILD_ID_EXIST != 0)
+  uint8_t                     build_id[FR_BUILD_ID_LEN];
+#endif
+#if (FR_BACKTRACE_EXIST != 0)
+  Backtrace_Type              backtrace;
+#endif
+#if (FR_STACK_USAGE_EXIST != 0)
+  StackUsage_Type             stack_usage[FR_STACK_NUM];
+#endif
+#if (FR_STACK_MONITOR_EXIST != 0)
+  StackNearMiss_Type          near_miss;
+#endif
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  ExitActionResult_Type       exit_actions[FR_EXIT_ACTION_NUM]; // Not protected by CRC-32
+#endif
 } FaultInfo_Type;
 
-// Fault information (FaultInfo)
-static FaultInfo_Type         FaultInfo __NO_INIT;
+// Fault information (FaultInfo), one slot per core
+static FaultInfo_Type         FaultInfo[FR_CORE_NUM] __NO_INIT;
+
+#if (FR_BUILD_ID_EXIST != 0)
+// Firmware build ID (linker provided)
+extern const uint32_t         FR_BUILD_ID_SYMBOL[];
+#endif
+
+// Boot information type definition
+typedef struct {
+  uint32_t                    magic_number;
+  uint32_t                    boot_count;       // Number of boots (FaultRecordCheck calls) since power-on
+  uint32_t                    fault_count;      // Number of consecutive boots after a fault reset
+  uint32_t                    first_timestamp;  // Timestamp of the first fault of the consecutive faults
+  uint32_t                    check;            // Check value (inverted XOR of the fields above)
+} BootInfo_Type;
+
+// Boot information (BootInfo), survives resets
+static BootInfo_Type          BootInfo __NO_INIT;
+
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+// Emergency stack (FaultStack), one per core, used for calls made while recording
+static uint64_t               FaultStack[FR_CORE_NUM][FR_EMERGENCY_STACK_SIZE / 8U] __NO_INIT;
+#endif
+
+// Nested fault information type definition
+typedef struct {
+  uint32_t                    magic_number;
+  uint32_t                    stage;            // Recording stage reached when the nested fault occurred
+  uint32_t                    xPSR;             // Program Status Register value, in nested fault handler
+  uint32_t                    EXC_RETURN;       // Exception Return code (LR), in nested fault handler
+  uint32_t                    ReturnAddress;    // Return address from nested fault (0 = stack not valid)
+#if (FR_FAULT_REGS_EXIST != 0)
+  uint32_t                    SCB_CFSR;         // Configurable Fault Status Register value
+#endif
+} FaultNested_Type;
+
+// Nested fault information (FaultNested), one slot per core
+static FaultNested_Type       FaultNested[FR_CORE_NUM] __NO_INIT;
+
+// Recording in progress (FaultBusy), one flag per core; zero-initialized, so that the
+// busy value left in FaultInfo by a recording interrupted by reset is not taken for one
+static volatile uint32_t      FaultBusy[FR_CORE_NUM];
+
+#if (FR_STACK_USAGE_EXIST != 0)
+// Stack region type definition
+typedef struct {
+  uint32_t                    base;             // Stack base (lowest address)
+  uint32_t                    size;             // Stack size in bytes
+} StackRegion_Type;
+
+// Registered stacks (StackRegion)
+static StackRegion_Type       StackRegion[FR_STACK_NUM];
+#endif
+
+#if (FR_STACK_MONITOR_EXIST != 0)
+// Stack monitor type definition
+typedef struct {
+  uint32_t                    msp_threshold;    // MSP limit + FR_STACK_MONITOR_HEADROOM (0 = use MSPLIM or not monitored)
+  uint32_t                    psp_threshold;    // PSP limit + FR_STACK_MONITOR_HEADROOM (0 = use PSPLIM or not monitored)
+  uint32_t                    events;           // Number of near-miss events since boot
+  uint32_t                    below;            // Stacks below their threshold at the last check (bit n = FR_STACK_MONITOR_...)
+} StackMonitor_Type;
+
+// Stack monitor state (StackMonitor), one per core
+static StackMonitor_Type      StackMonitor[FR_CORE_NUM];
+
+// Stack near-miss records in FaultInfo format (StackNearMiss), first and worst event per core
+static FaultInfo_Type         StackNearMiss[FR_CORE_NUM][2] __NO_INIT;
+#endif
+
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+// Exit action type definition
+typedef struct {
+  FaultRecordExitAction_t     func;             // Action function
+  uint32_t                    budget;           // Maximum execution time (FR_TIMESTAMP_ADDR counter ticks)
+  uint32_t                    code_start;       // Code range of the subsystem used by the action
+  uint32_t                    code_end;
+} ExitAction_Type;
+
+// Registered exit actions (ExitAction), in order of execution
+static ExitAction_Type        ExitAction[FR_EXIT_ACTION_NUM];
+static uint32_t               ExitActionNum;
+#endif
+
+#if (FR_SAMPLE_NUM != 0U)
+// PC sample type definition
+typedef struct {
+  uint32_t                    pc;               // Interrupted Program Counter (stacked ReturnAddress)
+  uint32_t                    lr;               // Interrupted Link Register (stacked LR)
+} Sample_Type;
+
+// PC sampling ring buffer type definition
+typedef struct {
+  uint32_t                    count;            // Number of samples taken (wraps around)
+  Sample_Type                 sample[FR_SAMPLE_NUM];
+} SampleBuf_Type;
+
+// PC sampling ring buffer (SampleBuf)
+static SampleBuf_Type         SampleBuf;
+#endif
+
+#if (FR_HISTORY_SIZE != 0U)
+// Fault history type definition
+typedef struct {
+  uint32_t                    magic_number;
+  uint32_t                    crc32;
+  uint32_t                    last_crc32[FR_CORE_NUM]; // CRC-32 of the last FaultInfo added, per slot
+  uint16_t                    rec_words;        // Number of 32-bit words in each history record
+  uint16_t                    count;            // Number of entries in the history
+  uint16_t                    length;           // Number of used bytes in data
+  uint16_t                    keyframe_ofs;     // Offset of the last keyframe entry in data
+  uint8_t                     data[FR_HISTORY_SIZE];
+} FaultHistory_Type;
+
+// Fault history (FaultHistory)
+static FaultHistory_Type      FaultHistory __NO_INIT;
+#endif
+
+#if (FR_PRINT_RING_SIZE != 0U)
+// Print ring buffer identification (located by the debugger or host reader in target memory)
+#define FR_RING_ID             "FR RING BUFFER"
+#define FR_RING_FLAG_OVERWRITE (1U)                     // Print ring buffer flags: overwrite oldest output when full
+
+// Print ring buffer control block type definition (layout is read by Scripts/fr_ring.py)
+typedef struct {
+  char                        id[16];           // Identification (FR_RING_ID, written last upon initialization)
+  uint32_t                    size;             // Size of buf in bytes
+  uint32_t                    flags;            // Flags (FR_RING_FLAG_...)
+  volatile uint32_t           wr;               // Number of bytes written (free running, updated by target)
+  volatile uint32_t           rd;               // Number of bytes read    (free running, updated by host)
+  volatile uint32_t           dropped;          // Number of bytes dropped because buffer was full
+  char                        buf[FR_PRINT_RING_SIZE];
+} FaultRing_Type;
+
+// Print ring buffer (FaultRing), survives resets
+static FaultRing_Type         FaultRing __NO_INIT;
+#endif
+
+#if (FR_TRANSPORT_WINDOW != 0U)
+#define FR_TRANSPORT_MAGIC     (0x54746C46U)            // Transport manifest and state magic number (ASCII "FltT")
+#define FR_TRANSPORT_CHUNK     (0x43U)                  // Transport packet type: chunk           (ASCII "C")
+#define FR_TRANSPORT_ACK       (0x41U)                  // Transport packet type: acknowledgement (ASCII "A")
+#define FR_TRANSPORT_HDR_LEN   (12U)                    // Transport chunk header length (type, chunk size, sequence, session, total)
+#define FR_TRANSPORT_OVERHEAD  (FR_TRANSPORT_HDR_LEN + 4U)  // Transport chunk header and CRC-32 length
+#define FR_TRANSPORT_ACK_LEN   (16U)                    // Transport acknowledgement length (type, 0, base, session, bitmap, CRC-32)
+#define FR_TRANSPORT_REGION_ID_ATTACH (0x10U)           // Transport region ID of the first attachment
+#define FR_TRANSPORT_REGION_NUM (5U + FR_TRANSPORT_ATTACH_NUM)
+
+// Transport region (part of the transferred data) type definition
+typedef struct {
+  const uint8_t              *ptr;              // Pointer to region data
+  uint32_t                    len;              // Region length in bytes
+} TransportRegion_Type;
+
+// Transport state type definition
+typedef struct {
+  uint32_t                    magic_number;
+  uint32_t                    session;          // CRC-32 of the transferred data (session identifier)
+  uint32_t                    total;            // Total length of the transferred data in bytes
+  uint32_t                    chunk_size;       // Chunk payload size in bytes
+  uint32_t                    base;             // Number of chunks acknowledged in sequence
+  uint32_t                    acked;            // Bitmap of acknowledged chunks, bit n = chunk base + n
+  uint32_t                    check;            // Check value (inverted XOR of the fields above)
+} TransportState_Type;
+
+// Transport state (TransportState), survives resets to resume the transfer
+static TransportState_Type    TransportState __NO_INIT;
+
+// Transferred regions, manifest (region IDs and lengths) and attachments
+static TransportRegion_Type   TransportRegion[FR_TRANSPORT_REGION_NUM];
+static uint32_t               TransportRegionNum;
+static uint32_t               TransportManifest[2U + (2U * (FR_TRANSPORT_REGION_NUM - 1U))];
+#if (FR_TRANSPORT_ATTACH_NUM != 0U)
+static TransportRegion_Type   TransportAttach[FR_TRANSPORT_ATTACH_NUM];
+static uint32_t               TransportAttachNum;
+#endif
+static uint32_t               TransportChunkNum;
+static uint32_t               TransportNext;
+#endif
 
 // Fault Recorder callback functions -------------------------------------------
 
 /**
   Callback function called after fault information was recorded.
   Used to provide user specific reaction to fault after it was recorded.
-  The default implementation will reset the system via the CMSIS NVIC_SystemReset function.
+  The default implementation will execute the registered exit actions and reset the
+  system via the CMSIS NVIC_SystemReset function.
 */
 __WEAK __NO_RETURN void FaultRecordOnExit (void) {
+  FaultRecordExitRun();                 // Execute exit actions
   NVIC_SystemReset();                   // Reset the system
 }
 
+/**
+  Callback function called after PC sample was taken.
+  Used to provide user specific periodic processing (for example of the timer that
+  triggers sampling). Returning from this function returns from the exception.
+  The default implementation does nothing.
+*/
+__WEAK void FaultRecordSampleOnExit (void) {
+}
+
+/**
+  Callback function called after stack headroom was checked (and a near-miss recorded).
+  Used to provide user specific periodic processing (for example of the timer that
+  triggers the check). Returning from this function returns from the exception.
+  The default implementation does nothing.
+*/
+__WEAK void FaultRecordStackMonitorOnExit (void) {
+}
+
+/**
+  Callback function called by FaultRecordExitRun before the first exit action.
+  Used to arm or reload a hardware watchdog, so that the system is reset by FR_EXIT_DEADLINE
+  also if an action hangs. The default implementation does nothing.
+  \param[in]    timeout         time left until the FR_EXIT_DEADLINE (FR_TIMESTAMP_ADDR counter ticks)
+*/
+__WEAK void FaultRecordExitWatchdog (uint32_t timeout) {
+  (void)timeout;
+}
+
 // Fault Recorder functions ----------------------------------------------------
 
 /**
@@ -282,246 +934,386 @@ __WEAK __NO_RETURN void FaultRecordOnExit (void) {
 */
 __NAKED void FaultRecord (void) {
   //lint ++flb "Library Begin (excluded from MISRA check)"
-  __ASM volatile (
-#ifndef __ICCARM__
-    ".syntax unified\n\t"
-#endif
+#define FR_ENTRY_EXCEPTION     FR_ENTRY_ANY
+#include "FaultRecorderEntry.inc"
 
- /* --- Clear FaultInfo --- */
-    "movs  r0,  #0\n"                   // R0 = 0
-    "ldr   r1,  =%c[FaultInfo_addr]\n"  // R1 = &FaultInfo
-    "movs  r2,  %[FaultInfo_size]\n"    // R2 = sizeof(FaultInfo)/4
-    "b     is_clear_done\n"
-  "clear_uint32:\n"
-    "stm   r1!, {r0}\n"
-    "subs  r2,  r2, #1\n"
-  "is_clear_done:\n"
-    "bne   clear_uint32\n"
-
-    "mov   r12, r4\n"                   // Store R4 to R12 (to use R4 in this function)
-    "movs  r4,  #0\n"                   // Clear R4
-
- /* Determine the beginning of the state context or the additional state context
-    (for device with TruztZone) that was stacked upon exception entry and put that
-    address into R3.
-    For device with TrustZone, also determine if state context was pushed from
-    Non-secure World but the exception handling is happening in the Secure World
-    and if so, mark it by setting bit [0] of the R4 to value 1, thus indicating usage
-    of Non-secure aliases.
-
-    after this section:
-      R3          == start of state context or additional state context if that was pushed also
-      R4 bit [0]: == 0 - no access to Non-secure aliases or device without TrustZone
-                  == 1 -    access to Non-secure aliases
-
-    Determine by analyzing EXC_RETURN (Link Register):
-    EXC_RETURN:
-      - bit [6] (S):            only on device with TrustZone
-                         == 0 - Non-secure stack was used
-                         == 1 - Secure     stack was used
-      - bit [5] (DCRS):         only on device with TrustZone
-                         == 0 - additional state context was also stacked
-                         == 1 - only       state context was stacked
-      - bit [2] (SPSEL): == 0 - Main    Stack Pointer (MSP) was used for stacking on exception entry
-                         == 1 - Process Stack Pointer (PSP) was used for stacking on exception entry */
-    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
-    "lsrs  r0,  r0, #3\n"               // Shift bit [2] (SPSEL) into Carry flag
-    "bcc   msp_used\n"                  // If    bit [2] (SPSEL) == 0, MSP or MSP_NS was used
-                                        // If    bit [2] (SPSEL) == 1, PSP or PSP_NS was used
-  "psp_used:\n"
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
-    "lsrs  r0,  r0, #7\n"               // Shift   bit [6] (S) into Carry flag
-    "bcs   load_psp\n"                  // If      bit [6] (S) == 1, jump to load PSP
-  "load_psp_ns:\n"                      // else if bit [6] (S) == 0, load PSP_NS
-    "mrs   r3,  psp_ns\n"               // R3 = PSP_NS
-    "movs  r4,  #1\n"                   // R4 = 1
-    "b     r3_points_to_stack\n"        // PSP_NS loaded to R3, exit section
-  "load_psp:\n"
-#endif
-    "mrs   r3,  psp\n"                  // R3 = PSP
-    "b     r3_points_to_stack\n"        // PSP loaded to R3, exit section
+#if (FR_EXT_CONTEXT_EXIST != 0)
+  __ASM volatile (
+    FR_ASM_SET_STAGE(stage_ext_context)
 
-  "msp_used:\n"
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
-    "lsrs  r0,  r0, #7\n"               // Shift   bit [6] (S) into Carry flag
-    "bcs   load_msp\n"                  // If      bit [6] (S) == 1, jump to load MSP
-  "load_msp_ns:\n"                      // else if bit [6] (S) == 0, load MSP_NS
-    "mrs   r3,  msp_ns\n"               // R3 = MSP_NS
-    "movs  r4,  #1\n"                   // R4 = 1
-    "b     r3_points_to_stack\n"        // MSP_NS loaded to R3, exit section
-  "load_msp:\n"
-#endif
-    "mrs   r3,  msp\n"                  // R3 = MSP
-    "b     r3_points_to_stack\n"        // MSP loaded to R3, exit section
-
-  "r3_points_to_stack:\n"
-
- /* Determine if stack contains valid state context (if fault was not a stacking fault).
-    If stack information is not valid mark it by setting bit [1] of the R4 to value 1.
-    Note: for Armv6-M and Armv8-M Baseline CFSR register is not available, so stack is 
-          considered valid although it might not always be so. */
-#if (FR_FAULT_REGS_EXIST != 0)          // If fault registers exist
-    "ldr   r1,  =%c[cfsr_err_msk]\n"    // R1 = (SCB_CFSR_Stack_Err_Msk)
+ /* --- Extended Context --- */
+ /* Record the floating-point registers of the interrupted code into FaultInfo.extended_context,
+    if a floating-point context was stacked upon exception entry (its stack address was stored
+    there while copying the state context): S0..S15 (Q0..Q3 with MVE), FPSCR and VPR (reserved
+    word without MVE) are copied from the stack, S16..S31 (Q4..Q7, not stacked) are read from the
+    registers.
+    With lazy state preservation pending (FPCCR.LSPACT == 1, FPCCR of the Security state of the
+    stack frame) the stack space was only reserved and the registers still hold the values of the
+    interrupted code. Then all registers are read, after clearing FPCCR.LSPACT, so that no lazy
+    state preservation (which could fault again) is triggered.
+    Reading the registers requires FPU access enabled in CPACR (of the Security state running
+    this code). */
+    "ldr   r2,  =%c[FaultInfo_ext_ctx_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)
+    "ldr   r3,  [r2]\n"                 // R3 = stack address of S0 (0 = not stacked)
+    "cmp   r3,  #0\n"
+    "beq   ext_context_end\n"           // If floating-point context was not stacked, skip
+    "ldr   r1,  =%c[fpccr_addr]\n"      // R1 = FPCCR address
 #if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
     "lsrs  r0,  r4, #1\n"               // Shift   bit [0] of R4 into Carry flag
-    "bcc   load_cfsr_addr\n"            // If      bit [0] of R4 == 0, jump to load CFSR register address
-  "load_cfsr_ns_addr:\n"                // else if bit [0] of R4 == 1, load CFSR_NS register address
-    "ldr   r2,  =%c[cfsr_ns_addr]\n"    // R2 = CFSR_NS address
-    "b     load_cfsr\n"
-  "load_cfsr_addr:\n"
-#endif
-    "ldr   r2,  =%c[cfsr_addr]\n"       // R2 = CFSR address
-  "load_cfsr:\n"
-    "ldr   r0,  [r2]\n"                 // R0 = CFSR (or CFSR_NS) register value
-    "ands  r0,  r1\n"                   // Mask CFSR value with stacking error bits
-    "beq   stack_check_end\n"           // If   no stacking error, jump to stack_check_end
-  "stack_check_failed:\n"               // else if stacking error, stack information is invalid
-    "adds  r4,  #2\n"                   // R4 |= (1 << 1)
-  "stack_check_end:\n"
-#endif
-
- /* --- Type information --- */
-    "ldr   r2,  =%c[FaultInfo_type_addr]\n"
-    "ldr   r0,  =%c[FaultInfo_type_val]\n"
-    "str   r0,  [r2]\n"
-
- /* --- State Context --- */
- /* Check if state context (also additional state context if it exists) is valid and
-    if it is then copy it, otherwise skip copying */
-    "lsrs  r0,  r4, #2\n"               // Shift bit [1] of R4 into Carry flag
-    "bcs   state_context_end\n"         // If stack is not valid (bit == 1), skip copying information from stack
+    "bcc   ext_lspact_check\n"          // If      bit [0] of R4 == 0, use FPCCR
+    "ldr   r1,  =%c[fpccr_ns_addr]\n"   // else if bit [0] of R4 == 1, use FPCCR_NS
+  "ext_lspact_check:\n"
+#endif
+    "ldr   r0,  [r1]\n"                 // R0 = FPCCR value
+    "lsrs  r0,  r0, #1\n"               // Shift   bit [0] (LSPACT) into Carry flag
+    "bcs   ext_context_lazy\n"          // If      bit [0] (LSPACT) == 1, lazy state preservation is pending
 
-#if (FR_ARCH_ARMV8x_M != 0)             // If arch is Armv8/8.1-M
- /* If additional state context was stacked upon exception entry, copy it into FaultInfo.additonal_state_context */
-    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
-    "lsrs  r0,  r0, #6\n"               // Shift   bit [5] (DCRS) into Carry flag
-    "bcs   additional_context_end\n"    // If      bit [5] (DCRS) == 1, skip additional state context
-                                        // else if bit [5] (DCRS) == 0, copy additional state context
-    "ldr   r2,  =%c[FaultInfo_additonal_ctx_addr]\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked IntegritySignature, Reserved
+    "ldm   r3!, {r0, r1}\n"             // Stacked S0, S1
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R4, R5
+    "ldm   r3!, {r0, r1}\n"             // Stacked S2, S3
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R6, R7
+    "ldm   r3!, {r0, r1}\n"             // Stacked S4, S5
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R8, R9
+    "ldm   r3!, {r0, r1}\n"             // Stacked S6, S7
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R10, R11
+    "ldm   r3!, {r0, r1}\n"             // Stacked S8, S9
     "stm   r2!, {r0, r1}\n"
-
-  "additional_context_end:\n"
-#endif
-
- /* Copy state context stacked on exception entry into FaultInfo.state_context */
-    "ldr   r2,  =%c[FaultInfo_state_ctx_addr]\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R0, R1
+    "ldm   r3!, {r0, r1}\n"             // Stacked S10, S11
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R2, R3
+    "ldm   r3!, {r0, r1}\n"             // Stacked S12, S13
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked R12, LR
+    "ldm   r3!, {r0, r1}\n"             // Stacked S14, S15
     "stm   r2!, {r0, r1}\n"
-    "ldm   r3!, {r0, r1}\n"             // Stacked ReturnAddress, xPSR
+    "ldr   r0,  =%c[cpacr_addr]\n"
+    "ldr   r0,  [r0]\n"                 // R0 = CPACR value
+    "lsrs  r0,  r0, #21\n"              // Shift   bit [20] (CP10 privileged access) into Carry flag
+    "bcc   ext_context_no_regs\n"       // If      bit [20] == 0, FPU access is disabled
+    "vstm  r2!, {s16-s31}\n"            // Store S16..S31
+    "movs  r0,  %[ext_stacked]\n"
+    "b     ext_context_fpscr\n"
+  "ext_context_no_regs:\n"
+    "adds  r2,  #64\n"                  // Skip S16..S31
+    "movs  r0,  %[ext_partial]\n"
+  "ext_context_fpscr:\n"
+    "str   r0,  [r2, %[ext_state_fpscr_ofs]]\n" // Store FaultInfo.extended_context.state
+    "ldm   r3!, {r0, r1}\n"             // Stacked FPSCR, VPR (or reserved)
+#if (FR_MVE_EXIST == 0)
+    "movs  r1,  #0\n"                   // Reserved word is not recorded
+#endif
     "stm   r2!, {r0, r1}\n"
+    "b     ext_context_end\n"
 
-  "state_context_end:\n"
-
- /* --- Common Registers --- */
- /* Store values of Common Registers into FaultInfo.common_registers */
-    "ldr   r2,  =%c[FaultInfo_common_regs_addr]\n"
-    "mrs   r0,  xpsr\n"                 // R0 = current xPSR
-    "mov   r1,  lr\n"                   // R1 = current LR (exception return code)
-    "stm   r2!, {r0, r1}\n"
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "lsrs  r0,  r4, #1\n"               // Shift   bit [0] of R4 into Carry flag
-    "bcc   load_sps\n"                  // If      bit [0] of R4 == 0, jump to load MSP and PSP
-  "load_sps_ns:\n"                      // else if bit [0] of R4 == 1, load MSP_NS and PSP_NS
-    "mrs   r0,  msp_ns\n"               // R0 = current MSP_NS
-    "mrs   r1,  psp_ns\n"               // R1 = current PSP_NS
-    "b     store_sps\n"
-#endif
-  "load_sps:\n"
-    "mrs   r0,  msp\n"                  // R0 = current MSP
-    "mrs   r1,  psp\n"                  // R1 = current PSP
-  "store_sps:\n"
-    "stm   r2!, {r0, r1}\n"             // Store MSP, PSP
-
- /* --- Armv8/8.1-M specific Registers --- */
- /* Store values of Armv8/8.1-M specific Registers (if they exist) into FaultInfo.armv8_m_registers */
-#if (FR_ARCH_ARMV8x_M != 0)             // If arch is Armv8/8.1-M
-    "ldr   r2,  =%c[FaultInfo_armv8_m_regs_addr]\n"
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "lsrs  r0,  r4, #1\n"               // Shift   bit [0] of R4 into Carry flag
-    "bcc   load_splims\n"               // If      bit [0] of R4 == 0, jump to load MSPLIM and PSPLIM
-#if (FR_ARCH_ARMV8_M_BASE !=0)          // If arch is Armv8-M Baseline
-    "b     splims_end\n"                // MSPLIM_NS and PSPLIM_NS do not exist, skip loading and storing them
-#else                                   // Else if arch is Armv8/8.1-M Mainline
-  "load_splims_ns:\n"                   // else if bit [0] of R4 == 1, load MSPLIM_NS and PSPLIM_NS
-    "mrs   r0,  msplim_ns\n"            // R0 = current MSPLIM_NS
-    "mrs   r1,  psplim_ns\n"            // R1 = current PSPLIM_NS
-    "b     store_splims\n"
-#endif
-#endif
-  "load_splims:\n"
-    "mrs   r0,  msplim\n"               // R0 = current MSP
-    "mrs   r1,  psplim\n"               // R1 = current PSP
-  "store_splims:\n"
+  "ext_context_lazy:\n"
+    "ldr   r0,  =%c[cpacr_addr]\n"
+    "ldr   r0,  [r0]\n"                 // R0 = CPACR value
+    "lsrs  r0,  r0, #21\n"              // Shift   bit [20] (CP10 privileged access) into Carry flag
+    "bcc   ext_context_no_access\n"     // If      bit [20] == 0, FPU access is disabled
+    "ldr   r0,  [r1]\n"                 // R0 = FPCCR value
+    "lsrs  r0,  r0, #1\n"
+    "lsls  r0,  r0, #1\n"               // Clear bit [0] (LSPACT)
+    "str   r0,  [r1]\n"                 // Cancel lazy state preservation
+    "dsb\n"
+    "isb\n"
+    "vstm  r2!, {s0-s31}\n"             // Store S0..S31
+    "vmrs  r0,  fpscr\n"                // R0 = FPSCR
+#if (FR_MVE_EXIST != 0)
+    "vmrs  r1,  p0\n"                   // R1 = VPR
+#else
+    "movs  r1,  #0\n"
+#endif
     "stm   r2!, {r0, r1}\n"
-  "splims_end:\n"
+    "movs  r0,  %[ext_lazy]\n"
+    "str   r0,  [r2]\n"                 // Store FaultInfo.extended_context.state
+    "b     ext_context_end\n"
+
+  "ext_context_no_access:\n"
+    "movs  r0,  #0\n"
+    "str   r0,  [r2]\n"                 // Clear stack address of S0
+    "adds  r2,  %[ext_state_ofs]\n"     // R2 = &FaultInfo.extended_context.state
+    "movs  r0,  %[ext_no_access]\n"
+    "str   r0,  [r2]\n"
+  "ext_context_end:\n"
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [FaultInfo_crc32_addr]              "i"     (&FaultInfo[0].crc32)
+  , [stage_ext_context]                 "i"     (FR_STAGE_EXT_CONTEXT)
+  , [FaultInfo_ext_ctx_addr]            "i"     (&FaultInfo[0].extended_context)
+  , [ext_state_ofs]                     "i"     (offsetof(ExtendedContext_Type, state))
+  , [ext_state_fpscr_ofs]               "i"     (offsetof(ExtendedContext_Type, state) - offsetof(ExtendedContext_Type, FPSCR))
+  , [ext_stacked]                       "i"     (FR_EXT_CONTEXT_STACKED)
+  , [ext_partial]                       "i"     (FR_EXT_CONTEXT_PARTIAL)
+  , [ext_lazy]                          "i"     (FR_EXT_CONTEXT_LAZY)
+  , [ext_no_access]                     "i"     (FR_EXT_CONTEXT_NO_ACCESS)
+  , [fpccr_addr]                        "i"     (FPU_BASE + offsetof(FPU_Type, FPCCR))
+#if (FR_SECURE != 0)
+  , [fpccr_ns_addr]                     "i"     (FPU_BASE_NS + offsetof(FPU_Type, FPCCR))
+#endif
+  , [cpacr_addr]                        "i"     (SCB_BASE + offsetof(SCB_Type, CPACR))
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
 #endif
 
- /* --- Fault Registers --- */
- /* Store values of Fault Registers (if they exist) into FaultInfo.fault_registers */
-#if (FR_FAULT_REGS_EXIST != 0)          // If fault registers exist
-    "ldr   r2,  =%c[FaultInfo_fault_regs_addr]\n"
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "lsrs  r0,  r4, #1\n"               // Shift   bit [0] of R4 into Carry flag
-    "bcc   load_scb_addr\n"             // If      bit [0] of R4 == 0, jump to load SCB address
-  "load_scb_ns_addr:\n"                 // else if bit [0] of R4 == 1, load SCB_NS address
-    "ldr   r3,  =%c[scb_ns_addr]\n"
-    "b     load_fault_regs\n"
-  "load_scb_addr:\n"
-#endif
-    "ldr   r3,  =%c[scb_addr]\n"
-  "load_fault_regs:\n"
-    "ldr   r0,  [r3, %[cfsr_ofs]]\n"    // R0 = CFSR
-    "ldr   r1,  [r3, %[hfsr_ofs]]\n"    // R1 = HFSR
-    "stm   r2!, {r0, r1}\n"
-    "ldr   r0,  [r3, %[dfsr_ofs]]\n"    // R0 = DFSR
-    "ldr   r1,  [r3, %[mmfar_ofs]]\n"   // R1 = MMFAR
-    "stm   r2!, {r0, r1}\n"
-    "ldr   r0,  [r3, %[bfar_ofs]]\n"    // R0 = BFSR
-    "ldr   r1,  [r3, %[afsr_ofs]]\n"    // R1 = AFSR
-    "stm   r2!, {r0, r1}\n"
+#if (FR_BACKTRACE_EXIST != 0)
+  __ASM volatile (
+ /* --- Backtrace --- */
+ /* Scan the stack above the stacked context for candidate return addresses and store them
+    into FaultInfo.backtrace. A stack word is a candidate if it is a Thumb address (bit [0] == 1)
+    inside one of the code ranges and if the instruction preceding it is a BL or BLX.
+    Scan is bounded by FR_BACKTRACE_SCAN_WORDS and FR_BACKTRACE_DEPTH and is skipped if stack
+    is not valid (FaultInfo.backtrace.sp == 0).
 
- /* --- Armv8/8.1-M Fault Registers --- */
- /* Store values of Armv8/8.1-M Fault Registers (if they exist) and if code is running in Secure World
-    into FaultInfo.armv8_m_fault_registers */
-#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
-    "ldr   r2,  =%c[FaultInfo_armv8_m_fault_regs_addr]\n"
-    "ldr   r3,  =%c[scb_addr]\n"
-    "ldr   r0,  [r3, %[sfsr_ofs]]\n"    // R0 = SFSR
-    "ldr   r1,  [r3, %[sfar_ofs]]\n"    // R1 = SFAR
-    "stm   r2!, {r0, r1}\n"
+    in this section:
+      R0          == stack word (candidate), then candidate return address - 4
+      R1          == pointer to next FaultInfo.backtrace.addr entry
+      R2          == temporary
+      R3          == scan pointer
+      LR          == scan end */
+    FR_ASM_SET_STAGE(stage_backtrace)
+
+    "ldr   r1,  =%c[FaultInfo_backtrace_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r1, r0)
+    "ldr   r3,  [r1, %[backtrace_sp_ofs]]\n" // R3 = scan start
+    "adds  r1,  %[backtrace_addr_ofs]\n"     // R1 = &FaultInfo.backtrace.addr[0]
+    "cmp   r3,  #0\n"
+    "beq   backtrace_end\n"             // If stack is not valid, skip scanning
+    "ldr   r2,  =%c[backtrace_scan_size]\n"
+    "adds  r2,  r2, r3\n"               // R2 = scan start + FR_BACKTRACE_SCAN_WORDS * 4
+#ifdef FR_BACKTRACE_STACK_END
+    "ldr   r0,  =%c[backtrace_stack_end]\n"
+    "cmp   r2,  r0\n"                   // If      scan end <= FR_BACKTRACE_STACK_END, use it
+    "bls   backtrace_scan_end\n"
+    "mov   r2,  r0\n"                   // else if scan end >  FR_BACKTRACE_STACK_END, limit it
+  "backtrace_scan_end:\n"
 #endif
+    "mov   lr,  r2\n"                   // LR = scan end
+  "backtrace_next:\n"
+    "cmp   r3,  lr\n"
+    "bhs   backtrace_end\n"             // If scan end reached, end scanning
+    "ldm   r3!, {r0}\n"                 // R0 = stack word
+    "lsrs  r2,  r0, #1\n"               // Shift bit [0] into Carry flag
+    "bcc   backtrace_next\n"            // If bit [0] == 0, not a Thumb address
+
+    "ldr   r2,  =%c[text_start]\n"
+    "cmp   r0,  r2\n"
+    "blo   backtrace_text2\n"           // If below code range, check second code range
+    "ldr   r2,  =%c[text_end]\n"
+    "cmp   r0,  r2\n"
+    "blo   backtrace_in_text\n"         // If inside code range, check preceding instruction
+  "backtrace_text2:\n"
+#if (defined(FR_BACKTRACE_TEXT2_START) && defined(FR_BACKTRACE_TEXT2_END))
+    "ldr   r2,  =%c[text2_start]\n"
+    "cmp   r0,  r2\n"
+    "blo   backtrace_next\n"            // If below second code range, not a code address
+    "ldr   r2,  =%c[text2_end]\n"
+    "cmp   r0,  r2\n"
+    "blo   backtrace_in_text\n"         // If inside second code range, check preceding instruction
 #endif
+    "b     backtrace_next\n"            // Not a code address
 
- /* Calculate CRC-32 on FaultInfo structure (excluding magic_number and crc32 fields) and
-    store it into FaultInfo.crc32 */
-    "ldr   r0,  =%c[crc_init_val]\n"    // R0 = init_val parameter
+  "backtrace_in_text:\n"
+    "subs  r0,  r0, #5\n"               // R0 = return address - 4 (address of 32-bit BL)
+    "ldrh  r2,  [r0, #2]\n"             // R2 = halfword preceding return address
+    "lsrs  r2,  r2, #7\n"
+    "cmp   r2,  #0x8F\n"                // If halfword == 0x4780 | (Rm << 3) (BLX Rm), candidate found
+    "beq   backtrace_found\n"
+    "lsrs  r2,  r2, #5\n"               // R2 = halfword >> 12
+    "cmp   r2,  #0xF\n"                 // If halfword is second half of BL (0b11x1), check first half
+    "beq   backtrace_bl\n"
+    "cmp   r2,  #0xD\n"
+    "bne   backtrace_next\n"
+  "backtrace_bl:\n"
+    "ldrh  r2,  [r0, #0]\n"             // R2 = first halfword of 32-bit instruction
+    "lsrs  r2,  r2, #11\n"
+    "cmp   r2,  #0x1E\n"                // If first half of BL (0b11110), candidate found
+    "bne   backtrace_next\n"
+  "backtrace_found:\n"
+    "adds  r0,  #4\n"                   // R0 = return address (bit [0] cleared)
+    "stm   r1!, {r0}\n"                 // Store candidate
+    "ldr   r2,  =%c[FaultInfo_backtrace_addr_end]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)
+    "cmp   r1,  r2\n"
+    "blo   backtrace_next\n"            // If FR_BACKTRACE_DEPTH candidates not found yet, continue scanning
+
+  "backtrace_end:\n"
+    "ldr   r2,  =%c[FaultInfo_backtrace_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)
+    "subs  r1,  r1, r2\n"
+    "subs  r1,  %[backtrace_addr_ofs]\n"
+    "lsrs  r1,  r1, #2\n"               // R1 = number of candidates
+    "str   r1,  [r2, %[backtrace_count_ofs]]\n"
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [FaultInfo_crc32_addr]              "i"     (&FaultInfo[0].crc32)
+  , [stage_backtrace]                   "i"     (FR_STAGE_BACKTRACE)
+  , [FaultInfo_backtrace_addr]          "i"     (&FaultInfo[0].backtrace)
+  , [FaultInfo_backtrace_addr_end]      "i"     (&FaultInfo[0].backtrace.addr[FR_BACKTRACE_DEPTH])
+  , [backtrace_sp_ofs]                  "i"     (offsetof(Backtrace_Type, sp))
+  , [backtrace_count_ofs]               "i"     (offsetof(Backtrace_Type, count))
+  , [backtrace_addr_ofs]                "i"     (offsetof(Backtrace_Type, addr))
+  , [backtrace_scan_size]               "i"     (FR_BACKTRACE_SCAN_WORDS * 4U)
+  , [text_start]                        "i"     ((FR_BACKTRACE_TEXT_START) + 4U)
+  , [text_end]                          "i"     (FR_BACKTRACE_TEXT_END)
+#if (defined(FR_BACKTRACE_TEXT2_START) && defined(FR_BACKTRACE_TEXT2_END))
+  , [text2_start]                       "i"     ((FR_BACKTRACE_TEXT2_START) + 4U)
+  , [text2_end]                         "i"     (FR_BACKTRACE_TEXT2_END)
+#endif
+#ifdef FR_BACKTRACE_STACK_END
+  , [backtrace_stack_end]               "i"     (FR_BACKTRACE_STACK_END)
+#endif
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+#endif
+
+#if (FR_STACK_USAGE_EXIST != 0)
+  __ASM volatile (
+ /* --- Stack usage --- */
+ /* Copy registered stack regions into FaultInfo.stack_usage and measure the unused part of
+    each stack by comparing words from the stack base upwards with the paint pattern.
+    Scan of each stack is limited to FR_STACK_SCAN_WORDS words. */
+    FR_ASM_SET_STAGE(stage_stack_usage)
+
+    "ldr   r1,  =%c[StackRegion_addr]\n" // R1 = &StackRegion[0]
+    "ldr   r2,  =%c[FaultInfo_stack_usage_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)         // R2 = &FaultInfo.stack_usage[0]
+    "movs  r3,  %[stack_num]\n"         // R3 = FR_STACK_NUM
+  "stack_copy:\n"
+    "ldm   r1!, {r0}\n"                 // Copy base
+    "str   r0,  [r2, %[stack_base_ofs]]\n"
+    "ldm   r1!, {r0}\n"                 // Copy size
+    "str   r0,  [r2, %[stack_size_ofs]]\n"
+    "adds  r2,  %[stack_usage_size]\n"
+    "subs  r3,  r3, #1\n"
+    "bne   stack_copy\n"
+
+    "ldr   r2,  =%c[FaultInfo_stack_usage_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)         // R2 = &FaultInfo.stack_usage[0]
+  "stack_next:\n"
+    "ldr   r3,  [r2, %[stack_base_ofs]]\n" // R3 = scan pointer = base
+    "ldr   r0,  [r2, %[stack_size_ofs]]\n" // R0 = size
+    "ldr   r1,  =%c[stack_scan_size]\n"
+    "cmp   r0,  r1\n"                   // If      size <= FR_STACK_SCAN_WORDS * 4, scan whole stack
+    "bls   stack_scan_size_ok\n"
+    "mov   r0,  r1\n"                   // else if size >  FR_STACK_SCAN_WORDS * 4, limit scan
+  "stack_scan_size_ok:\n"
+    "adds  r0,  r0, r3\n"
+    "mov   lr,  r0\n"                   // LR = scan end
+    "ldr   r1,  =%c[stack_pattern]\n"   // R1 = paint pattern
+  "stack_scan:\n"
+    "cmp   r3,  lr\n"
+    "bhs   stack_scan_end\n"            // If scan end reached, end scanning
+    "ldm   r3!, {r0}\n"
+    "cmp   r0,  r1\n"
+    "beq   stack_scan\n"                // If word contains paint pattern, continue scanning
+    "subs  r3,  r3, #4\n"               // R3 = address of the lowest used word
+  "stack_scan_end:\n"
+    "ldr   r0,  [r2, %[stack_base_ofs]]\n"
+    "subs  r3,  r3, r0\n"               // R3 = number of unused bytes
+    "str   r3,  [r2, %[stack_unused_ofs]]\n"
+    "adds  r2,  %[stack_usage_size]\n"
+    "ldr   r0,  =%c[FaultInfo_stack_usage_end]\n"
+    FR_ASM_ADD_SLOT_OFS(r0, r1)
+    "cmp   r2,  r0\n"
+    "blo   stack_next\n"                // If not all stacks were measured, continue with next stack
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [FaultInfo_crc32_addr]              "i"     (&FaultInfo[0].crc32)
+  , [stage_stack_usage]                 "i"     (FR_STAGE_STACK_USAGE)
+  , [StackRegion_addr]                  "i"     (&StackRegion[0])
+  , [FaultInfo_stack_usage_addr]        "i"     (&FaultInfo[0].stack_usage[0])
+  , [FaultInfo_stack_usage_end]         "i"     (&FaultInfo[0].stack_usage[FR_STACK_NUM])
+  , [stack_num]                         "i"     (FR_STACK_NUM)
+  , [stack_usage_size]                  "i"     (sizeof(StackUsage_Type))
+  , [stack_base_ofs]                    "i"     (offsetof(StackUsage_Type, base))
+  , [stack_size_ofs]                    "i"     (offsetof(StackUsage_Type, size))
+  , [stack_unused_ofs]                  "i"     (offsetof(StackUsage_Type, unused))
+  , [stack_scan_size]                   "i"     (FR_STACK_SCAN_WORDS * 4U)
+  , [stack_pattern]                     "i"     (FR_STACK_PAINT_PATTERN)
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+#endif
+
+#if (FR_BUILD_ID_EXIST != 0)
+  __ASM volatile (
+ /* --- Build ID --- */
+ /* Copy the firmware build ID into FaultInfo.build_id */
+    "ldr   r1,  =%c[build_id_addr]\n"   // R1 = address of the build ID
+    "ldr   r2,  =%c[FaultInfo_build_id_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)         // R2 = &FaultInfo.build_id[0]
+    "movs  r3,  %[build_id_words]\n"    // R3 = number of words
+  "build_id_copy:\n"
+    "ldm   r1!, {r0}\n"
+    "stm   r2!, {r0}\n"
+    "subs  r3,  r3, #1\n"
+    "bne   build_id_copy\n"
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [build_id_addr]                     "i"     (&((const uint8_t *)FR_BUILD_ID_SYMBOL)[FR_BUILD_ID_OFS])
+  , [FaultInfo_build_id_addr]           "i"     (&FaultInfo[0].build_id[0])
+  , [build_id_words]                    "i"     (FR_BUILD_ID_LEN / 4U)
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+#endif
+
+  __ASM volatile (
+    FR_ASM_SET_STAGE(stage_crc)
+
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+ /* --- Emergency stack --- */
+ /* Switch MSP (and MSPLIM) to the emergency stack of the current core before any function
+    is called, so that recording completes even if the original stack overflowed.
+    Original values were already stored into FaultInfo.common_registers and
+    FaultInfo.armv8_m_registers. */
+#if (FR_CORE_NUM > 1U)
+    "ldr   r2,  =%c[FaultInfo_record_info_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)
+    "ldr   r1,  [r2, %[core_id_ofs]]\n" // R1 = core ID
+    "ldr   r0,  =%c[FaultStack_size]\n"
+    "muls  r1,  r0, r1\n"               // R1 = core ID * FR_EMERGENCY_STACK_SIZE
+#else
+    "movs  r1,  #0\n"                   // R1 = 0
+#endif
+    FR_ASM_SET_EMERGENCY_STACK
+#endif
+
+ /* Calculate CRC-32 on FaultInfo structure (excluding magic_number and crc32 fields) and
+    store it into FaultInfo.crc32 */
     "ldr   r1,  =%c[crc_data_ptr]\n"    // R1 = data_ptr parameter
+    FR_ASM_ADD_SLOT_OFS(r1, r0)
+    "ldr   r0,  =%c[crc_init_val]\n"    // R0 = init_val parameter
     "ldr   r2,  =%c[crc_data_len]\n"    // R2 = data_len parameter
     "ldr   r3,  =%c[crc_polynom]\n"     // R3 = polynom  parameter
     "bl    CalcCRC32\n"                 // Call CalcCRC32 function
     "ldr   r2,  =%c[FaultInfo_crc32_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r1)
     "str   r0,  [r2]\n"                 // Store CRC-32
 
- /* Store magic number into FaultInfo.magic_number */
+ /* Store magic number into FaultInfo.magic_number (recording completed) */
     "ldr   r2,  =%c[FaultInfo_magic_number_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r2, r0)
     "ldr   r0,  =%c[FaultInfo_magic_number_val]\n"
     "str   r0,  [r2]\n"
 
+ /* Clear FaultBusy of the current core (recording completed) */
+    "ldr   r2,  =%c[FaultBusy_addr]\n"  // R2 = &FaultBusy[0]
+#if (FR_CORE_NUM > 1U)
+    "ldr   r1,  =%c[FaultInfo_record_info_addr]\n"
+    FR_ASM_ADD_SLOT_OFS(r1, r0)
+    "ldr   r1,  [r1, %[core_id_ofs]]\n" // R1 = core ID
+    "lsls  r1,  r1, #2\n"
+    "adds  r2,  r2, r1\n"               // R2 = &FaultBusy[core ID]
+#endif
+    "movs  r0,  #0\n"
+    "str   r0,  [r2]\n"                 // FaultBusy[core ID] = 0
+
     "mov   r4,  r12\n"                  // Restore R4 from R12
 
     "bl    FaultRecordOnExit\n"         // Call FaultRecordOnExit function
@@ -529,69 +1321,518 @@ __NAKED void FaultRecord (void) {
  /* Inline assembly template operands */
  :  /* no outputs */
  :  /* inputs */
-    [FaultInfo_addr]                    "i"     (&FaultInfo)
-  , [FaultInfo_size]                    "i"     (sizeof(FaultInfo)/4)
-  , [FaultInfo_magic_number_addr]       "i"     (&FaultInfo.magic_number)
+    [crc_init_val]                      "i"     (FR_CRC32_INIT_VAL)
+  , [crc_data_ptr]                      "i"     (FR_CRC32_DATA_PTR(&FaultInfo[0]))
+  , [crc_data_len]                      "i"     (FR_CRC32_DATA_LEN)
+  , [crc_polynom]                       "i"     (FR_CRC32_POLYNOM)
+  , [FaultInfo_crc32_addr]              "i"     (&FaultInfo[0].crc32)
+  , [FaultInfo_magic_number_addr]       "i"     (&FaultInfo[0].magic_number)
   , [FaultInfo_magic_number_val]        "i"     (FR_MAGIC_NUMBER)
-  , [FaultInfo_crc32_addr]              "i"     (&FaultInfo.crc32)
-  , [FaultInfo_type_addr]               "i"     (&FaultInfo.type)
-  , [FaultInfo_type_val]                "i"     (FR_FAULT_INFO_TYPE)
-  , [FaultInfo_state_ctx_addr]          "i"     (&FaultInfo.state_context)
-  , [FaultInfo_common_regs_addr]        "i"     (&FaultInfo.common_registers)
+  , [stage_crc]                         "i"     (FR_STAGE_CRC)
+  , [FaultBusy_addr]                    "i"     (&FaultBusy[0])
+#if (FR_CORE_NUM > 1U)
+  , [FaultInfo_record_info_addr]        "i"     (&FaultInfo[0].record_info)
+  , [core_id_ofs]                       "i"     (offsetof(RecordInfo_Type, core_id))
+#endif
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+  , [FaultStack_addr]                   "i"     (&FaultStack[0][0])
+  , [FaultStack_size]                   "i"     (FR_EMERGENCY_STACK_SIZE)
+#endif
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+
+  __ASM volatile (
+ /* --- Nested fault --- */
+ /* Record the fault that occurred while fault information was being recorded into
+    FaultNested: stage reached by the interrupted recording, exception, EXC_RETURN, CFSR
+    and return address of the nested fault. FaultInfo is not modified.
+
+    on entry:
+      R1          == &FaultInfo[core ID]
+      R3          == core ID (only if FR_CORE_NUM > 1) */
+    ".type fault_record_nested, %%function\n"
+  "fault_record_nested:\n"
+    "ldr   r0,  [r1, %[crc32_ofs]]\n"  // R0 = stage reached by the interrupted recording
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+    "ldr   r2,  [r1, %[magic_number_ofs]]\n"
+    "ldr   r1,  =%c[magic_number_busy]\n"
+    "cmp   r2,  r1\n"
+    "beq   nested_stage_store\n"        // If      recording was interrupted, use stored stage
+    "movs  r0,  %[stage_exit]\n"        // else if exit actions were interrupted (record completed), R0 = FR_STAGE_EXIT
+  "nested_stage_store:\n"
+#endif
+    "ldr   r2,  =%c[FaultNested_addr]\n"
+#if (FR_CORE_NUM > 1U)
+    "ldr   r1,  =%c[FaultNested_slot_size]\n"
+    "muls  r1,  r3, r1\n"
+    "adds  r2,  r2, r1\n"               // R2 = &FaultNested[core ID]
+#endif
+    "str   r0,  [r2, %[nested_stage_ofs]]\n"
+    "mrs   r0,  xpsr\n"                 // R0 = current xPSR
+    "mov   r1,  lr\n"                   // R1 = current LR (exception return code)
+    "str   r0,  [r2, %[nested_xpsr_ofs]]\n"
+    "str   r1,  [r2, %[nested_exc_return_ofs]]\n"
+#if (FR_FAULT_REGS_EXIST != 0)          // If fault registers exist
+    "ldr   r1,  =%c[cfsr_addr]\n"
+    "ldr   r1,  [r1]\n"                 // R1 = CFSR
+    "str   r1,  [r2, %[nested_cfsr_ofs]]\n"
+    "ldr   r0,  =%c[cfsr_err_msk]\n"
+    "tst   r1,  r0\n"
+    "bne   nested_stack_err\n"          // If stacking error, return address is not valid
+#endif
+    "mrs   r1,  msp\n"                  // R1 = MSP (nested fault was taken from Handler mode)
+    "ldr   r0,  [r1, %[ret_addr_ofs]]\n" // R0 = stacked ReturnAddress
+    "b     nested_ret_addr_store\n"
+  "nested_stack_err:\n"
+    "movs  r0,  #0\n"                   // R0 = 0 (return address not valid)
+  "nested_ret_addr_store:\n"
+    "str   r0,  [r2, %[nested_ret_addr_ofs]]\n"
+    "ldr   r0,  =%c[FaultNested_magic_number_val]\n"
+    "str   r0,  [r2, %[nested_magic_number_ofs]]\n"
+
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+ /* Switch MSP (and MSPLIM) to the emergency stack of the current core */
+#if (FR_CORE_NUM > 1U)
+    "ldr   r1,  =%c[FaultStack_size]\n"
+    "muls  r1,  r3, r1\n"               // R1 = core ID * FR_EMERGENCY_STACK_SIZE
+#else
+    "movs  r1,  #0\n"                   // R1 = 0
+#endif
+    FR_ASM_SET_EMERGENCY_STACK
+#endif
+
+    "mov   r4,  r12\n"                  // Restore R4 from R12
+
+    "bl    FaultRecordOnExit\n"         // Call FaultRecordOnExit function
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [FaultNested_addr]                  "i"     (&FaultNested[0])
+  , [FaultNested_magic_number_val]      "i"     (FR_MAGIC_NUMBER_NESTED)
+  , [crc32_ofs]                         "i"     (offsetof(FaultInfo_Type, crc32))
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  , [magic_number_ofs]                  "i"     (offsetof(FaultInfo_Type, magic_number))
+  , [magic_number_busy]                 "i"     (FR_MAGIC_NUMBER_BUSY)
+  , [stage_exit]                        "i"     (FR_STAGE_EXIT)
+#endif
+  , [ret_addr_ofs]                      "i"     (offsetof(StateContext_Type, ReturnAddress))
+  , [nested_magic_number_ofs]           "i"     (offsetof(FaultNested_Type, magic_number))
+  , [nested_stage_ofs]                  "i"     (offsetof(FaultNested_Type, stage))
+  , [nested_xpsr_ofs]                   "i"     (offsetof(FaultNested_Type, xPSR))
+  , [nested_exc_return_ofs]             "i"     (offsetof(FaultNested_Type, EXC_RETURN))
+  , [nested_ret_addr_ofs]               "i"     (offsetof(FaultNested_Type, ReturnAddress))
+#if (FR_CORE_NUM > 1U)
+  , [FaultNested_slot_size]             "i"     (sizeof(FaultNested_Type))
+#endif
 #if (FR_FAULT_REGS_EXIST != 0)
-  , [FaultInfo_fault_regs_addr]         "i"     (&FaultInfo.fault_registers)
+  , [nested_cfsr_ofs]                   "i"     (offsetof(FaultNested_Type, SCB_CFSR))
   , [cfsr_err_msk]                      "i"     (SCB_CFSR_Stack_Err_Msk)
-  , [scb_addr]                          "i"     (SCB_BASE)
-  , [cfsr_addr]                         "i"     (SCS_BASE + offsetof(SCB_Type, CFSR))
-  , [cfsr_ofs]                          "i"     (offsetof(SCB_Type, CFSR ))
-  , [hfsr_ofs]                          "i"     (offsetof(SCB_Type, HFSR ))
-  , [dfsr_ofs]                          "i"     (offsetof(SCB_Type, DFSR ))
-  , [mmfar_ofs]                         "i"     (offsetof(SCB_Type, MMFAR))
-  , [bfar_ofs]                          "i"     (offsetof(SCB_Type, BFAR ))
-  , [afsr_ofs]                          "i"     (offsetof(SCB_Type, AFSR ))
-#if (FR_SECURE != 0)
-  , [scb_ns_addr]                       "i"     (SCB_BASE_NS)
-  , [cfsr_ns_addr]                      "i"     (SCS_BASE_NS + offsetof(SCB_Type, CFSR))
+  , [cfsr_addr]                         "i"     (SCB_BASE + offsetof(SCB_Type, CFSR))
+#endif
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+  , [FaultStack_addr]                   "i"     (&FaultStack[0][0])
+  , [FaultStack_size]                   "i"     (FR_EMERGENCY_STACK_SIZE)
+#endif
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+
+/**
+  Record hang information (interrupted context of code that did not service the watchdog).
+  Must be called from watchdog early warning (pre-timeout) interrupt handler with preserved
+  Link Register value, typically by branching to this function.
+  Records the same information as FaultRecord, with the record marked as hang.
+*/
+__NAKED void FaultRecordHang (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+  __ASM volatile (
+#ifndef __ICCARM__
+    ".syntax unified\n\t"
+#endif
+    "mov   r12, r4\n"                   // Store R4 to R12 (to use R4 in FaultRecord)
+    "movs  r4,  #1\n"
+    "lsls  r4,  r4, #31\n"              // R4 = (1 << 31), mark hang
+    "ldr   r0,  =fault_record_common\n"
+    "bx    r0\n"                        // Continue in FaultRecord (LR is preserved)
+ :::
+    "r0", "r4", "r12");
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+
+/**
+  Record HardFault information (HardFault handler entry).
+  All fault registers are relevant to a HardFault and its stack frame can be on any stack,
+  so this is the generic FaultRecord.
+*/
+void FaultRecordHardFault (void) __attribute__((alias("FaultRecord")));
+
+#if (FR_FAULT_REGS_EXIST != 0)
+/**
+  Record MemManage fault information (MemManage fault handler entry).
+  Must be called from MemManage fault handler with preserved Link Register value, typically
+  by branching to this function, or used as the handler directly.
+  Records the same information as FaultRecord, specialized at compile time: of the fault
+  registers only CFSR and MMFAR are read, and in the Secure World the stack frame is not
+  checked for Non-secure stacks (MemManage is banked, Secure MemManage faults are always
+  stacked on a Secure stack).
+*/
+__NAKED void FaultRecordMemManage (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#define FR_ENTRY_EXCEPTION     FR_ENTRY_MEMMANAGE
+#include "FaultRecorderEntry.inc"
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+
+/**
+  Record BusFault information (BusFault handler entry).
+  Must be called from BusFault handler with preserved Link Register value, typically
+  by branching to this function, or used as the handler directly.
+  Records the same information as FaultRecord, specialized at compile time: of the fault
+  registers only CFSR, BFAR and RFSR (Armv8.1-M) are read.
+*/
+__NAKED void FaultRecordBusFault (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#define FR_ENTRY_EXCEPTION     FR_ENTRY_BUSFAULT
+#include "FaultRecorderEntry.inc"
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+
+/**
+  Record UsageFault information (UsageFault handler entry).
+  Must be called from UsageFault handler with preserved Link Register value, typically
+  by branching to this function, or used as the handler directly.
+  Records the same information as FaultRecord, specialized at compile time: of the fault
+  registers only CFSR is read, and in the Secure World the stack frame is not checked for
+  Non-secure stacks (UsageFault is banked).
+*/
+__NAKED void FaultRecordUsageFault (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#define FR_ENTRY_EXCEPTION     FR_ENTRY_USAGEFAULT
+#include "FaultRecorderEntry.inc"
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+#endif
+
+#if ((FR_SECURE != 0) && (FR_ARCH_ARMV8x_M_MAIN != 0))
+/**
+  Record SecureFault information (SecureFault handler entry, Secure World only).
+  Must be called from SecureFault handler with preserved Link Register value, typically
+  by branching to this function, or used as the handler directly.
+  Records the same information as FaultRecord, specialized at compile time: of the fault
+  registers only CFSR, SFSR and SFAR are read.
+*/
+__NAKED void FaultRecordSecureFault (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#define FR_ENTRY_EXCEPTION     FR_ENTRY_SECUREFAULT
+#include "FaultRecorderEntry.inc"
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+#endif
+
+/**
+  Take PC sample of the interrupted code (statistical profiling).
+  Must be called from periodic timer interrupt handler (for example SysTick) with
+  preserved Link Register value, typically by branching to this function, or used
+  as the handler directly. Interrupted PC and LR are stored into the sampling ring
+  buffer, then the FaultRecordSampleOnExit function is branched to.
+*/
+__NAKED void FaultRecordSample (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#if (FR_SAMPLE_NUM != 0U)
+  __ASM volatile (
+#ifndef __ICCARM__
+    ".syntax unified\n\t"
+#endif
+
+ /* Determine address of the next ring buffer entry into R3 and increment sample count */
+    "ldr   r3,  =%c[SampleBuf_addr]\n"  // R3 = &SampleBuf
+    "ldr   r1,  [r3, %[count_ofs]]\n"   // R1 = SampleBuf.count
+    "adds  r2,  r1, #1\n"
+    "str   r2,  [r3, %[count_ofs]]\n"   // SampleBuf.count++
+    "ldr   r2,  =%c[sample_mask]\n"
+    "ands  r1,  r2\n"                   // R1 = index of the entry
+    "lsls  r1,  r1, #3\n"               // R1 = index * sizeof(Sample_Type)
+    "adds  r3,  r3, r1\n"               // R3 = &SampleBuf.sample[index] - offsetof(SampleBuf_Type, sample)
+
+ /* Determine the stack used for stacking on exception entry (see FaultRecord) and put
+    the address of the state context into R0 */
+    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
+    "lsrs  r0,  r0, #3\n"               // Shift bit [2] (SPSEL) into Carry flag
+    "bcc   sample_msp_used\n"           // If    bit [2] (SPSEL) == 0, MSP or MSP_NS was used
+                                        // If    bit [2] (SPSEL) == 1, PSP or PSP_NS was used
+#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
+    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
+    "lsrs  r0,  r0, #7\n"               // Shift   bit [6] (S) into Carry flag
+    "bcs   sample_load_psp\n"           // If      bit [6] (S) == 1, jump to load PSP
+    "mrs   r0,  psp_ns\n"               // else if bit [6] (S) == 0, R0 = PSP_NS
+    "b     sample_sp_loaded\n"
+  "sample_load_psp:\n"
+#endif
+    "mrs   r0,  psp\n"                  // R0 = PSP
+    "b     sample_sp_loaded\n"
+  "sample_msp_used:\n"
+#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
+    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
+    "lsrs  r0,  r0, #7\n"               // Shift   bit [6] (S) into Carry flag
+    "bcs   sample_load_msp\n"           // If      bit [6] (S) == 1, jump to load MSP
+    "mrs   r0,  msp_ns\n"               // else if bit [6] (S) == 0, R0 = MSP_NS
+    "b     sample_sp_loaded\n"
+  "sample_load_msp:\n"
+#endif
+    "mrs   r0,  msp\n"                  // R0 = MSP
+  "sample_sp_loaded:\n"
+
+#if (FR_ARCH_ARMV8x_M != 0)             // If arch is Armv8/8.1-M
+#if (FR_SECURE != 0)                    // If code was compiled for and is running in Secure World
+    "mov   r1,  lr\n"                   // R1 = LR (EXC_RETURN)
+    "lsrs  r1,  r1, #6\n"               // Shift   bit [5] (DCRS) into Carry flag
+    "bcs   sample_load\n"               // If      bit [5] (DCRS) == 1, only state context was stacked
+    "adds  r0,  #40\n"                  // else if bit [5] (DCRS) == 0, skip additional state context
+#elif (defined(__SAUREGION_PRESENT) && (__SAUREGION_PRESENT != 0)) // Else if running in Non-secure World of device with TrustZone
+    "mov   r1,  lr\n"                   // R1 = LR (EXC_RETURN)
+    "lsrs  r1,  r1, #7\n"               // Shift   bit [6] (S) into Carry flag
+    "bcc   sample_load\n"               // If      bit [6] (S) == 0, Non-secure stack was used
+    "movs  r1,  #0\n"                   // else if bit [6] (S) == 1, Secure stack is not accessible,
+    "movs  r2,  #0\n"                   //                           store 0 as PC and LR
+    "b     sample_store\n"
+#endif
+#endif
+
+ /* Store stacked ReturnAddress and LR into the ring buffer entry */
+  "sample_load:\n"
+    "ldr   r1,  [r0, %[pc_ofs]]\n"      // R1 = stacked ReturnAddress
+    "ldr   r2,  [r0, %[lr_ofs]]\n"      // R2 = stacked LR
+  "sample_store:\n"
+    "str   r1,  [r3, %[sample_pc_ofs]]\n"
+    "str   r2,  [r3, %[sample_lr_ofs]]\n"
+
+    "ldr   r0,  =FaultRecordSampleOnExit\n"
+    "bx    r0\n"                        // Branch to FaultRecordSampleOnExit function (LR is preserved)
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [SampleBuf_addr]                    "i"     (&SampleBuf)
+  , [count_ofs]                         "i"     (offsetof(SampleBuf_Type, count))
+  , [sample_mask]                       "i"     (FR_SAMPLE_NUM - 1U)
+  , [sample_pc_ofs]                     "i"     (offsetof(SampleBuf_Type, sample[0].pc))
+  , [sample_lr_ofs]                     "i"     (offsetof(SampleBuf_Type, sample[0].lr))
+  , [pc_ofs]                            "i"     (offsetof(StateContext_Type, ReturnAddress))
+  , [lr_ofs]                            "i"     (offsetof(StateContext_Type, LR))
+ :  /* clobber list */
+    "r0", "r1", "r2", "r3", "cc", "memory");
+#else
+  __ASM volatile (
+    "ldr   r0,  =FaultRecordSampleOnExit\n"
+    "bx    r0\n"                        // Sampling disabled, branch to FaultRecordSampleOnExit function
+ :::
+    "r0");
+#endif
+  //lint --flb "Library End (excluded from MISRA check)"
+}
+
+/**
+  Check stack headroom and record stack near-miss (stack monitor).
+  Must be called from periodic timer interrupt handler (for example SysTick) with
+  preserved Link Register value, typically by branching to this function, or used
+  as the handler directly. MSP and PSP are compared against their limit (set by
+  FaultRecordStackMonitorLimit, or MSPLIM and PSPLIM on Armv8/8.1-M) plus
+  FR_STACK_MONITOR_HEADROOM. If a stack pointer is below, the interrupted context is
+  recorded as stack near-miss (StackMonitorRecord), on the emergency stack if enabled.
+  Then the FaultRecordStackMonitorOnExit function is branched to.
+*/
+__NAKED void FaultRecordStackMonitor (void) {
+  //lint ++flb "Library Begin (excluded from MISRA check)"
+#if (FR_STACK_MONITOR_EXIST != 0)
+  __ASM volatile (
+#ifndef __ICCARM__
+    ".syntax unified\n\t"
+#endif
+
+ /* Determine address of the stack monitor state of the current core into R3 */
+    "ldr   r3,  =%c[StackMonitor_addr]\n" // R3 = &StackMonitor[0]
+#if (FR_CORE_NUM > 1U)
+    "ldr   r0,  =%c[core_id_addr]\n"    // R0 = core ID register address
+    "ldr   r1,  [r0]\n"                 // R1 = core ID register value
+#if (FR_CORE_ID_POS != 0U)
+    "lsrs  r1,  r1, %[core_id_pos]\n"   // R1 >>= FR_CORE_ID_POS
+#endif
+    "ldr   r0,  =%c[core_id_msk]\n"     // R0 = FR_CORE_ID_MSK
+    "ands  r1,  r0\n"                   // R1 = core ID
+    "cmp   r1,  %[core_id_max]\n"       // If      core ID <= (FR_CORE_NUM - 1), use it
+    "bls   monitor_core_id_valid\n"
+    "movs  r1,  %[core_id_max]\n"       // else if core ID is out of range, use last slot
+  "monitor_core_id_valid:\n"
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+    "mov   r12, r1\n"                   // R12 = core ID (emergency stack of the core)
+#endif
+    "movs  r0,  %[StackMonitor_slot_size]\n"
+    "muls  r0,  r1, r0\n"
+    "adds  r3,  r3, r0\n"               // R3 = &StackMonitor[core ID]
+#endif
+
+ /* Collect the stacks below their threshold (limit + FR_STACK_MONITOR_HEADROOM) into R1,
+    a threshold of 0 is never reached (stack not monitored) */
+    "movs  r1,  #0\n"                   // R1 = 0 (no stack below its threshold)
+    "ldr   r2,  [r3, %[msp_threshold_ofs]]\n" // R2 = MSP threshold
+#if (FR_ARCH_ARMV8x_M != 0)             // If arch is Armv8/8.1-M
+    "cmp   r2,  #0\n"
+    "bne   monitor_msp_check\n"         // If      MSP limit was set, use it
+    "mrs   r2,  msplim\n"               // else if MSP limit was not set, R2 = MSPLIM
+    "cmp   r2,  #0\n"
+    "beq   monitor_psp\n"               // If MSPLIM == 0, MSP is not monitored
+    "ldr   r0,  =%c[headroom]\n"
+    "adds  r2,  r2, r0\n"               // R2 = MSPLIM + FR_STACK_MONITOR_HEADROOM
+  "monitor_msp_check:\n"
+#endif
+    "mrs   r0,  msp\n"                  // R0 = MSP
+    "cmp   r0,  r2\n"
+    "bcs   monitor_psp\n"               // If MSP >= threshold, check PSP
+    "adds  r1,  %[below_msp]\n"         // MSP is below its threshold
+
+  "monitor_psp:\n"
+    "ldr   r2,  [r3, %[psp_threshold_ofs]]\n" // R2 = PSP threshold
+#if (FR_ARCH_ARMV8x_M != 0)             // If arch is Armv8/8.1-M
+    "cmp   r2,  #0\n"
+    "bne   monitor_psp_check\n"         // If      PSP limit was set, use it
+    "mrs   r2,  psplim\n"               // else if PSP limit was not set, R2 = PSPLIM
+    "cmp   r2,  #0\n"
+    "beq   monitor_below\n"             // If PSPLIM == 0, PSP is not monitored
+    "ldr   r0,  =%c[headroom]\n"
+    "adds  r2,  r2, r0\n"               // R2 = PSPLIM + FR_STACK_MONITOR_HEADROOM
+  "monitor_psp_check:\n"
+#endif
+    "mrs   r0,  psp\n"                  // R0 = PSP
+    "cmp   r0,  r2\n"
+    "bcs   monitor_below\n"             // If PSP >= threshold, done
+    "adds  r1,  %[below_psp]\n"         // PSP is below its threshold
+
+  "monitor_below:\n"
+    "cmp   r1,  #0\n"
+    "bne   monitor_record\n"            // If a stack is below its threshold, record near-miss
+    "str   r1,  [r3, %[below_ofs]]\n"   // No stack below its threshold (next crossing is a new event)
+
+  "monitor_exit:\n"
+    "ldr   r0,  =FaultRecordStackMonitorOnExit\n"
+    "bx    r0\n"                        // Branch to FaultRecordStackMonitorOnExit function (LR is preserved)
+
+ /* Record near-miss: call StackMonitorRecord(EXC_RETURN, below, MSP, MSPLIM) */
+  "monitor_record:\n"
+    "mrs   r2,  msp\n"                  // R2 = MSP
+#if (FR_ARCH_ARMV8x_M != 0)
+    "mrs   r3,  msplim\n"               // R3 = MSPLIM
+#endif
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+ /* Switch MSP (and MSPLIM) to the emergency stack of the current core, so that the stack
+    which is below its threshold is not used for recording. MSPLIM is 0 while switching. */
+#if (FR_ARCH_ARMV8x_M != 0)
+    "movs  r0,  #0\n"
+    "msr   msplim, r0\n"                // MSPLIM = 0
+#endif
+#if (FR_CORE_NUM > 1U)
+    "mov   r0,  r12\n"                  // R0 = core ID
 #endif
+    "mov   r12, lr\n"                   // R12 = LR (EXC_RETURN)
+    "mov   lr,  r1\n"                   // LR  = R1 (stacks below their threshold)
+#if (FR_CORE_NUM > 1U)
+    "ldr   r1,  =%c[FaultStack_size]\n"
+    "muls  r0,  r1, r0\n"               // R0 = core ID * FR_EMERGENCY_STACK_SIZE
+    "ldr   r1,  =%c[FaultStack_addr]\n"
+    "adds  r0,  r0, r1\n"               // R0 = emergency stack base of the core
+#else
+    "ldr   r0,  =%c[FaultStack_addr]\n" // R0 = emergency stack base
 #endif
+    "ldr   r1,  =%c[FaultStack_size]\n"
+    "adds  r1,  r1, r0\n"               // R1 = emergency stack top
+    "msr   msp, r1\n"                   // MSP = emergency stack top
 #if (FR_ARCH_ARMV8x_M != 0)
-  , [FaultInfo_additonal_ctx_addr]      "i"     (&FaultInfo.additonal_state_context)
-  , [FaultInfo_armv8_m_regs_addr]       "i"     (&FaultInfo.armv8_m_registers)
+    "msr   msplim, r0\n"                // MSPLIM = emergency stack base
 #endif
-#if (FR_ARCH_ARMV8x_M_MAIN !=0)
-  , [FaultInfo_armv8_m_fault_regs_addr] "i"     (&FaultInfo.armv8_m_fault_registers)
-  , [sfsr_ofs]                          "i"     (offsetof(SCB_Type, SFSR ))
-  , [sfar_ofs]                          "i"     (offsetof(SCB_Type, SFAR ))
+    "mov   r1,  lr\n"                   // Restore R1 from LR
+    "mov   lr,  r12\n"                  // Restore LR from R12
+#endif
+    "mov   r0,  lr\n"                   // R0 = LR (EXC_RETURN)
+    "push  {r0, r1, r2, r3}\n"          // Save EXC_RETURN, MSP and MSPLIM (parameters)
+    "ldr   r0,  =%c[StackMonitorRecord_addr]\n"
+    "mov   r12, r0\n"                   // R12 = address of StackMonitorRecord function
+    "ldr   r0,  [sp]\n"                 // R0 = EXC_RETURN
+    "blx   r12\n"                       // Call StackMonitorRecord function
+    "pop   {r0, r1, r2, r3}\n"
+    "mov   lr,  r0\n"                   // Restore LR (EXC_RETURN)
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+ /* Switch MSP (and MSPLIM) back */
+#if (FR_ARCH_ARMV8x_M != 0)
+    "movs  r0,  #0\n"
+    "msr   msplim, r0\n"                // MSPLIM = 0
+#endif
+    "msr   msp, r2\n"                   // Restore MSP
+#if (FR_ARCH_ARMV8x_M != 0)
+    "msr   msplim, r3\n"                // Restore MSPLIM
+#endif
+#endif
+    "b     monitor_exit\n"
+
+ /* Inline assembly template operands */
+ :  /* no outputs */
+ :  /* inputs */
+    [StackMonitor_addr]                 "i"     (&StackMonitor[0])
+  , [msp_threshold_ofs]                 "i"     (offsetof(StackMonitor_Type, msp_threshold))
+  , [psp_threshold_ofs]                 "i"     (offsetof(StackMonitor_Type, psp_threshold))
+  , [below_ofs]                         "i"     (offsetof(StackMonitor_Type, below))
+  , [below_msp]                         "i"     (1U << FR_STACK_MONITOR_MSP)
+  , [below_psp]                         "i"     (1U << FR_STACK_MONITOR_PSP)
+  , [StackMonitorRecord_addr]           "i"     (&StackMonitorRecord)
+#if (FR_ARCH_ARMV8x_M != 0)
+  , [headroom]                          "i"     (FR_STACK_MONITOR_HEADROOM)
+#endif
+#if (FR_EMERGENCY_STACK_SIZE != 0U)
+  , [FaultStack_addr]                   "i"     (&FaultStack[0][0])
+  , [FaultStack_size]                   "i"     (FR_EMERGENCY_STACK_SIZE)
+#endif
+#if (FR_CORE_NUM > 1U)
+  , [core_id_addr]                      "i"     (FR_CORE_ID_ADDR)
+  , [core_id_pos]                       "i"     (FR_CORE_ID_POS)
+  , [core_id_msk]                       "i"     (FR_CORE_ID_MSK)
+  , [core_id_max]                       "i"     (FR_CORE_NUM - 1U)
+  , [StackMonitor_slot_size]            "i"     (sizeof(StackMonitor_Type))
 #endif
-  , [crc_init_val]                      "i"     (FR_CRC32_INIT_VAL)
-  , [crc_data_ptr]                      "i"     (FR_CRC32_DATA_PTR)
-  , [crc_data_len]                      "i"     (FR_CRC32_DATA_LEN)
-  , [crc_polynom]                       "i"     (FR_CRC32_POLYNOM)
  :  /* clobber list */
-    "r0", "r1", "r2", "r3", "r4", "r12", "lr" , "cc", "memory");
+    "r0", "r1", "r2", "r3", "r12", "lr", "cc", "memory");
+#else
+  __ASM volatile (
+    "ldr   r0,  =FaultRecordStackMonitorOnExit\n"
+    "bx    r0\n"                        // Stack monitor disabled, branch to FaultRecordStackMonitorOnExit function
+ :::
+    "r0");
+#endif
   //lint --flb "Library End (excluded from MISRA check)"
 }
 
 /**
-  Print the recorded fault information.
-  Should be called when system is running in normal operating mode with
-  standard input/output fully functional.
+  Print fault information of one FaultInfo slot.
+  \param[in]    ptr_fi          pointer to fault information
 */
-void FaultRecordPrint (void) {
+static void FaultInfoPrint (const FaultInfo_Type *ptr_fi) {
   int8_t fault_info_valid = 0;
   int8_t state_context_valid = 1;
 
   // Check if magic number is valid
-  if (FaultInfo.magic_number == FR_MAGIC_NUMBER) {
-    const FaultInfoType_Type *ptr_fi_type = &FaultInfo.type;
+  if (FR_FAULT_INFO_COMPLETE(ptr_fi)) {
+    const FaultInfoType_Type *ptr_fi_type = &ptr_fi->type;
 
     fault_info_valid = 1;
-    FR_PRINT("\n--- Last recorded Fault information (v%u.%u) ---\n\n", ptr_fi_type->version.major, ptr_fi_type->version.minor);
+    if (ptr_fi_type->near_miss != 0U) {
+      FR_PRINT("\n--- Recorded stack near-miss (v%u.%u) ---\n\n", ptr_fi_type->version.major, ptr_fi_type->version.minor);
+    } else {
+      FR_PRINT("\n--- Last recorded Fault information (v%u.%u) ---\n\n", ptr_fi_type->version.major, ptr_fi_type->version.minor);
+    }
   }
 
   // Check if CRC of the FaultInfo is correct
   if (fault_info_valid != 0) {
-    if (FaultInfo.crc32 != CalcCRC32(FR_CRC32_INIT_VAL, (const uint8_t *)FR_CRC32_DATA_PTR, FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM)) {
+    if (ptr_fi->crc32 != CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_fi), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM)) {
       fault_info_valid = 0;
       FR_PRINT("\n  Invalid CRC of the recorded fault information !!!\n\n");
     }
@@ -599,19 +1840,19 @@ void FaultRecordPrint (void) {
 
   // Check if state context was stacked properly if CFSR is available
 #if (FR_FAULT_REGS_EXIST != 0)
-  if ((FaultInfo.fault_registers.SCB_CFSR & (SCB_CFSR_Stack_Err_Msk)) != 0U) {
+  if ((ptr_fi->fault_registers.SCB_CFSR & (SCB_CFSR_Stack_Err_Msk)) != 0U) {
     state_context_valid = 0;
   }
 #endif
 
   // Decode: Exception which recorded the fault information
   if (fault_info_valid != 0) {
-    uint32_t exc_num = FaultInfo.common_registers.xPSR & IPSR_ISR_Msk;
+    uint32_t exc_num = ptr_fi->common_registers.xPSR & IPSR_ISR_Msk;
 
     FR_PRINT("  Exception Handler: ");
 
 #if (FR_ARCH_ARMV8x_M != 0)
-    if (FaultInfo.type.secure != 0U) {
+    if (ptr_fi->type.secure != 0U) {
       FR_PRINT("Secure - ");
     } else {
       FR_PRINT("Non-Secure - ");
@@ -635,17 +1876,39 @@ void FaultRecordPrint (void) {
         FR_PRINT("SecureFault");
         break;
       default:
-        FR_PRINT("unknown, exception number = %u", exc_num);
+        if (ptr_fi->type.hang != 0U) {
+          FR_PRINT("Watchdog early warning, exception number = %u", exc_num);
+        } else if (ptr_fi->type.near_miss != 0U) {
+          FR_PRINT("Stack monitor, exception number = %u", exc_num);
+        } else {
+          FR_PRINT("unknown, exception number = %u", exc_num);
+        }
         break;
     }
 
     FR_PRINT("\n");
   }
 
+  // Decode: Hang (recorded by FaultRecordHang instead of a fault)
+  if ((fault_info_valid != 0) && (ptr_fi->type.hang != 0U) && (state_context_valid != 0)) {
+    FR_PRINT("  Hang:              code at 0x%08X (LR = 0x%08X) did not service the watchdog\n",
+             ptr_fi->state_context.ReturnAddress, ptr_fi->state_context.LR);
+  }
+
+#if (FR_STACK_MONITOR_EXIST != 0)
+  // Decode: Stack near-miss (recorded by FaultRecordStackMonitor instead of a fault)
+  if ((fault_info_valid != 0) && (ptr_fi->type.near_miss != 0U)) {
+    const StackNearMiss_Type *ptr_nm = &ptr_fi->near_miss;
+
+    FR_PRINT("  Stack near-miss:   %s headroom %d bytes to limit 0x%08X (event %u)\n",
+             (ptr_nm->stack == FR_STACK_MONITOR_PSP) ? "PSP" : "MSP", ptr_nm->headroom, ptr_nm->limit, ptr_nm->event);
+  }
+#endif
+
 #if (FR_ARCH_ARMV8x_M != 0)
   // Decode: State in which fault occurred
   if (fault_info_valid != 0) {
-    uint32_t exc_return = FaultInfo.common_registers.EXC_RETURN;
+    uint32_t exc_return = ptr_fi->common_registers.EXC_RETURN;
 
     FR_PRINT("  State:             ");
 
@@ -661,7 +1924,7 @@ void FaultRecordPrint (void) {
 
   // Decode: Mode in which fault occurred
   if (fault_info_valid != 0) {
-    uint32_t exc_return = FaultInfo.common_registers.EXC_RETURN;
+    uint32_t exc_return = ptr_fi->common_registers.EXC_RETURN;
 
     FR_PRINT("  Mode:              ");
 
@@ -674,10 +1937,35 @@ void FaultRecordPrint (void) {
     FR_PRINT("\n");
   }
 
+#if (FR_RECORD_INFO_EXIST != 0)
+  // Print: Core and timestamp of recording
+  if ((fault_info_valid != 0) && (ptr_fi->type.record_info != 0U)) {
+#if (FR_CORE_NUM > 1U)
+    FR_PRINT("  Core:              %u\n", ptr_fi->record_info.core_id);
+#endif
+#ifdef FR_TIMESTAMP_ADDR
+    FR_PRINT("  Timestamp:         0x%08X\n", ptr_fi->record_info.timestamp);
+#endif
+  }
+#endif
+
+#if (FR_BUILD_ID_EXIST != 0)
+  // Print: Build ID of the firmware that recorded the fault
+  if ((fault_info_valid != 0) && (ptr_fi->type.build_id != 0U)) {
+    uint32_t i;
+
+    FR_PRINT("  Build ID:          ");
+    for (i = 0U; i < FR_BUILD_ID_LEN; i++) {
+      FR_PRINT("%02x", ptr_fi->build_id[i]);
+    }
+    FR_PRINT("\n");
+  }
+#endif
+
 #if (FR_FAULT_REGS_EXIST != 0)
   /* Decode: HardFault */
-  if ((fault_info_valid != 0) && (FaultInfo.type.fault_regs != 0U)) {
-    uint32_t scb_hfsr = FaultInfo.fault_registers.SCB_HFSR;
+  if ((fault_info_valid != 0) && (ptr_fi->type.fault_regs != 0U)) {
+    uint32_t scb_hfsr = ptr_fi->fault_registers.SCB_HFSR;
 
     if ((scb_hfsr & (SCB_HFSR_VECTTBL_Msk   |
                      SCB_HFSR_FORCED_Msk    |
@@ -700,9 +1988,9 @@ void FaultRecordPrint (void) {
   }
 
   /* Decode: MemManage fault */
-  if ((fault_info_valid != 0) && (FaultInfo.type.fault_regs != 0U)) {
-    uint32_t scb_cfsr  = FaultInfo.fault_registers.SCB_CFSR;
-    uint32_t scb_mmfar = FaultInfo.fault_registers.SCB_MMFAR;
+  if ((fault_info_valid != 0) && (ptr_fi->type.fault_regs != 0U)) {
+    uint32_t scb_cfsr  = ptr_fi->fault_registers.SCB_CFSR;
+    uint32_t scb_mmfar = ptr_fi->fault_registers.SCB_MMFAR;
 
     if ((scb_cfsr & (SCB_CFSR_IACCVIOL_Msk  |
                      SCB_CFSR_DACCVIOL_Msk  |
@@ -740,9 +2028,9 @@ void FaultRecordPrint (void) {
   }
 
   /* Decode: BusFault */
-  if ((fault_info_valid != 0) && (FaultInfo.type.fault_regs != 0U)) {
-    uint32_t scb_cfsr = FaultInfo.fault_registers.SCB_CFSR;
-    uint32_t scb_bfar = FaultInfo.fault_registers.SCB_BFAR;
+  if ((fault_info_valid != 0) && (ptr_fi->type.fault_regs != 0U)) {
+    uint32_t scb_cfsr = ptr_fi->fault_registers.SCB_CFSR;
+    uint32_t scb_bfar = ptr_fi->fault_registers.SCB_BFAR;
 
     if ((scb_cfsr & (SCB_CFSR_IBUSERR_Msk     |
                      SCB_CFSR_PRECISERR_Msk   |
@@ -784,8 +2072,8 @@ void FaultRecordPrint (void) {
   }
 
   /* Decode: UsageFault */
-  if ((fault_info_valid != 0) && (FaultInfo.type.fault_regs != 0U)) {
-    uint32_t scb_cfsr = FaultInfo.fault_registers.SCB_CFSR;
+  if ((fault_info_valid != 0) && (ptr_fi->type.fault_regs != 0U)) {
+    uint32_t scb_cfsr = ptr_fi->fault_registers.SCB_CFSR;
 
     if ((scb_cfsr & (SCB_CFSR_UNDEFINSTR_Msk |
                      SCB_CFSR_INVSTATE_Msk   |
@@ -827,11 +2115,51 @@ void FaultRecordPrint (void) {
     }
   }
 
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+  /* Decode: Pointer authentication or branch target identification failure (INVSTATE UsageFault) */
+  if ((fault_info_valid != 0) && (ptr_fi->type.armv81m != 0U) &&
+      ((ptr_fi->fault_registers.SCB_CFSR & SCB_CFSR_INVSTATE_Msk) != 0U)) {
+    uint32_t control = ptr_fi->armv8_1_m_registers.CONTROL;
+    uint32_t pac_en, bti_en;
+
+    // Enables of the privilege level of the faulting code (Handler mode is privileged)
+    if (((ptr_fi->common_registers.EXC_RETURN & (1UL << 3)) != 0U) && ((control & CONTROL_nPRIV_Msk) != 0U)) {
+      pac_en = control & CONTROL_UPAC_EN_Msk;
+      bti_en = control & CONTROL_UBTI_EN_Msk;
+    } else {
+      pac_en = control & CONTROL_PAC_EN_Msk;
+      bti_en = control & CONTROL_BTI_EN_Msk;
+    }
+
+    if ((bti_en != 0U) && (state_context_valid != 0) && ((ptr_fi->state_context.xPSR & xPSR_B_Msk) != 0U)) {
+      FR_PRINT("  PACBTI:            Branch target identification failure (indirect branch to an instruction that is not a BTI landing pad)\n");
+    } else if (pac_en != 0U) {
+      FR_PRINT("  PACBTI:            Pointer authentication failure likely (AUT/BXAUT/AUTG check failed, return address or pointer corrupted)\n");
+    }
+  }
+
+#ifdef SCB_RFSR_V_Msk
+  /* Decode: RAS error */
+  if ((fault_info_valid != 0) && (ptr_fi->type.armv81m != 0U)) {
+    uint32_t scb_rfsr = ptr_fi->armv8_1_m_registers.SCB_RFSR;
+    static const char *const uet_name[] = {
+      "uncontainable", "unrecoverable", "restartable", "recoverable"
+    };
+
+    if ((scb_rfsr & SCB_RFSR_V_Msk) != 0U) {
+      FR_PRINT("  Fault:             RAS error - %s error (UET), syndrome 0x%04X\n",
+               uet_name[(scb_rfsr & SCB_RFSR_UET_Msk) >> SCB_RFSR_UET_Pos],
+               (scb_rfsr & SCB_RFSR_IS_Msk) >> SCB_RFSR_IS_Pos);
+    }
+  }
+#endif
+#endif
+
 #if (FR_ARCH_ARMV8x_M_MAIN != 0)
   /* Decode: SecureFault */
-  if ((fault_info_valid != 0) && (FaultInfo.type.secure != 0U)) {
-    uint32_t scb_sfsr = FaultInfo.armv8_m_fault_registers.SCB_SFSR;
-    uint32_t scb_sfar = FaultInfo.armv8_m_fault_registers.SCB_SFAR;
+  if ((fault_info_valid != 0) && (ptr_fi->type.secure != 0U)) {
+    uint32_t scb_sfsr = ptr_fi->armv8_m_fault_registers.SCB_SFSR;
+    uint32_t scb_sfar = ptr_fi->armv8_m_fault_registers.SCB_SFAR;
 
     if ((scb_sfsr & (SAU_SFSR_INVEP_Msk   |
                      SAU_SFSR_INVIS_Msk   |
@@ -881,33 +2209,38 @@ void FaultRecordPrint (void) {
 
 #if (FR_FAULT_REGS_EXIST != 0)
     FR_PRINT("   - PC:             ");
-    if ((FaultInfo.fault_registers.SCB_CFSR & (SCB_CFSR_Stack_Err_Msk)) == 0U) {
-      FR_PRINT("0x%08X\n", FaultInfo.state_context.ReturnAddress);
+    if ((ptr_fi->fault_registers.SCB_CFSR & (SCB_CFSR_Stack_Err_Msk)) == 0U) {
+      FR_PRINT("0x%08X\n", ptr_fi->state_context.ReturnAddress);
     } else {
       FR_PRINT("unknown\n");
     }
 #else
-    FR_PRINT("   - PC:             0x%08X\n", FaultInfo.state_context.ReturnAddress);
+    FR_PRINT("   - PC:             0x%08X\n", ptr_fi->state_context.ReturnAddress);
 #endif
-    FR_PRINT("   - MSP:            0x%08X\n", FaultInfo.common_registers.MSP);
+    FR_PRINT("   - MSP:            0x%08X\n", ptr_fi->common_registers.MSP);
 #if (FR_ARCH_ARMV8x_M     != 0)
 #if (FR_ARCH_ARMV8_M_BASE != 0)
-    if ((FaultInfo.common_registers.EXC_RETURN & EXC_RETURN_S) != 0) {
-      FR_PRINT("   - MSPLIM:         0x%08X\n", FaultInfo.armv8_m_registers.MSPLIM);
+    if ((ptr_fi->common_registers.EXC_RETURN & EXC_RETURN_S) != 0) {
+      FR_PRINT("   - MSPLIM:         0x%08X\n", ptr_fi->armv8_m_registers.MSPLIM);
     }
 #else
-    FR_PRINT("   - MSPLIM:         0x%08X\n", FaultInfo.armv8_m_registers.MSPLIM);
+    FR_PRINT("   - MSPLIM:         0x%08X\n", ptr_fi->armv8_m_registers.MSPLIM);
 #endif
 #endif
-    FR_PRINT("   - PSP:            0x%08X\n", FaultInfo.common_registers.PSP);
+    FR_PRINT("   - PSP:            0x%08X\n", ptr_fi->common_registers.PSP);
 #if (FR_ARCH_ARMV8x_M     != 0)
 #if (FR_ARCH_ARMV8_M_BASE != 0)
-    if ((FaultInfo.common_registers.EXC_RETURN & EXC_RETURN_S) != 0) {
-      FR_PRINT("   - PSPLIM:         0x%08X\n", FaultInfo.armv8_m_registers.PSPLIM);
+    if ((ptr_fi->common_registers.EXC_RETURN & EXC_RETURN_S) != 0) {
+      FR_PRINT("   - PSPLIM:         0x%08X\n", ptr_fi->armv8_m_registers.PSPLIM);
     }
 #else
-    FR_PRINT("   - PSPLIM:         0x%08X\n", FaultInfo.armv8_m_registers.PSPLIM);
+    FR_PRINT("   - PSPLIM:         0x%08X\n", ptr_fi->armv8_m_registers.PSPLIM);
 #endif
+#endif
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+    if (ptr_fi->type.armv81m != 0U) {
+      FR_PRINT("   - CONTROL:        0x%08X\n", ptr_fi->armv8_1_m_registers.CONTROL);
+    }
 #endif
 
     FR_PRINT("\n");
@@ -915,7 +2248,7 @@ void FaultRecordPrint (void) {
 
   /* Print state context information */
   if ((fault_info_valid != 0) && (state_context_valid != 0))  {
-    const StateContext_Type *ptr_state_ctx = &FaultInfo.state_context;
+    const StateContext_Type *ptr_state_ctx = &ptr_fi->state_context;
 
     FR_PRINT("  Exception stacked state context:\n");
     FR_PRINT("   - R0:             0x%08X\n", ptr_state_ctx->R0);
@@ -925,9 +2258,9 @@ void FaultRecordPrint (void) {
   }
 
 #if (FR_ARCH_ARMV8x_M != 0)
-  if ((fault_info_valid != 0) && (state_context_valid != 0) && (FaultInfo.type.armv8m != 0U))  {
+  if ((fault_info_valid != 0) && (state_context_valid != 0) && (ptr_fi->type.armv8m != 0U))  {
     /* Print additional state context (if it exists) */
-    const AdditionalStateContext_Type *ptr_asc = &FaultInfo.additonal_state_context;
+    const AdditionalStateContext_Type *ptr_asc = &ptr_fi->additonal_state_context;
 
     if ((ptr_asc->IntegritySignature & 0xFFFFFFFEU) == FR_ASC_INTEGRITY_SIG) {
       FR_PRINT("   - R4:             0x%08X\n", ptr_asc->R4);
@@ -943,7 +2276,7 @@ void FaultRecordPrint (void) {
 #endif
 
   if ((fault_info_valid != 0) && (state_context_valid != 0))  {
-    const StateContext_Type *ptr_state_ctx = &FaultInfo.state_context;
+    const StateContext_Type *ptr_state_ctx = &ptr_fi->state_context;
 
     FR_PRINT("   - R12:            0x%08X\n", ptr_state_ctx->R12);
     FR_PRINT("   - LR:             0x%08X\n", ptr_state_ctx->LR);
@@ -953,44 +2286,2321 @@ void FaultRecordPrint (void) {
     FR_PRINT("\n");
   }
 
-#if (FR_FAULT_REGS_EXIST  != 0)
-  /* Print fault registers */
-  if (fault_info_valid != 0) {
-    const FaultRegisters_Type *ptr_fault_regs = &FaultInfo.fault_registers;
-
-    FR_PRINT("  Fault registers:\n");
+#if (FR_EXT_CONTEXT_EXIST != 0)
+  /* Print extended (floating-point/MVE) context */
+  if ((fault_info_valid != 0) && (state_context_valid != 0) && (ptr_fi->type.ext_context != 0U) &&
+      (ptr_fi->extended_context.state != FR_EXT_CONTEXT_NONE)) {
+    const ExtendedContext_Type *ptr_ext_ctx = &ptr_fi->extended_context;
+    uint32_t i, num;
 
-    FR_PRINT("   - CFSR:           0x%08X\n", ptr_fault_regs->SCB_CFSR);
-    FR_PRINT("   - HFSR:           0x%08X\n", ptr_fault_regs->SCB_HFSR);
-    FR_PRINT("   - DFSR:           0x%08X\n", ptr_fault_regs->SCB_DFSR);
+    if (ptr_ext_ctx->state == FR_EXT_CONTEXT_NO_ACCESS) {
+      FR_PRINT("  Floating-point context: not available (lazy state preservation pending, FPU access disabled)\n");
+    } else {
+      if (ptr_ext_ctx->state == FR_EXT_CONTEXT_LAZY) {
+        FR_PRINT("  Floating-point context (read from registers, lazy state preservation pending):\n");
+      } else {
+        FR_PRINT("  Floating-point context:\n");
+      }
+      num = (ptr_ext_ctx->state == FR_EXT_CONTEXT_PARTIAL) ? 16U : 32U;
+#if (FR_MVE_EXIST != 0)
+      for (i = 0U; i < num; i += 4U) {
+        FR_PRINT("   - Q%u:             0x%08X%08X%08X%08X\n", i / 4U,
+                 ptr_ext_ctx->S[i + 3U], ptr_ext_ctx->S[i + 2U], ptr_ext_ctx->S[i + 1U], ptr_ext_ctx->S[i]);
+      }
+#else
+      for (i = 0U; i < num; i++) {
+        FR_PRINT("   - S%u:%s0x%08X\n", i, (i < 10U) ? "             " : "            ", ptr_ext_ctx->S[i]);
+      }
+#endif
+      if (num < 32U) {
+        FR_PRINT("   - S16..S31:       not available (FPU access disabled)\n");
+      }
+      FR_PRINT("   - FPSCR:          0x%08X\n", ptr_ext_ctx->FPSCR);
+#if (FR_MVE_EXIST != 0)
+      FR_PRINT("   - VPR:            0x%08X\n", ptr_ext_ctx->VPR);
+#endif
+    }
+
+    FR_PRINT("\n");
+  }
+#endif
+
+#if (FR_FAULT_REGS_EXIST  != 0)
+  /* Print fault registers */
+  if (fault_info_valid != 0) {
+    const FaultRegisters_Type *ptr_fault_regs = &ptr_fi->fault_registers;
+
+    FR_PRINT("  Fault registers:\n");
+
+    FR_PRINT("   - CFSR:           0x%08X\n", ptr_fault_regs->SCB_CFSR);
+    FR_PRINT("   - HFSR:           0x%08X\n", ptr_fault_regs->SCB_HFSR);
+    FR_PRINT("   - DFSR:           0x%08X\n", ptr_fault_regs->SCB_DFSR);
     FR_PRINT("   - MMFAR:          0x%08X\n", ptr_fault_regs->SCB_MMFAR);
     FR_PRINT("   - BFAR:           0x%08X\n", ptr_fault_regs->SCB_BFAR);
     FR_PRINT("   - AFSR:           0x%08X\n", ptr_fault_regs->SCB_AFSR);
 #if (FR_ARCH_ARMV8x_M_MAIN != 0)
-    if (FaultInfo.type.secure != 0U) {
-      const Armv8mFaultRegisters_Type *ptr_armv8_m_regs = &FaultInfo.armv8_m_fault_registers;
+    if (ptr_fi->type.secure != 0U) {
+      const Armv8mFaultRegisters_Type *ptr_armv8_m_regs = &ptr_fi->armv8_m_fault_registers;
 
       FR_PRINT("   - SFSR:           0x%08X\n", ptr_armv8_m_regs->SCB_SFSR);
       FR_PRINT("   - SFAR:           0x%08X\n", ptr_armv8_m_regs->SCB_SFAR);
     }
 #endif
+#if ((FR_ARCH_ARMV8_1_M_MAIN != 0) && defined(SCB_RFSR_V_Msk))
+    if (ptr_fi->type.armv81m != 0U) {
+      FR_PRINT("   - RFSR:           0x%08X\n", ptr_fi->armv8_1_m_registers.SCB_RFSR);
+    }
+#endif
+
+    FR_PRINT("\n");
+  }
+#endif
+
+#if (FR_BACKTRACE_EXIST != 0)
+  /* Print backtrace (candidate call chain) */
+  if ((fault_info_valid != 0) && (ptr_fi->type.backtrace != 0U) && (ptr_fi->backtrace.sp != 0U)) {
+    const Backtrace_Type *ptr_bt = &ptr_fi->backtrace;
+    uint32_t i, cnt;
+
+    cnt = ptr_bt->count;
+    if (cnt > FR_BACKTRACE_DEPTH) {
+      cnt = FR_BACKTRACE_DEPTH;
+    }
+
+    FR_PRINT("  Backtrace (candidates from stack scan starting at 0x%08X):\n", ptr_bt->sp);
+    for (i = 0U; i < cnt; i++) {
+      FR_PRINT("   - #%-2u             0x%08X\n", i, ptr_bt->addr[i]);
+    }
+    if (cnt == 0U) {
+      FR_PRINT("   - none found\n");
+    }
+
+    FR_PRINT("\n");
+  }
+#endif
+
+#if (FR_STACK_USAGE_EXIST != 0)
+  /* Print stack usage (high-water mark) */
+  if ((fault_info_valid != 0) && (ptr_fi->type.stack_usage != 0U)) {
+    const StackUsage_Type *ptr_su;
+    uint32_t i, end, scan_size;
+
+    FR_PRINT("  Stack usage:\n");
+
+    for (i = 0U; i < FR_STACK_NUM; i++) {
+      ptr_su = &ptr_fi->stack_usage[i];
+      if (ptr_su->size == 0U) {
+        continue;
+      }
+      end       = ptr_su->base + ptr_su->size;
+      scan_size = ptr_su->size;
+      if (scan_size > (FR_STACK_SCAN_WORDS * 4U)) {
+        scan_size = FR_STACK_SCAN_WORDS * 4U;
+      }
+
+      FR_PRINT("   - Stack %u:%s0x%08X..0x%08X, ", i, (i < 10U) ? "        " : "       ", ptr_su->base, end - 1U);
+      if (ptr_su->unused == 0U) {
+        FR_PRINT("used %u of %u bytes (overflow)", ptr_su->size, ptr_su->size);
+      } else if ((ptr_su->unused == scan_size) && (scan_size < ptr_su->size)) {
+        FR_PRINT("used at most %u of %u bytes (scan limit)", ptr_su->size - ptr_su->unused, ptr_su->size);
+      } else {
+        FR_PRINT("used %u of %u bytes", ptr_su->size - ptr_su->unused, ptr_su->size);
+      }
+
+      if ((ptr_fi->common_registers.MSP > ptr_su->base) && (ptr_fi->common_registers.MSP <= end)) {
+        FR_PRINT(", MSP");
+      }
+      if ((ptr_fi->common_registers.PSP > ptr_su->base) && (ptr_fi->common_registers.PSP <= end)) {
+        FR_PRINT(", PSP");
+      }
+#if (FR_ARCH_ARMV8x_M != 0)
+      // Report headroom of the lowest used address to the stack limit registers
+      if ((ptr_fi->armv8_m_registers.MSPLIM >= ptr_su->base) && (ptr_fi->armv8_m_registers.MSPLIM < end)) {
+        FR_PRINT(", MSPLIM headroom %d bytes", (int32_t)((ptr_su->base + ptr_su->unused) - ptr_fi->armv8_m_registers.MSPLIM));
+      }
+      if ((ptr_fi->armv8_m_registers.PSPLIM >= ptr_su->base) && (ptr_fi->armv8_m_registers.PSPLIM < end)) {
+        FR_PRINT(", PSPLIM headroom %d bytes", (int32_t)((ptr_su->base + ptr_su->unused) - ptr_fi->armv8_m_registers.PSPLIM));
+      }
+#endif
+      FR_PRINT("\n");
+    }
+
+    FR_PRINT("\n");
+  }
+#endif
+
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  /* Print exit action results (time taken by each action) */
+  if ((fault_info_valid != 0) && (ptr_fi->exit_actions[0].status != FR_EXIT_ACTION_NOT_RUN)) {
+    const ExitActionResult_Type *ptr_res;
+    uint32_t i;
+
+    FR_PRINT("  Exit actions:\n");
+
+    for (i = 0U; i < FR_EXIT_ACTION_NUM; i++) {
+      ptr_res = &ptr_fi->exit_actions[i];
+      switch (ptr_res->status) {
+        case FR_EXIT_ACTION_RUNNING:
+          FR_PRINT("   - Action %-2u       did not return (reset while executing)\n", i);
+          break;
+        case FR_EXIT_ACTION_DONE:
+          FR_PRINT("   - Action %-2u       %u ticks\n", i, ptr_res->elapsed);
+          break;
+        case FR_EXIT_ACTION_OVERRUN:
+          FR_PRINT("   - Action %-2u       %u ticks (budget exceeded)\n", i, ptr_res->elapsed);
+          break;
+        case FR_EXIT_ACTION_SKIP_FAULT:
+          FR_PRINT("   - Action %-2u       skipped (fault inside action code range)\n", i);
+          break;
+        case FR_EXIT_ACTION_SKIP_DEADLINE:
+          FR_PRINT("   - Action %-2u       skipped (budget exceeds deadline)\n", i);
+          break;
+        default:
+          break;
+      }
+    }
+
+    FR_PRINT("\n");
+  }
+#endif
+}
+
+/**
+  Print interrupted recording and nested fault information of one slot.
+  \param[in]    slot            FaultInfo and FaultNested slot index (core ID)
+*/
+static void FaultNestedPrint (uint32_t slot) {
+  static const char *const stage_name[] = {
+    "unknown", "entry", "state context", "registers", "backtrace", "stack usage", "CRC", "exit actions", "extended context"
+  };
+  const FaultNested_Type *ptr_fn = &FaultNested[slot];
+        uint32_t          stage;
+
+  // Recording that did not complete (nested fault, reset or lockup while recording)
+  if ((FaultInfo[slot].magic_number == FR_MAGIC_NUMBER_BUSY) ||
+      (FaultInfo[slot].magic_number == FR_MAGIC_NUMBER_ABORT)) {
+    stage = FaultInfo[slot].crc32;
+    if (stage >= (sizeof(stage_name) / sizeof(stage_name[0]))) {
+      stage = 0U;
+    }
+    FR_PRINT("\n--- Interrupted Fault recording ---\n\n");
+#if (FR_CORE_NUM > 1U)
+    FR_PRINT("  Core:              %u\n", slot);
+#endif
+    FR_PRINT("  Stage reached:     %s\n", stage_name[stage]);
+    FR_PRINT("\n");
+  }
 
+  // Fault that occurred while recording fault information
+  if (ptr_fn->magic_number == FR_MAGIC_NUMBER_NESTED) {
+    stage = ptr_fn->stage;
+    if (stage >= (sizeof(stage_name) / sizeof(stage_name[0]))) {
+      stage = 0U;
+    }
+    FR_PRINT("\n--- Nested fault (fault while recording fault information) ---\n\n");
+#if (FR_CORE_NUM > 1U)
+    FR_PRINT("  Core:              %u\n", slot);
+#endif
+    FR_PRINT("  Exception number:  %u\n", ptr_fn->xPSR & IPSR_ISR_Msk);
+    FR_PRINT("  Stage reached:     %s\n", stage_name[stage]);
+    if (ptr_fn->ReturnAddress != 0U) {
+      FR_PRINT("  Return address:    0x%08X\n", ptr_fn->ReturnAddress);
+    } else {
+      FR_PRINT("  Return address:    unknown (stacking error)\n");
+    }
+    FR_PRINT("  EXC_RETURN:        0x%08X\n", ptr_fn->EXC_RETURN);
+#if (FR_FAULT_REGS_EXIST != 0)
+    FR_PRINT("  SCB->CFSR:         0x%08X\n", ptr_fn->SCB_CFSR);
+#endif
     FR_PRINT("\n");
   }
+}
+
+/**
+  Sort FaultInfo slots containing fault information by time of recording.
+  Slots are ordered by timestamp (if FR_TIMESTAMP_ADDR is defined) and core ID.
+  \param[out]   order           slot indexes, oldest recording first (FR_CORE_NUM entries)
+  \return       number of slots containing fault information
+*/
+static uint32_t FaultInfoOrder (uint32_t *order) {
+  uint32_t num = 0U;
+  uint32_t i, j;
+
+  for (i = 0U; i < FR_CORE_NUM; i++) {
+    if (FR_FAULT_INFO_COMPLETE(&FaultInfo[i])) {
+#ifdef FR_TIMESTAMP_ADDR
+      // Insertion sort by timestamp, signed difference handles counter wrap-around
+      for (j = num; j > 0U; j--) {
+        if ((int32_t)(FaultInfo[order[j - 1U]].record_info.timestamp - FaultInfo[i].record_info.timestamp) <= 0) {
+          break;
+        }
+        order[j] = order[j - 1U];
+      }
+#else
+      j = num;
 #endif
+      order[j] = i;
+      num++;
+    }
+  }
+
+  return num;
+}
+
+/**
+  Print the recorded fault information.
+  On multi-core devices fault information of all cores is printed, ordered by
+  time of recording (oldest first), followed by information of recordings that
+  were interrupted and of faults that occurred while recording (nested faults).
+  Should be called when system is running in normal operating mode with
+  standard input/output fully functional.
+*/
+void FaultRecordPrint (void) {
+  uint32_t order[FR_CORE_NUM];
+  uint32_t num, i;
+
+  num = FaultInfoOrder(order);
+  for (i = 0U; i < num; i++) {
+    FaultInfoPrint(&FaultInfo[order[i]]);
+  }
+  for (i = 0U; i < FR_CORE_NUM; i++) {
+    FaultNestedPrint(i);
+  }
 }
 
 /**
-  Clear the recorded fault information.
+  Clear the recorded fault information (of all cores).
 */
 void FaultRecordClear (void) {
-  memset(&FaultInfo, 0, sizeof(FaultInfo));
+  memset(&FaultInfo,   0, sizeof(FaultInfo));
+  memset(&FaultNested, 0, sizeof(FaultNested));
 }
 
-// Helper functions
+// Boot check functions --------------------------------------------------------
 
-#ifdef __ICCARM__
-#pragma diag_suppress=Pe940
+/**
+  Calculate check value of the boot information.
+  \return       check value
+*/
+static uint32_t BootInfoCheck (void) {
+  return ~(BootInfo.magic_number ^ BootInfo.boot_count ^ BootInfo.fault_count ^ BootInfo.first_timestamp);
+}
+
+/**
+  Check for fault information recorded before this boot and count boots and consecutive
+  fault resets, without printing and without verifying the CRC (fast, can be called
+  first thing after reset, before clock and peripheral setup).
+  A fault record is reported once: it is marked as checked, but remains available for
+  FaultRecordPrint, FaultRecordHistoryAdd and the encoders. A recording interrupted by
+  reset, lockup or nested fault is reported (and counted as fault reset) as well.
+  Should be called once per boot, on multi-core devices by one core only.
+  \param[out]   summary         pointer to summary of the fault record and boot counters (NULL = not used)
+  \return       FAULT_RECORD_CHECK_NONE  - no new fault record
+                FAULT_RECORD_CHECK_FAULT - new fault record
+                FAULT_RECORD_CHECK_LOOP  - new fault record and FR_RESET_LOOP_LIMIT consecutive fault resets
+*/
+int32_t FaultRecordCheck (FaultRecordSummary_t *summary) {
+  const FaultInfo_Type *ptr_fi      = NULL;
+  int32_t               ret         = FAULT_RECORD_CHECK_NONE;
+  uint32_t              interrupted = 0U;
+  uint32_t              magic, i;
+
+  // Initialize boot information on power-on (or if corrupted)
+  if ((BootInfo.magic_number != FR_MAGIC_NUMBER) || (BootInfo.check != BootInfoCheck())) {
+    memset(&BootInfo, 0, sizeof(BootInfo));
+    BootInfo.magic_number = FR_MAGIC_NUMBER;
+  }
+  BootInfo.boot_count++;
+
+  // Find records not reported yet and mark them as checked: complete records and interrupted
+  // recordings. The first complete record is summarized, an interrupted recording only if
+  // there is no complete record.
+  for (i = 0U; i < FR_CORE_NUM; i++) {
+    magic = FaultInfo[i].magic_number;
+    if (magic == FR_MAGIC_NUMBER) {
+      if ((ptr_fi == NULL) || (interrupted != 0U)) {
+        ptr_fi      = &FaultInfo[i];
+        interrupted = 0U;
+      }
+      FaultInfo[i].magic_number = FR_MAGIC_NUMBER_SEEN;
+    } else if (magic == FR_MAGIC_NUMBER_BUSY) {
+      if (ptr_fi == NULL) {
+        ptr_fi      = &FaultInfo[i];
+        interrupted = 1U;
+      }
+      FaultInfo[i].magic_number = FR_MAGIC_NUMBER_ABORT;
+    }
+  }
+
+  if (ptr_fi != NULL) {
+#ifdef FR_RESET_LOOP_WINDOW
+    // Faults further apart than the window are not consecutive
+    if ((BootInfo.fault_count != 0U) &&
+        ((ptr_fi->record_info.timestamp - BootInfo.first_timestamp) > (FR_RESET_LOOP_WINDOW))) {
+      BootInfo.fault_count = 0U;
+    }
+#endif
+#if (FR_RECORD_INFO_EXIST != 0)
+    if (BootInfo.fault_count == 0U) {
+      BootInfo.first_timestamp = ptr_fi->record_info.timestamp;
+    }
+#endif
+    BootInfo.fault_count++;
+    ret = FAULT_RECORD_CHECK_FAULT;
+    if (BootInfo.fault_count >= FR_RESET_LOOP_LIMIT) {
+      ret = FAULT_RECORD_CHECK_LOOP;
+    }
+  } else {
+    BootInfo.fault_count = 0U;
+  }
+  BootInfo.check = BootInfoCheck();
+
+  if (summary != NULL) {
+    if (ptr_fi != NULL) {
+      summary->exception = ptr_fi->common_registers.xPSR & IPSR_ISR_Msk;
+      summary->pc        = ptr_fi->state_context.ReturnAddress;
+      summary->hang      = ptr_fi->type.hang;
+    } else {
+      summary->exception = 0U;
+      summary->pc        = 0U;
+      summary->hang      = 0U;
+    }
+    summary->interrupted = interrupted;
+    summary->boot_count  = BootInfo.boot_count;
+    summary->fault_count = BootInfo.fault_count;
+  }
+
+  return ret;
+}
+
+/**
+  Reset the consecutive fault reset counter.
+  Call when the application has run without fault for the desired time window, so that
+  isolated faults are not counted as reset loop.
+*/
+void FaultRecordCheckReset (void) {
+  BootInfo.fault_count = 0U;
+  BootInfo.check       = BootInfoCheck();
+}
+
+// Stack usage functions -------------------------------------------------------
+
+/**
+  Register stack for stack usage measurement upon fault recording.
+  Stack must already be painted with FR_STACK_PAINT_PATTERN (for example by the RTOS).
+  \param[in]    base            stack base (lowest address)
+  \param[in]    size            stack size in bytes
+  \return       0 on success or -1 on error (stack usage disabled or no free entry)
+*/
+int32_t FaultRecordStackRegister (void *base, uint32_t size) {
+#if (FR_STACK_USAGE_EXIST != 0)
+  uint32_t addr = (uint32_t)base;
+  uint32_t i;
+
+  // Align stack region to words
+  size -= ((4U - (addr & 3U)) & 3U);
+  addr  = (addr + 3U) & ~3U;
+  size &= ~3U;
+
+  if ((size == 0U) || (size > (0U - addr))) {
+    return -1;
+  }
+
+  for (i = 0U; i < FR_STACK_NUM; i++) {
+    if ((StackRegion[i].size == 0U) || (StackRegion[i].base == addr)) {
+      StackRegion[i].base = addr;
+      StackRegion[i].size = size;
+      return 0;
+    }
+  }
+#else
+  (void)base;
+  (void)size;
+#endif
+
+  return -1;
+}
+
+/**
+  Paint stack with FR_STACK_PAINT_PATTERN and register it for stack usage measurement.
+  If the stack is currently in use (contains MSP or PSP) only the part below the
+  stack pointer is painted.
+  \param[in]    base            stack base (lowest address)
+  \param[in]    size            stack size in bytes
+  \return       0 on success or -1 on error (stack usage disabled or no free entry)
+*/
+int32_t FaultRecordStackPaint (void *base, uint32_t size) {
+#if (FR_STACK_USAGE_EXIST != 0)
+  uint32_t *ptr = (uint32_t *)(((uint32_t)base + 3U) & ~3U);
+  uint32_t  end = ((uint32_t)base + size) & ~3U;
+  uint32_t  sp;
+
+  if (FaultRecordStackRegister(base, size) != 0) {
+    return -1;
+  }
+
+  // Do not paint the used part of an active stack
+  sp = __get_MSP();
+  if ((sp > (uint32_t)ptr) && (sp <= end)) {
+    end = sp & ~3U;
+  }
+  sp = __get_PSP();
+  if ((sp > (uint32_t)ptr) && (sp <= end)) {
+    end = sp & ~3U;
+  }
+
+  while ((uint32_t)ptr < end) {
+    *ptr = FR_STACK_PAINT_PATTERN;
+    ptr++;
+  }
+
+  return 0;
+#else
+  (void)base;
+  (void)size;
+
+  return -1;
+#endif
+}
+
+// Stack monitor functions -----------------------------------------------------
+
+#if (FR_STACK_MONITOR_EXIST != 0)
+/**
+  Record stack near-miss (called by FaultRecordStackMonitor when a stack pointer is below
+  its threshold). A stack crossing below its threshold is counted as event, a stack that
+  stays below is not counted again. The interrupted context is written in FaultInfo format
+  into the first near-miss record of the current core (if empty) and into the worst
+  near-miss record (if empty or the headroom is smaller than the recorded one).
+  Backtrace and stack usage are not recorded. Runs on the emergency stack if enabled,
+  otherwise on the monitor's main stack.
+  \param[in]    exc_return      EXC_RETURN value of the monitor exception
+  \param[in]    below           stacks below their threshold (bit n = FR_STACK_MONITOR_...)
+  \param[in]    msp             MSP value upon entry into FaultRecordStackMonitor
+  \param[in]    msplim          MSPLIM value upon entry into FaultRecordStackMonitor (Armv8/8.1-M only)
+*/
+static void StackMonitorRecord (uint32_t exc_return, uint32_t below, uint32_t msp, uint32_t msplim) {
+  uint32_t           slot   = CoreSlot();
+  StackMonitor_Type *ptr_sm = &StackMonitor[slot];
+  uint32_t           psp    = __get_PSP();
+  uint32_t           type   = FR_FAULT_INFO_TYPE | (1UL << FR_FAULT_INFO_TYPE_NEAR_MISS_POS);
+  uint32_t           stack  = FR_STACK_MONITOR_MSP;
+  uint32_t           limit  = 0U;
+  uint32_t           frame, sp, lim, i;
+  int32_t            headroom = 0;
+  int32_t            first, worst;
+  FaultInfo_Type    *ptr_fi;
+
+#if (FR_ARCH_ARMV8x_M == 0)
+  (void)msplim;
+#endif
+
+  // Count the crossings and select the stack with the smallest headroom
+  for (i = FR_STACK_MONITOR_MSP; i <= FR_STACK_MONITOR_PSP; i++) {
+    if ((below & (1UL << i)) != 0U) {
+      sp  = (i == FR_STACK_MONITOR_PSP) ? psp : msp;
+      lim = (i == FR_STACK_MONITOR_PSP) ? ptr_sm->psp_threshold : ptr_sm->msp_threshold;
+#if (FR_ARCH_ARMV8x_M != 0)
+      if (lim == 0U) {                  // Limit was not set, MSPLIM or PSPLIM was used
+        lim = ((i == FR_STACK_MONITOR_PSP) ? __get_PSPLIM() : msplim) + FR_STACK_MONITOR_HEADROOM;
+      }
+#endif
+      lim -= FR_STACK_MONITOR_HEADROOM;
+      if ((ptr_sm->below & (1UL << i)) == 0U) {
+        ptr_sm->events++;               // Stack crossed below its threshold since the last check
+      }
+      if ((limit == 0U) || ((int32_t)(sp - lim) < headroom)) {
+        stack    = i;
+        limit    = lim;
+        headroom = (int32_t)(sp - lim);
+      }
+    }
+  }
+  ptr_sm->below = below;
+
+  first = (StackNearMiss[slot][0].magic_number != FR_MAGIC_NUMBER) ? 1 : 0;
+  worst = ((StackNearMiss[slot][1].magic_number != FR_MAGIC_NUMBER) ||
+           (headroom < StackNearMiss[slot][1].near_miss.headroom)) ? 1 : 0;
+  if ((first == 0) && (worst == 0)) {
+    return;
+  }
+  ptr_fi = &StackNearMiss[slot][(worst != 0) ? 1U : 0U];
+
+  ptr_fi->magic_number = 0U;            // Invalidate record while it is written
+  memset(&ptr_fi->type, 0, sizeof(FaultInfo_Type) - offsetof(FaultInfo_Type, type));
+  memcpy(&ptr_fi->type, &type, sizeof(ptr_fi->type));
+  ptr_fi->type.backtrace   = 0U;
+  ptr_fi->type.stack_usage = 0U;
+
+  // Determine the state context of the interrupted code (see FaultRecordSample)
+  frame = ((exc_return & (1UL << 2)) != 0U) ? psp : msp;
+#if (FR_SECURE != 0)
+  if ((exc_return & EXC_RETURN_S) == 0U) {
+    frame = ((exc_return & (1UL << 2)) != 0U) ? __TZ_get_PSP_NS() : __TZ_get_MSP_NS();
+  }
+#elif ((FR_ARCH_ARMV8x_M != 0) && defined(__SAUREGION_PRESENT) && (__SAUREGION_PRESENT != 0))
+  if ((exc_return & EXC_RETURN_S) != 0U) {
+    frame = 0U;                         // Secure stack is not accessible, state context is not recorded
+  }
+#endif
+  if (frame != 0U) {
+#if (FR_ARCH_ARMV8x_M != 0)
+    if ((exc_return & EXC_RETURN_DCRS) == 0U) {
+      memcpy(&ptr_fi->additonal_state_context, (const void *)frame, sizeof(AdditionalStateContext_Type));
+      frame += sizeof(AdditionalStateContext_Type);
+    }
+#endif
+    memcpy(&ptr_fi->state_context, (const void *)frame, sizeof(StateContext_Type));
+  }
+
+  ptr_fi->common_registers.xPSR       = __get_xPSR();
+  ptr_fi->common_registers.EXC_RETURN = exc_return;
+  ptr_fi->common_registers.MSP        = msp;
+  ptr_fi->common_registers.PSP        = psp;
+#if (FR_FAULT_REGS_EXIST != 0)
+  ptr_fi->fault_registers.SCB_CFSR    = SCB->CFSR;
+  ptr_fi->fault_registers.SCB_HFSR    = SCB->HFSR;
+  ptr_fi->fault_registers.SCB_DFSR    = SCB->DFSR;
+  ptr_fi->fault_registers.SCB_MMFAR   = SCB->MMFAR;
+  ptr_fi->fault_registers.SCB_BFAR    = SCB->BFAR;
+  ptr_fi->fault_registers.SCB_AFSR    = SCB->AFSR;
+#endif
+#if (FR_ARCH_ARMV8x_M != 0)
+  ptr_fi->armv8_m_registers.MSPLIM    = msplim;
+  ptr_fi->armv8_m_registers.PSPLIM    = __get_PSPLIM();
+#endif
+#if ((FR_ARCH_ARMV8x_M_MAIN != 0) && (FR_SECURE != 0))
+  ptr_fi->armv8_m_fault_registers.SCB_SFSR = SCB->SFSR;
+  ptr_fi->armv8_m_fault_registers.SCB_SFAR = SCB->SFAR;
+#endif
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+  ptr_fi->armv8_1_m_registers.CONTROL = __get_CONTROL();
+#ifdef SCB_RFSR_V_Msk
+  ptr_fi->armv8_1_m_registers.SCB_RFSR = SCB->RFSR;
+#endif
+#endif
+#if (FR_RECORD_INFO_EXIST != 0)
+  ptr_fi->record_info.core_id         = slot;
+#ifdef FR_TIMESTAMP_ADDR
+  ptr_fi->record_info.timestamp       = FR_TIMESTAMP_VALUE();
+#endif
+#endif
+#if (FR_BUILD_ID_EXIST != 0)
+  memcpy(ptr_fi->build_id, &((const uint8_t *)FR_BUILD_ID_SYMBOL)[FR_BUILD_ID_OFS], FR_BUILD_ID_LEN);
+#endif
+  ptr_fi->near_miss.stack             = stack;
+  ptr_fi->near_miss.limit             = limit;
+  ptr_fi->near_miss.headroom          = headroom;
+  ptr_fi->near_miss.event             = ptr_sm->events;
+
+  ptr_fi->crc32        = CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_fi), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM);
+  ptr_fi->magic_number = FR_MAGIC_NUMBER;
+
+  // The first event is also the worst event so far
+  if ((first != 0) && (worst != 0)) {
+    memcpy(&StackNearMiss[slot][0], ptr_fi, sizeof(FaultInfo_Type));
+  }
+}
+#endif
+
+/**
+  Set the stack limits checked by FaultRecordStackMonitor on the current core.
+  With an RTOS, call it with the stack base of the running thread on every thread switch
+  (from a context the stack monitor cannot interrupt), unless the RTOS sets PSPLIM.
+  \param[in]    msp_limit       main stack limit (lowest address), NULL = use MSPLIM (Armv8/8.1-M) or not monitored
+  \param[in]    psp_limit       thread stack limit (lowest address), NULL = use PSPLIM (Armv8/8.1-M) or not monitored
+  \return       0 on success or -1 on error (stack monitor disabled)
+*/
+int32_t FaultRecordStackMonitorLimit (const void *msp_limit, const void *psp_limit) {
+#if (FR_STACK_MONITOR_EXIST != 0)
+  StackMonitor_Type *ptr_sm = &StackMonitor[CoreSlot()];
+
+  ptr_sm->msp_threshold = (msp_limit != NULL) ? ((uint32_t)msp_limit + FR_STACK_MONITOR_HEADROOM) : 0U;
+  ptr_sm->psp_threshold = (psp_limit != NULL) ? ((uint32_t)psp_limit + FR_STACK_MONITOR_HEADROOM) : 0U;
+
+  return 0;
+#else
+  (void)msp_limit;
+  (void)psp_limit;
+
+  return -1;
+#endif
+}
+
+/**
+  Print the stack near-miss records (first and worst event of each core).
+*/
+void FaultRecordStackMonitorPrint (void) {
+#if (FR_STACK_MONITOR_EXIST != 0)
+  const FaultInfo_Type *ptr_first, *ptr_worst;
+  uint32_t slot;
+
+  for (slot = 0U; slot < FR_CORE_NUM; slot++) {
+    ptr_first = &StackNearMiss[slot][0];
+    ptr_worst = &StackNearMiss[slot][1];
+
+    FR_PRINT("\n--- Stack monitor ---\n\n");
+#if (FR_CORE_NUM > 1U)
+    FR_PRINT("  Core:              %u\n", slot);
+#endif
+    FR_PRINT("  Near-miss events:  %u since boot (headroom threshold %u bytes)\n", StackMonitor[slot].events, FR_STACK_MONITOR_HEADROOM);
+
+    if (ptr_first->magic_number == FR_MAGIC_NUMBER) {
+      FaultInfoPrint(ptr_first);
+    }
+    if ((ptr_worst->magic_number == FR_MAGIC_NUMBER) &&
+        ((ptr_first->magic_number != FR_MAGIC_NUMBER) || (ptr_worst->near_miss.event != ptr_first->near_miss.event))) {
+      FaultInfoPrint(ptr_worst);
+    }
+  }
+#endif
+}
+
+/**
+  Clear the stack near-miss records and event counters (of all cores).
+*/
+void FaultRecordStackMonitorClear (void) {
+#if (FR_STACK_MONITOR_EXIST != 0)
+  uint32_t slot;
+
+  memset(&StackNearMiss, 0, sizeof(StackNearMiss));
+  for (slot = 0U; slot < FR_CORE_NUM; slot++) {
+    StackMonitor[slot].events = 0U;
+  }
+#endif
+}
+
+// Exit action functions -------------------------------------------------------
+
+/**
+  Register exit action executed before system reset, after fault information was recorded.
+  Actions are executed by FaultRecordExitRun in the order of registration. An action is
+  skipped if the fault occurred inside its code range (the subsystem used by the action
+  is not trusted) or if its budget does not fit before the FR_EXIT_DEADLINE.
+  \param[in]    func            action function, called with the counter value by which it must return
+  \param[in]    budget          maximum execution time (FR_TIMESTAMP_ADDR counter ticks)
+  \param[in]    code_start      start address of the code used by the action (0 = no code range)
+  \param[in]    code_end        end address (exclusive) of the code used by the action
+  \return       0 on success or -1 on error (exit actions disabled or no free entry)
+*/
+int32_t FaultRecordExitActionRegister (FaultRecordExitAction_t func, uint32_t budget, uint32_t code_start, uint32_t code_end) {
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  if ((func != NULL) && (ExitActionNum < FR_EXIT_ACTION_NUM)) {
+    ExitAction[ExitActionNum].func       = func;
+    ExitAction[ExitActionNum].budget     = budget;
+    ExitAction[ExitActionNum].code_start = code_start;
+    ExitAction[ExitActionNum].code_end   = code_end;
+    ExitActionNum++;
+    return 0;
+  }
+#else
+  (void)func;
+  (void)budget;
+  (void)code_start;
+  (void)code_end;
+#endif
+
+  return -1;
+}
+
+/**
+  Execute registered exit actions.
+  Called by the default FaultRecordOnExit implementation, user implementations of
+  FaultRecordOnExit can call it before resetting the system. Actions are executed once
+  per recorded fault, the status and time taken by each action are stored into the
+  fault information of the current core.
+*/
+void FaultRecordExitRun (void) {
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  const ExitAction_Type *ptr_ea;
+  ExitActionResult_Type *ptr_res;
+  uint32_t               slot   = CoreSlot();
+  FaultInfo_Type        *ptr_fi = &FaultInfo[slot];
+  uint32_t               deadline, start, pc, lr, i;
+  uint32_t               expired = 0U;
+
+  // Execute actions only after recording (not again after a nested fault)
+  if ((ptr_fi->magic_number != FR_MAGIC_NUMBER) || (FaultBusy[slot] != 0U)) {
+    return;
+  }
+  // The record stays complete (reported after reset also if an action does not return),
+  // a fault inside an action is a nested fault
+  FaultBusy[slot] = 1U;
+
+  deadline = ptr_fi->record_info.timestamp + (FR_EXIT_DEADLINE);
+  pc       = ptr_fi->state_context.ReturnAddress;
+  lr       = ptr_fi->state_context.LR;
+
+  // Arm the watchdog with the time left (0 if the deadline has already passed)
+  start = FR_TIMESTAMP_VALUE();
+  if ((int32_t)(deadline - start) < 0) {
+    start = deadline;
+  }
+  FaultRecordExitWatchdog(deadline - start);
+
+  for (i = 0U; i < ExitActionNum; i++) {
+    ptr_ea  = &ExitAction[i];
+    ptr_res = &ptr_fi->exit_actions[i];
+
+    // An overrun used up the time up to the deadline: skip all remaining actions
+    if (expired != 0U) {
+      ptr_res->status = FR_EXIT_ACTION_SKIP_DEADLINE;
+      continue;
+    }
+
+    if (((pc >= ptr_ea->code_start) && (pc < ptr_ea->code_end)) ||
+        ((lr >= ptr_ea->code_start) && (lr < ptr_ea->code_end))) {
+      ptr_res->status = FR_EXIT_ACTION_SKIP_FAULT;
+      continue;
+    }
+
+    // Signed difference handles counter wrap-around
+    start = FR_TIMESTAMP_VALUE();
+    if ((int32_t)(deadline - (start + ptr_ea->budget)) < 0) {
+      ptr_res->status = FR_EXIT_ACTION_SKIP_DEADLINE;
+      continue;
+    }
+
+    ptr_res->status = FR_EXIT_ACTION_RUNNING;
+    ptr_ea->func(start + ptr_ea->budget);
+    ptr_res->elapsed = FR_TIMESTAMP_VALUE() - start;
+    if (ptr_res->elapsed > ptr_ea->budget) {
+      ptr_res->status = FR_EXIT_ACTION_OVERRUN;
+      if (FaultRecordExitTimeout(deadline) != 0) {
+        expired = 1U;
+      }
+    } else {
+      ptr_res->status = FR_EXIT_ACTION_DONE;
+    }
+  }
+
+  FaultBusy[slot] = 0U;
+#endif
+}
+
+/**
+  Check if exit action deadline has passed.
+  To be polled by exit actions that wait (for example for a UART FIFO to drain).
+  \param[in]    deadline        counter value passed to the exit action
+  \return       1 if deadline has passed, 0 otherwise
+*/
+int32_t FaultRecordExitTimeout (uint32_t deadline) {
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  if ((int32_t)(FR_TIMESTAMP_VALUE() - deadline) >= 0) {
+    return 1;
+  }
+  return 0;
+#else
+  (void)deadline;
+
+  return 1;
+#endif
+}
+
+// Print ring buffer functions -------------------------------------------------
+
+/**
+  Write data to the print ring buffer.
+  Does not block: when the buffer is full, the data is dropped (as a whole) or the
+  oldest output is overwritten (FR_PRINT_RING_OVERWRITE). The buffer is initialized
+  upon first write and keeps its content over resets.
+  Can be called from threads and interrupt handlers of one core: interrupts are disabled
+  (PRIMASK) while the data is placed into the buffer.
+  \param[in]    data            pointer to data
+  \param[in]    len             number of bytes to write
+  \return       number of bytes written, or -1 if data was dropped or ring buffer is disabled
+*/
+int32_t FaultRecordRingWrite (const char *data, uint32_t len) {
+#if (FR_PRINT_RING_SIZE != 0U)
+  uint32_t primask, wr, ofs, num;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  // Initialize ring buffer if not initialized yet (identification written last)
+  if ((FaultRing.size != FR_PRINT_RING_SIZE) || (memcmp(FaultRing.id, FR_RING_ID, sizeof(FR_RING_ID)) != 0)) {
+    memset(&FaultRing, 0, offsetof(FaultRing_Type, buf));
+    FaultRing.size  = FR_PRINT_RING_SIZE;
+    FaultRing.flags = (FR_PRINT_RING_OVERWRITE != 0) ? FR_RING_FLAG_OVERWRITE : 0U;
+    __DMB();
+    memcpy(FaultRing.id, FR_RING_ID, sizeof(FR_RING_ID));
+  }
+
+  wr = FaultRing.wr;
+#if (FR_PRINT_RING_OVERWRITE != 0)
+  // Only the last FR_PRINT_RING_SIZE bytes are kept
+  if (len > FR_PRINT_RING_SIZE) {
+    wr   += len - FR_PRINT_RING_SIZE;
+    data += len - FR_PRINT_RING_SIZE;
+    len   = FR_PRINT_RING_SIZE;
+  }
+#else
+  // Drop data that does not fit into free space
+  if (len > (FR_PRINT_RING_SIZE - (wr - FaultRing.rd))) {
+    FaultRing.dropped += len;
+    __set_PRIMASK(primask);
+    return -1;
+  }
+#endif
+
+  // Copy data (in two parts if it wraps around the end of the buffer)
+  ofs = wr & (FR_PRINT_RING_SIZE - 1U);
+  num = FR_PRINT_RING_SIZE - ofs;
+  if (num > len) {
+    num = len;
+  }
+  memcpy(&FaultRing.buf[ofs], data, num);
+  memcpy(&FaultRing.buf[0], &data[num], len - num);
+
+  // Publish data after it was written
+  __DMB();
+  FaultRing.wr = wr + len;
+
+  __set_PRIMASK(primask);
+
+  return (int32_t)len;
+#else
+  (void)data;
+  (void)len;
+  return -1;
+#endif
+}
+
+/**
+  Format output and write it to the print ring buffer (default FR_PRINT when
+  FR_PRINT_RING_SIZE is not 0). Output longer than FR_PRINT_RING_LINE - 1 is truncated.
+  \param[in]    format          printf-style format string
+  \return       number of bytes written, or -1 if output was dropped or ring buffer is disabled
+*/
+int32_t FaultRecordRingPrintf (const char *format, ...) {
+#if (FR_PRINT_RING_SIZE != 0U)
+  char    str[FR_PRINT_RING_LINE];
+  va_list args;
+  int     len;
+
+  va_start(args, format);
+  len = vsnprintf(str, sizeof(str), format, args);
+  va_end(args);
+
+  if (len < 0) {
+    return -1;
+  }
+  if ((uint32_t)len >= sizeof(str)) {
+    len = (int)sizeof(str) - 1;
+  }
+
+  return FaultRecordRingWrite(str, (uint32_t)len);
+#else
+  (void)format;
+  return -1;
+#endif
+}
+
+// Sampling profiler functions -------------------------------------------------
+
+/**
+  Print PC samples from the sampling ring buffer (oldest first).
+  Output can be folded into a flat profile with Scripts/fr_profile.py.
+*/
+void FaultRecordSamplePrint (void) {
+#if (FR_SAMPLE_NUM != 0U)
+  uint32_t count, num, i;
+
+  count = SampleBuf.count;
+  num   = count;
+  if (num > FR_SAMPLE_NUM) {
+    num = FR_SAMPLE_NUM;
+  }
+
+  FR_PRINT("\n--- PC samples (%u of %u) ---\n\n", num, count);
+  for (i = count - num; i != count; i++) {
+    const Sample_Type *ptr_s = &SampleBuf.sample[i & (FR_SAMPLE_NUM - 1U)];
+    FR_PRINT("  0x%08X 0x%08X\n", ptr_s->pc, ptr_s->lr);
+  }
+  FR_PRINT("\n");
+#endif
+}
+
+/**
+  Clear PC samples.
+*/
+void FaultRecordSampleClear (void) {
+#if (FR_SAMPLE_NUM != 0U)
+  memset(&SampleBuf, 0, sizeof(SampleBuf));
+#endif
+}
+
+// Fault history functions -----------------------------------------------------
+
+#if (FR_HISTORY_SIZE != 0U)
+/**
+  Check if the fault history is valid.
+  \return       1 if valid, 0 otherwise
+*/
+static int32_t HistoryIsValid (void) {
+  int32_t valid = 0;
+
+  if ((FaultHistory.magic_number == FR_MAGIC_NUMBER)             &&
+      (FaultHistory.rec_words    == FR_HISTORY_REC_WORDS)        &&
+      (FaultHistory.length       <= FR_HISTORY_SIZE)             &&
+      (FaultHistory.keyframe_ofs <= FaultHistory.length)         ) {
+    if (FaultHistory.crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_HISTORY_CRC32_DATA_PTR, FR_HISTORY_CRC32_DATA_LEN, FR_CRC32_POLYNOM)) {
+      valid = 1;
+    }
+  }
+
+  return valid;
+}
+
+/**
+  Empty the fault history and mark it valid.
+*/
+static void HistoryReset (void) {
+  memset(&FaultHistory, 0, offsetof(FaultHistory_Type, data));
+  FaultHistory.rec_words    = FR_HISTORY_REC_WORDS;
+  FaultHistory.crc32        = CalcCRC32(FR_CRC32_INIT_VAL, FR_HISTORY_CRC32_DATA_PTR, FR_HISTORY_CRC32_DATA_LEN, FR_CRC32_POLYNOM);
+  FaultHistory.magic_number = FR_MAGIC_NUMBER;
+}
+
+/**
+  Discard the oldest entries up to the second keyframe.
+  \return       number of discarded bytes or 0 if history contains only one keyframe
+*/
+static uint32_t HistoryDropOldest (void) {
+  uint32_t rec[FR_HISTORY_REC_WORDS];
+  uint32_t ofs   = 0U;
+  uint32_t count = 0U;
+  uint32_t len;
+
+  do {
+    len = HistoryDecodeEntry(&FaultHistory.data[ofs], FaultHistory.length - ofs, rec);
+    ofs  += len;
+    count++;
+  } while ((len != 0U) && (ofs < FaultHistory.length) && (FaultHistory.data[ofs] != FR_HISTORY_TAG_KEYFRAME));
+
+  if ((len == 0U) || (ofs >= FaultHistory.length)) {
+    return 0U;
+  }
+
+  memmove(&FaultHistory.data[0], &FaultHistory.data[ofs], FaultHistory.length - ofs);
+  FaultHistory.length       -= (uint16_t)ofs;
+  FaultHistory.keyframe_ofs -= (uint16_t)ofs;
+  FaultHistory.count        -= (uint16_t)count;
+
+  return ofs;
+}
+#endif
+
+#if (FR_HISTORY_SIZE != 0U)
+/**
+  Append fault information of one FaultInfo slot to the fault history.
+  \param[in]    slot            FaultInfo slot index
+  \return       0 on success, -1 if slot contains no valid fault information or entry does not fit
+*/
+static int32_t HistoryAddRecord (uint32_t slot) {
+  const FaultInfo_Type *ptr_fi = &FaultInfo[slot];
+  uint32_t prev[FR_HISTORY_REC_WORDS];
+  uint32_t rec [FR_HISTORY_REC_WORDS];
+  uint8_t  entry[FR_HISTORY_ENTRY_MAX];
+  uint32_t entry_len, since_keyframe, ofs, len;
+  uint8_t  tag;
+  int32_t  ret = -1;
+
+  if (FR_FAULT_INFO_COMPLETE(ptr_fi) &&
+      (ptr_fi->crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_fi), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM))) {
+
+    if ((FaultHistory.count != 0U) && (FaultHistory.last_crc32[slot] == ptr_fi->crc32)) {
+      ret = 0;                          // Already in the history
+    } else {
+      memcpy(rec, FR_CRC32_DATA_PTR(ptr_fi), sizeof(rec));
+
+      // Reconstruct the last entry by decoding from the last keyframe
+      since_keyframe = 0U;
+      for (ofs = FaultHistory.keyframe_ofs; ofs < FaultHistory.length; ofs += len) {
+        len = HistoryDecodeEntry(&FaultHistory.data[ofs], FaultHistory.length - ofs, prev);
+        if (len == 0U) {
+          break;
+        }
+        since_keyframe++;
+      }
+
+      if ((FaultHistory.count == 0U) || (since_keyframe >= FR_HISTORY_KEYFRAME_INTERVAL)) {
+        tag = FR_HISTORY_TAG_KEYFRAME;
+      } else {
+        tag = FR_HISTORY_TAG_DELTA;
+      }
+      entry_len = HistoryEncodeEntry(tag, prev, rec, entry);
+
+      // Make room for the new entry
+      while ((FaultHistory.length + entry_len) > FR_HISTORY_SIZE) {
+        if (HistoryDropOldest() == 0U) {
+          HistoryReset();
+          tag       = FR_HISTORY_TAG_KEYFRAME;
+          entry_len = HistoryEncodeEntry(tag, prev, rec, entry);
+          break;
+        }
+      }
+
+      if ((FaultHistory.length + entry_len) <= FR_HISTORY_SIZE) {
+        memcpy(&FaultHistory.data[FaultHistory.length], entry, entry_len);
+        if (tag == FR_HISTORY_TAG_KEYFRAME) {
+          FaultHistory.keyframe_ofs = FaultHistory.length;
+        }
+        FaultHistory.length           += (uint16_t)entry_len;
+        FaultHistory.count            += 1U;
+        FaultHistory.last_crc32[slot]  = ptr_fi->crc32;
+        FaultHistory.crc32             = CalcCRC32(FR_CRC32_INIT_VAL, FR_HISTORY_CRC32_DATA_PTR, FR_HISTORY_CRC32_DATA_LEN, FR_CRC32_POLYNOM);
+        ret = 0;
+      }
+    }
+  }
+
+  return ret;
+}
+#endif
+
+/**
+  Append the recorded fault information to the compressed fault history.
+  Entries are stored as XOR deltas against the previous entry (changed-word mask
+  followed by varint encoded XOR values), every FR_HISTORY_KEYFRAME_INTERVAL-th
+  entry is stored as keyframe (delta against an all-zero record).
+  When history is full the oldest entries are discarded up to the next keyframe.
+  Fault information that was already added is not added again.
+  On multi-core devices fault information of all cores is added, ordered by
+  time of recording.
+  \return       0 on success, -1 if there is no valid fault information or history is disabled
+*/
+int32_t FaultRecordHistoryAdd (void) {
+  int32_t  ret = -1;
+#if (FR_HISTORY_SIZE != 0U)
+  uint32_t order[FR_CORE_NUM];
+  uint32_t num, i;
+
+  if (HistoryIsValid() == 0) {
+    HistoryReset();
+  }
+
+  num = FaultInfoOrder(order);
+  for (i = 0U; i < num; i++) {
+    if (HistoryAddRecord(order[i]) == 0) {
+      ret = 0;
+    }
+  }
+#endif
+
+  return ret;
+}
+
+/**
+  Print the compressed fault history (oldest entry first).
+*/
+void FaultRecordHistoryPrint (void) {
+#if (FR_HISTORY_SIZE != 0U)
+  FaultInfo_Type fi;
+  uint32_t       rec[FR_HISTORY_REC_WORDS];
+  uint32_t       ofs, len, num, exc_num;
+
+  if (HistoryIsValid() == 0) {
+    return;
+  }
+
+  FR_PRINT("\n--- Fault history (%u entries, %u of %u bytes used) ---\n\n", FaultHistory.count, FaultHistory.length, FR_HISTORY_SIZE);
+
+  memset(rec, 0, sizeof(rec));
+  num = 1U;
+  for (ofs = 0U; ofs < FaultHistory.length; ofs += len) {
+    len = HistoryDecodeEntry(&FaultHistory.data[ofs], FaultHistory.length - ofs, rec);
+    if (len == 0U) {
+      FR_PRINT("  Invalid fault history entry at offset %u !!!\n", ofs);
+      break;
+    }
+    memcpy(&fi.type, rec, sizeof(rec));
+    exc_num = fi.common_registers.xPSR & IPSR_ISR_Msk;
+
+    FR_PRINT("  #%-3u %c Exception %u, PC 0x%08X, LR 0x%08X", num, (int)FaultHistory.data[ofs],
+             exc_num, fi.state_context.ReturnAddress, fi.state_context.LR);
+#if (FR_FAULT_REGS_EXIST != 0)
+    FR_PRINT(", CFSR 0x%08X, HFSR 0x%08X", fi.fault_registers.SCB_CFSR, fi.fault_registers.SCB_HFSR);
+#endif
+    FR_PRINT("\n");
+    num++;
+  }
+
+  FR_PRINT("\n");
+#endif
+}
+
+/**
+  Clear the compressed fault history.
+*/
+void FaultRecordHistoryClear (void) {
+#if (FR_HISTORY_SIZE != 0U)
+  memset(&FaultHistory, 0, sizeof(FaultHistory));
+#endif
+}
+
+// Structured output functions -------------------------------------------------
+
+// Structured output encoder type definition
+typedef struct {
+  uint8_t                    *buf;              // Caller buffer
+  uint32_t                    size;             // Caller buffer size in bytes
+  uint32_t                    pos;              // Number of bytes encoded (also beyond size)
+  uint8_t                     json;             // == 1 - JSON, == 0 - CBOR
+  uint8_t                     depth;            // Nesting depth of maps and arrays
+  uint8_t                     first;            // bit [n] == 1 - no item written yet on depth n
+  uint8_t                     reserved;
+} Encoder_Type;
+
+// Fault information field descriptor type definition
+typedef struct {
+  const char                 *key;              // Stable key (JSON)
+  uint8_t                     id;               // Stable key ID (CBOR)
+  uint8_t                     type_pos;         // FaultInfo type bit position the field depends on (0 = none)
+  uint16_t                    offset;           // Offset of the 32-bit field in FaultInfo_Type
+} FieldDesc_Type;
+
+// Fault flag descriptor type definition
+typedef struct {
+  const char                 *key;              // Stable key (<register>.<bit field>, JSON)
+  uint8_t                     id;               // Stable flag ID (CBOR)
+  uint16_t                    offset;           // Offset of the 32-bit register in FaultInfo_Type
+  uint32_t                    mask;             // Bit mask
+} FlagDesc_Type;
+
+#define FR_FIELD(id, key, field) { key, id, 0U, (uint16_t)offsetof(FaultInfo_Type, field) }
+#define FR_FIELD_IF(id, key, field, pos) { key, id, FR_FAULT_INFO_TYPE_ ## pos ## _POS, (uint16_t)offsetof(FaultInfo_Type, field) }
+#define FR_FLAG(id, pre, reg, bit, field) { #reg "." #bit, id, (uint16_t)offsetof(FaultInfo_Type, field), pre ## _ ## reg ## _ ## bit ## _Msk }
+
+// Structured output key IDs (CBOR map keys) of the items not described by FieldDesc,
+// the IDs of all items are listed in Scripts/fr_records.py (IDs below 24 take one byte)
+#define FR_KEY_VERSION_MAJOR        (0U)
+#define FR_KEY_VERSION_MINOR        (1U)
+#define FR_KEY_SECURE               (2U)
+#define FR_KEY_HANG                 (3U)
+#define FR_KEY_NEAR_MISS            (4U)
+#define FR_KEY_EXCEPTION            (5U)
+#define FR_KEY_STATE_CONTEXT_VALID  (6U)
+#define FR_KEY_FAULTS               (21U)
+#define FR_KEY_BUILD_ID             (43U)
+#define FR_KEY_NEAR_MISS_STACK      (44U)
+#define FR_KEY_NEAR_MISS_LIMIT      (45U)
+#define FR_KEY_NEAR_MISS_HEADROOM   (46U)
+#define FR_KEY_NEAR_MISS_EVENT      (47U)
+#define FR_KEY_BACKTRACE_SP         (48U)
+#define FR_KEY_BACKTRACE            (49U)
+#define FR_KEY_STACKS               (50U)
+#define FR_KEY_BASE                 (51U)
+#define FR_KEY_SIZE                 (52U)
+#define FR_KEY_UNUSED               (53U)
+#define FR_KEY_EXIT_ACTIONS         (54U)
+#define FR_KEY_STATUS               (55U)
+#define FR_KEY_ELAPSED              (56U)
+
+// Fault information fields
+static const FieldDesc_Type FieldDesc[] = {
+  FR_FIELD( 7U, "R0",                 state_context.R0),
+  FR_FIELD( 8U, "R1",                 state_context.R1),
+  FR_FIELD( 9U, "R2",                 state_context.R2),
+  FR_FIELD(10U, "R3",                 state_context.R3),
+  FR_FIELD(11U, "R12",                state_context.R12),
+  FR_FIELD(12U, "LR",                 state_context.LR),
+  FR_FIELD(13U, "ReturnAddress",      state_context.ReturnAddress),
+  FR_FIELD(14U, "xPSR",               state_context.xPSR),
+  FR_FIELD(15U, "EXC_xPSR",           common_registers.xPSR),
+  FR_FIELD(16U, "EXC_RETURN",         common_registers.EXC_RETURN),
+  FR_FIELD(17U, "MSP",                common_registers.MSP),
+  FR_FIELD(18U, "PSP",                common_registers.PSP),
+#if (FR_FAULT_REGS_EXIST != 0)
+  FR_FIELD(19U, "CFSR",               fault_registers.SCB_CFSR),
+  FR_FIELD(20U, "HFSR",               fault_registers.SCB_HFSR),
+  FR_FIELD(24U, "DFSR",               fault_registers.SCB_DFSR),
+  FR_FIELD(25U, "MMFAR",              fault_registers.SCB_MMFAR),
+  FR_FIELD(26U, "BFAR",               fault_registers.SCB_BFAR),
+  FR_FIELD(27U, "AFSR",               fault_registers.SCB_AFSR),
+#endif
+#if (FR_ARCH_ARMV8x_M != 0)
+  FR_FIELD(28U, "IntegritySignature", additonal_state_context.IntegritySignature),
+  FR_FIELD(29U, "R4",                 additonal_state_context.R4),
+  FR_FIELD(30U, "R5",                 additonal_state_context.R5),
+  FR_FIELD(31U, "R6",                 additonal_state_context.R6),
+  FR_FIELD(32U, "R7",                 additonal_state_context.R7),
+  FR_FIELD(33U, "R8",                 additonal_state_context.R8),
+  FR_FIELD(34U, "R9",                 additonal_state_context.R9),
+  FR_FIELD(35U, "R10",                additonal_state_context.R10),
+  FR_FIELD(36U, "R11",                additonal_state_context.R11),
+  FR_FIELD(37U, "MSPLIM",             armv8_m_registers.MSPLIM),
+  FR_FIELD(38U, "PSPLIM",             armv8_m_registers.PSPLIM),
+#endif
+#if (FR_ARCH_ARMV8x_M_MAIN != 0)
+  FR_FIELD(39U, "SFSR",               armv8_m_fault_registers.SCB_SFSR),
+  FR_FIELD(40U, "SFAR",               armv8_m_fault_registers.SCB_SFAR),
+#endif
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+  FR_FIELD(41U, "CONTROL",            armv8_1_m_registers.CONTROL),
+  FR_FIELD(42U, "RFSR",               armv8_1_m_registers.SCB_RFSR),
+#endif
+#if (FR_EXT_CONTEXT_EXIST != 0)
+  FR_FIELD_IF(57U, "ext_context",      extended_context.state,     EXT_CONTEXT),
+  FR_FIELD_IF(58U, "S0",               extended_context.S[0],      EXT_CONTEXT),
+  FR_FIELD_IF(59U, "S1",               extended_context.S[1],      EXT_CONTEXT),
+  FR_FIELD_IF(60U, "S2",               extended_context.S[2],      EXT_CONTEXT),
+  FR_FIELD_IF(61U, "S3",               extended_context.S[3],      EXT_CONTEXT),
+  FR_FIELD_IF(62U, "S4",               extended_context.S[4],      EXT_CONTEXT),
+  FR_FIELD_IF(63U, "S5",               extended_context.S[5],      EXT_CONTEXT),
+  FR_FIELD_IF(64U, "S6",               extended_context.S[6],      EXT_CONTEXT),
+  FR_FIELD_IF(65U, "S7",               extended_context.S[7],      EXT_CONTEXT),
+  FR_FIELD_IF(66U, "S8",               extended_context.S[8],      EXT_CONTEXT),
+  FR_FIELD_IF(67U, "S9",               extended_context.S[9],      EXT_CONTEXT),
+  FR_FIELD_IF(68U, "S10",              extended_context.S[10],     EXT_CONTEXT),
+  FR_FIELD_IF(69U, "S11",              extended_context.S[11],     EXT_CONTEXT),
+  FR_FIELD_IF(70U, "S12",              extended_context.S[12],     EXT_CONTEXT),
+  FR_FIELD_IF(71U, "S13",              extended_context.S[13],     EXT_CONTEXT),
+  FR_FIELD_IF(72U, "S14",              extended_context.S[14],     EXT_CONTEXT),
+  FR_FIELD_IF(73U, "S15",              extended_context.S[15],     EXT_CONTEXT),
+  FR_FIELD_IF(74U, "S16",              extended_context.S[16],     EXT_CONTEXT),
+  FR_FIELD_IF(75U, "S17",              extended_context.S[17],     EXT_CONTEXT),
+  FR_FIELD_IF(76U, "S18",              extended_context.S[18],     EXT_CONTEXT),
+  FR_FIELD_IF(77U, "S19",              extended_context.S[19],     EXT_CONTEXT),
+  FR_FIELD_IF(78U, "S20",              extended_context.S[20],     EXT_CONTEXT),
+  FR_FIELD_IF(79U, "S21",              extended_context.S[21],     EXT_CONTEXT),
+  FR_FIELD_IF(80U, "S22",              extended_context.S[22],     EXT_CONTEXT),
+  FR_FIELD_IF(81U, "S23",              extended_context.S[23],     EXT_CONTEXT),
+  FR_FIELD_IF(82U, "S24",              extended_context.S[24],     EXT_CONTEXT),
+  FR_FIELD_IF(83U, "S25",              extended_context.S[25],     EXT_CONTEXT),
+  FR_FIELD_IF(84U, "S26",              extended_context.S[26],     EXT_CONTEXT),
+  FR_FIELD_IF(85U, "S27",              extended_context.S[27],     EXT_CONTEXT),
+  FR_FIELD_IF(86U, "S28",              extended_context.S[28],     EXT_CONTEXT),
+  FR_FIELD_IF(87U, "S29",              extended_context.S[29],     EXT_CONTEXT),
+  FR_FIELD_IF(88U, "S30",              extended_context.S[30],     EXT_CONTEXT),
+  FR_FIELD_IF(89U, "S31",              extended_context.S[31],     EXT_CONTEXT),
+  FR_FIELD_IF(90U, "FPSCR",            extended_context.FPSCR,     EXT_CONTEXT),
+#if (FR_MVE_EXIST != 0)
+  FR_FIELD_IF(91U, "VPR",              extended_context.VPR,       EXT_CONTEXT),
+#endif
+#endif
+#if (FR_RECORD_INFO_EXIST != 0)
+  FR_FIELD_IF(22U, "core_id",          record_info.core_id,        RECORD_INFO),
+  FR_FIELD_IF(23U, "timestamp",        record_info.timestamp,      RECORD_INFO),
+#endif
+};
+
+#if (FR_FAULT_REGS_EXIST != 0)
+// Fault flags (decoded fault status register bits)
+static const FlagDesc_Type FlagDesc[] = {
+  FR_FLAG( 0U, SCB, HFSR, VECTTBL,     fault_registers.SCB_HFSR),
+  FR_FLAG( 1U, SCB, HFSR, FORCED,      fault_registers.SCB_HFSR),
+  FR_FLAG( 2U, SCB, HFSR, DEBUGEVT,    fault_registers.SCB_HFSR),
+  FR_FLAG( 3U, SCB, CFSR, IACCVIOL,    fault_registers.SCB_CFSR),
+  FR_FLAG( 4U, SCB, CFSR, DACCVIOL,    fault_registers.SCB_CFSR),
+  FR_FLAG( 5U, SCB, CFSR, MUNSTKERR,   fault_registers.SCB_CFSR),
+  FR_FLAG( 6U, SCB, CFSR, MSTKERR,     fault_registers.SCB_CFSR),
+#ifdef SCB_CFSR_MLSPERR_Msk
+  FR_FLAG( 7U, SCB, CFSR, MLSPERR,     fault_registers.SCB_CFSR),
+#endif
+  FR_FLAG( 8U, SCB, CFSR, MMARVALID,   fault_registers.SCB_CFSR),
+  FR_FLAG( 9U, SCB, CFSR, IBUSERR,     fault_registers.SCB_CFSR),
+  FR_FLAG(10U, SCB, CFSR, PRECISERR,   fault_registers.SCB_CFSR),
+  FR_FLAG(11U, SCB, CFSR, IMPRECISERR, fault_registers.SCB_CFSR),
+  FR_FLAG(12U, SCB, CFSR, UNSTKERR,    fault_registers.SCB_CFSR),
+  FR_FLAG(13U, SCB, CFSR, STKERR,      fault_registers.SCB_CFSR),
+#ifdef SCB_CFSR_LSPERR_Msk
+  FR_FLAG(14U, SCB, CFSR, LSPERR,      fault_registers.SCB_CFSR),
+#endif
+  FR_FLAG(15U, SCB, CFSR, BFARVALID,   fault_registers.SCB_CFSR),
+  FR_FLAG(16U, SCB, CFSR, UNDEFINSTR,  fault_registers.SCB_CFSR),
+  FR_FLAG(17U, SCB, CFSR, INVSTATE,    fault_registers.SCB_CFSR),
+  FR_FLAG(18U, SCB, CFSR, INVPC,       fault_registers.SCB_CFSR),
+  FR_FLAG(19U, SCB, CFSR, NOCP,        fault_registers.SCB_CFSR),
+#ifdef SCB_CFSR_STKOF_Msk
+  FR_FLAG(20U, SCB, CFSR, STKOF,       fault_registers.SCB_CFSR),
+#endif
+  FR_FLAG(21U, SCB, CFSR, UNALIGNED,   fault_registers.SCB_CFSR),
+  FR_FLAG(22U, SCB, CFSR, DIVBYZERO,   fault_registers.SCB_CFSR),
+#if (FR_ARCH_ARMV8x_M_MAIN != 0)
+  FR_FLAG(23U, SAU, SFSR, INVEP,       armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(24U, SAU, SFSR, INVIS,       armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(25U, SAU, SFSR, INVER,       armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(26U, SAU, SFSR, AUVIOL,      armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(27U, SAU, SFSR, INVTRAN,     armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(28U, SAU, SFSR, LSPERR,      armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(29U, SAU, SFSR, SFARVALID,   armv8_m_fault_registers.SCB_SFSR),
+  FR_FLAG(30U, SAU, SFSR, LSERR,       armv8_m_fault_registers.SCB_SFSR),
+#endif
+#if ((FR_ARCH_ARMV8_1_M_MAIN != 0) && defined(SCB_RFSR_V_Msk))
+  FR_FLAG(31U, SCB, RFSR, V,           armv8_1_m_registers.SCB_RFSR),
+#endif
+};
+#endif
+
+/**
+  Write data to the encoder output (data beyond buffer size is only counted).
+  \param[in]    enc             pointer to encoder
+  \param[in]    data            pointer to data
+  \param[in]    len             data length in bytes
+*/
+static void EncWrite (Encoder_Type *enc, const void *data, uint32_t len) {
+  const uint8_t *ptr = (const uint8_t *)data;
+  uint32_t       i;
+
+  for (i = 0U; i < len; i++) {
+    if (enc->pos < enc->size) {
+      enc->buf[enc->pos] = ptr[i];
+    }
+    enc->pos++;
+  }
+}
+
+/**
+  Write CBOR data item head.
+  \param[in]    enc             pointer to encoder
+  \param[in]    major           CBOR major type
+  \param[in]    val             argument (value or length)
+*/
+static void CborWriteHead (Encoder_Type *enc, uint8_t major, uint32_t val) {
+  uint8_t  head[5];
+  uint32_t len;
+
+  if (val < 24U) {
+    head[0] = (uint8_t)((major << 5) | val);
+    len = 1U;
+  } else if (val <= 0xFFU) {
+    head[0] = (uint8_t)((major << 5) | 24U);
+    head[1] = (uint8_t)val;
+    len = 2U;
+  } else if (val <= 0xFFFFU) {
+    head[0] = (uint8_t)((major << 5) | 25U);
+    head[1] = (uint8_t)(val >> 8);
+    head[2] = (uint8_t)val;
+    len = 3U;
+  } else {
+    head[0] = (uint8_t)((major << 5) | 26U);
+    head[1] = (uint8_t)(val >> 24);
+    head[2] = (uint8_t)(val >> 16);
+    head[3] = (uint8_t)(val >>  8);
+    head[4] = (uint8_t)val;
+    len = 5U;
+  }
+  EncWrite(enc, head, len);
+}
+
+/**
+  Write JSON item separator (if not the first item on current depth).
+  \param[in]    enc             pointer to encoder
+*/
+static void EncItem (Encoder_Type *enc) {
+  if (enc->json != 0U) {
+    if ((enc->first & (1U << enc->depth)) == 0U) {
+      EncWrite(enc, ",", 1U);
+    }
+    enc->first &= (uint8_t)~(1U << enc->depth);
+  }
+}
+
+/**
+  Begin (indefinite length) map or array.
+  \param[in]    enc             pointer to encoder
+  \param[in]    map             == 1 - map, == 0 - array
+*/
+static void EncBegin (Encoder_Type *enc, uint8_t map) {
+  if (enc->json != 0U) {
+    EncWrite(enc, (map != 0U) ? "{" : "[", 1U);
+  } else {
+    EncWrite(enc, (map != 0U) ? "\xBF" : "\x9F", 1U);
+  }
+  enc->depth++;
+  enc->first |= (uint8_t)(1U << enc->depth);
+}
+
+/**
+  End map or array.
+  \param[in]    enc             pointer to encoder
+  \param[in]    map             == 1 - map, == 0 - array
+*/
+static void EncEnd (Encoder_Type *enc, uint8_t map) {
+  enc->depth--;
+  if (enc->json != 0U) {
+    EncWrite(enc, (map != 0U) ? "}" : "]", 1U);
+  } else {
+    EncWrite(enc, "\xFF", 1U);
+  }
+}
+
+/**
+  Write text string.
+  \param[in]    enc             pointer to encoder
+  \param[in]    str             null-terminated string (without characters that need escaping in JSON)
+*/
+static void EncText (Encoder_Type *enc, const char *str) {
+  uint32_t len = (uint32_t)strlen(str);
+
+  if (enc->json != 0U) {
+    EncWrite(enc, "\"", 1U);
+    EncWrite(enc, str, len);
+    EncWrite(enc, "\"", 1U);
+  } else {
+    CborWriteHead(enc, 3U, len);
+    EncWrite(enc, str, len);
+  }
+}
+
+/**
+  Write map key (text in JSON, integer key ID in CBOR).
+  \param[in]    enc             pointer to encoder
+  \param[in]    id              key ID
+  \param[in]    key             null-terminated key
+*/
+static void EncKey (Encoder_Type *enc, uint8_t id, const char *key) {
+  EncItem(enc);
+  if (enc->json != 0U) {
+    EncText(enc, key);
+    EncWrite(enc, ":", 1U);
+  } else {
+    CborWriteHead(enc, 0U, id);
+  }
+}
+
+/**
+  Write unsigned integer.
+  \param[in]    enc             pointer to encoder
+  \param[in]    val             value
+*/
+static void EncUint (Encoder_Type *enc, uint32_t val) {
+  char     str[10];
+  uint32_t i;
+
+  if (enc->json != 0U) {
+    i = sizeof(str);
+    do {
+      i--;
+      str[i] = (char)('0' + (val % 10U));
+      val /= 10U;
+    } while (val != 0U);
+    EncWrite(enc, &str[i], sizeof(str) - i);
+  } else {
+    CborWriteHead(enc, 0U, val);
+  }
+}
+
+/**
+  Write signed integer.
+  \param[in]    enc             pointer to encoder
+  \param[in]    val             value
+*/
+static void EncInt (Encoder_Type *enc, int32_t val) {
+  if (val >= 0) {
+    EncUint(enc, (uint32_t)val);
+  } else if (enc->json != 0U) {
+    EncWrite(enc, "-", 1U);
+    EncUint(enc, (uint32_t)(-(val + 1)) + 1U);
+  } else {
+    CborWriteHead(enc, 1U, (uint32_t)(-(val + 1)));
+  }
+}
+
+/**
+  Write boolean.
+  \param[in]    enc             pointer to encoder
+  \param[in]    val             value (0 = false)
+*/
+static void EncBool (Encoder_Type *enc, uint32_t val) {
+  if (enc->json != 0U) {
+    if (val != 0U) {
+      EncWrite(enc, "true", 4U);
+    } else {
+      EncWrite(enc, "false", 5U);
+    }
+  } else {
+    EncWrite(enc, (val != 0U) ? "\xF5" : "\xF4", 1U);
+  }
+}
+
+/**
+  Encode fault information of one FaultInfo slot as map.
+  \param[in]    enc             pointer to encoder
+  \param[in]    ptr_fi          pointer to fault information
+*/
+static void EncFaultInfo (Encoder_Type *enc, const FaultInfo_Type *ptr_fi) {
+  const uint8_t *ptr_base = (const uint8_t *)ptr_fi;
+  uint32_t       type, val, i;
+#if (FR_BUILD_ID_EXIST != 0)
+  static const char hex_digit[] = "0123456789abcdef";
+  char           build_id[(FR_BUILD_ID_LEN * 2U) + 1U];
+#endif
+
+  EncBegin(enc, 1U);
+
+  EncKey (enc, FR_KEY_VERSION_MAJOR, "version_major");
+  EncUint(enc, ptr_fi->type.version.major);
+  EncKey (enc, FR_KEY_VERSION_MINOR, "version_minor");
+  EncUint(enc, ptr_fi->type.version.minor);
+  EncKey (enc, FR_KEY_SECURE, "secure");
+  EncBool(enc, ptr_fi->type.secure);
+  EncKey (enc, FR_KEY_HANG, "hang");
+  EncBool(enc, ptr_fi->type.hang);
+  EncKey (enc, FR_KEY_NEAR_MISS, "near_miss");
+  EncBool(enc, ptr_fi->type.near_miss);
+  EncKey (enc, FR_KEY_EXCEPTION, "exception");
+  EncUint(enc, ptr_fi->common_registers.xPSR & IPSR_ISR_Msk);
+  EncKey (enc, FR_KEY_STATE_CONTEXT_VALID, "state_context_valid");
+#if (FR_FAULT_REGS_EXIST != 0)
+  EncBool(enc, ((ptr_fi->fault_registers.SCB_CFSR & (SCB_CFSR_Stack_Err_Msk)) == 0U) ? 1U : 0U);
+#else
+  EncBool(enc, 1U);
+#endif
+
+  memcpy(&type, &ptr_fi->type, sizeof(type));
+  for (i = 0U; i < (sizeof(FieldDesc) / sizeof(FieldDesc[0])); i++) {
+    if ((FieldDesc[i].type_pos == 0U) || ((type & (1UL << FieldDesc[i].type_pos)) != 0U)) {
+      memcpy(&val, &ptr_base[FieldDesc[i].offset], sizeof(val));
+      EncKey (enc, FieldDesc[i].id, FieldDesc[i].key);
+      EncUint(enc, val);
+    }
+  }
+
+#if (FR_BUILD_ID_EXIST != 0)
+  if (ptr_fi->type.build_id != 0U) {
+    EncKey (enc, FR_KEY_BUILD_ID, "build_id");
+    for (i = 0U; i < FR_BUILD_ID_LEN; i++) {
+      build_id[(i * 2U)     ] = hex_digit[ptr_fi->build_id[i] >> 4];
+      build_id[(i * 2U) + 1U] = hex_digit[ptr_fi->build_id[i] & 0x0FU];
+    }
+    build_id[FR_BUILD_ID_LEN * 2U] = '\0';
+    EncText(enc, build_id);
+  }
+#endif
+
+  EncKey  (enc, FR_KEY_FAULTS, "faults");
+  EncBegin(enc, 0U);
+#if (FR_FAULT_REGS_EXIST != 0)
+  for (i = 0U; i < (sizeof(FlagDesc) / sizeof(FlagDesc[0])); i++) {
+    if ((FlagDesc[i].offset == offsetof(FaultInfo_Type, fault_registers.SCB_CFSR)) ||
+        (FlagDesc[i].offset == offsetof(FaultInfo_Type, fault_registers.SCB_HFSR)) ||
+#if (FR_ARCH_ARMV8_1_M_MAIN != 0)
+        (FlagDesc[i].offset == offsetof(FaultInfo_Type, armv8_1_m_registers.SCB_RFSR)) ||
+#endif
+        (ptr_fi->type.secure != 0U)) {
+      memcpy(&val, &ptr_base[FlagDesc[i].offset], sizeof(val));
+      if ((val & FlagDesc[i].mask) != 0U) {
+        EncItem(enc);
+        if (enc->json != 0U) {
+          EncText(enc, FlagDesc[i].key);
+        } else {
+          CborWriteHead(enc, 0U, FlagDesc[i].id);
+        }
+      }
+    }
+  }
+#endif
+  EncEnd(enc, 0U);
+
+#if (FR_STACK_MONITOR_EXIST != 0)
+  if (ptr_fi->type.near_miss != 0U) {
+    EncKey  (enc, FR_KEY_NEAR_MISS_STACK, "near_miss_stack");
+    EncText (enc, (ptr_fi->near_miss.stack == FR_STACK_MONITOR_PSP) ? "PSP" : "MSP");
+    EncKey  (enc, FR_KEY_NEAR_MISS_LIMIT, "near_miss_limit");
+    EncUint (enc, ptr_fi->near_miss.limit);
+    EncKey  (enc, FR_KEY_NEAR_MISS_HEADROOM, "near_miss_headroom");
+    EncInt  (enc, ptr_fi->near_miss.headroom);
+    EncKey  (enc, FR_KEY_NEAR_MISS_EVENT, "near_miss_event");
+    EncUint (enc, ptr_fi->near_miss.event);
+  }
+#endif
+
+#if (FR_BACKTRACE_EXIST != 0)
+  if (ptr_fi->type.backtrace != 0U) {
+    EncKey  (enc, FR_KEY_BACKTRACE_SP, "backtrace_sp");
+    EncUint (enc, ptr_fi->backtrace.sp);
+    EncKey  (enc, FR_KEY_BACKTRACE, "backtrace");
+    EncBegin(enc, 0U);
+    for (i = 0U; (i < ptr_fi->backtrace.count) && (i < FR_BACKTRACE_DEPTH); i++) {
+      EncItem(enc);
+      EncUint(enc, ptr_fi->backtrace.addr[i]);
+    }
+    EncEnd(enc, 0U);
+  }
+#endif
+
+#if (FR_STACK_USAGE_EXIST != 0)
+  if (ptr_fi->type.stack_usage != 0U) {
+    EncKey  (enc, FR_KEY_STACKS, "stacks");
+    EncBegin(enc, 0U);
+    for (i = 0U; i < FR_STACK_NUM; i++) {
+      if (ptr_fi->stack_usage[i].size != 0U) {
+        EncItem (enc);
+        EncBegin(enc, 1U);
+        EncKey  (enc, FR_KEY_BASE, "base");
+        EncUint (enc, ptr_fi->stack_usage[i].base);
+        EncKey  (enc, FR_KEY_SIZE, "size");
+        EncUint (enc, ptr_fi->stack_usage[i].size);
+        EncKey  (enc, FR_KEY_UNUSED, "unused");
+        EncUint (enc, ptr_fi->stack_usage[i].unused);
+        EncEnd  (enc, 1U);
+      }
+    }
+    EncEnd(enc, 0U);
+  }
+#endif
+
+#if (FR_EXIT_ACTIONS_EXIST != 0)
+  if (ptr_fi->type.exit_actions != 0U) {
+    EncKey  (enc, FR_KEY_EXIT_ACTIONS, "exit_actions");
+    EncBegin(enc, 0U);
+    for (i = 0U; i < FR_EXIT_ACTION_NUM; i++) {
+      if (ptr_fi->exit_actions[i].status != FR_EXIT_ACTION_NOT_RUN) {
+        EncItem (enc);
+        EncBegin(enc, 1U);
+        EncKey  (enc, FR_KEY_STATUS, "status");
+        EncUint (enc, ptr_fi->exit_actions[i].status);
+        EncKey  (enc, FR_KEY_ELAPSED, "elapsed");
+        EncUint (enc, ptr_fi->exit_actions[i].elapsed);
+        EncEnd  (enc, 1U);
+      }
+    }
+    EncEnd(enc, 0U);
+  }
+#endif
+
+  EncEnd(enc, 1U);
+}
+
+/**
+  Encode recorded fault information (of all cores) and stack near-miss records as array of maps.
+  \param[in]    enc             pointer to initialized encoder
+  \return       number of encoded bytes or -1 if there is no valid fault information
+*/
+static int32_t EncFaultRecord (Encoder_Type *enc) {
+  uint32_t order[FR_CORE_NUM];
+  uint32_t num, i, cnt;
+#if (FR_STACK_MONITOR_EXIST != 0)
+  const FaultInfo_Type *ptr_first, *ptr_worst;
+#endif
+
+  num = FaultInfoOrder(order);
+  cnt = 0U;
+
+  EncBegin(enc, 0U);
+  for (i = 0U; i < num; i++) {
+    const FaultInfo_Type *ptr_fi = &FaultInfo[order[i]];
+    if (ptr_fi->crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_fi), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM)) {
+      EncItem(enc);
+      EncFaultInfo(enc, ptr_fi);
+      cnt++;
+    }
+  }
+#if (FR_STACK_MONITOR_EXIST != 0)
+  // First and worst near-miss event of each core (worst only if it is another event)
+  for (i = 0U; i < FR_CORE_NUM; i++) {
+    ptr_first = &StackNearMiss[i][0];
+    ptr_worst = &StackNearMiss[i][1];
+    if ((ptr_first->magic_number == FR_MAGIC_NUMBER) &&
+        (ptr_first->crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_first), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM))) {
+      EncItem(enc);
+      EncFaultInfo(enc, ptr_first);
+      cnt++;
+    } else {
+      ptr_first = NULL;
+    }
+    if ((ptr_worst->magic_number == FR_MAGIC_NUMBER) &&
+        ((ptr_first == NULL) || (ptr_worst->near_miss.event != ptr_first->near_miss.event)) &&
+        (ptr_worst->crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_worst), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM))) {
+      EncItem(enc);
+      EncFaultInfo(enc, ptr_worst);
+      cnt++;
+    }
+  }
+#endif
+  EncEnd(enc, 0U);
+
+  if (cnt == 0U) {
+    return -1;
+  }
+
+  return (int32_t)enc->pos;
+}
+
+/**
+  Encode the recorded fault information as CBOR (RFC 8949).
+  Output is an array with one map per recorded fault (per core), containing all
+  fields of the fault information and the decoded fault flags with stable integer
+  key and flag IDs, followed by one map per stack near-miss record (first and worst
+  event per core).
+  \param[out]   buf             pointer to buffer for encoded data
+  \param[in]    size            buffer size in bytes
+  \return       size of complete encoding in bytes (data was truncated if greater than size)
+                or -1 if there is no valid fault information (and no near-miss record)
+*/
+int32_t FaultRecordEncodeCBOR (uint8_t *buf, uint32_t size) {
+  Encoder_Type enc;
+
+  memset(&enc, 0, sizeof(enc));
+  enc.buf  = buf;
+  enc.size = size;
+  enc.json = 0U;
+
+  return EncFaultRecord(&enc);
+}
+
+/**
+  Encode the recorded fault information as JSON (RFC 8259).
+  Output has the same structure as FaultRecordEncodeCBOR output, with text keys and
+  fault flags instead of IDs, and is null-terminated if buffer is large enough.
+  \param[out]   buf             pointer to buffer for encoded text
+  \param[in]    size            buffer size in bytes
+  \return       length of complete encoding in bytes (excluding null terminator,
+                text was truncated if not less than size) or -1 if there is no
+                valid fault information
+*/
+int32_t FaultRecordEncodeJSON (char *buf, uint32_t size) {
+  Encoder_Type enc;
+  int32_t      len;
+
+  memset(&enc, 0, sizeof(enc));
+  enc.buf  = (uint8_t *)buf;
+  enc.size = size;
+  enc.json = 1U;
+
+  len = EncFaultRecord(&enc);
+  if (enc.pos < size) {
+    buf[enc.pos] = '\0';
+  }
+
+  return len;
+}
+
+// Transport functions ---------------------------------------------------------
+
+#if (FR_TRANSPORT_WINDOW != 0U)
+/**
+  Calculate check value of the transport state.
+  \return       check value
+*/
+static uint32_t TransportStateCheck (void) {
+  return ~(TransportState.magic_number ^ TransportState.session    ^ TransportState.total ^
+           TransportState.chunk_size   ^ TransportState.base       ^ TransportState.acked);
+}
+
+/**
+  Add region to the transferred data and to the manifest.
+  \param[in]    id              region ID
+  \param[in]    ptr             pointer to region data
+  \param[in]    len             region length in bytes
+*/
+static void TransportAddRegion (uint32_t id, const void *ptr, uint32_t len) {
+  TransportManifest[2U + (2U * TransportManifest[1])] = id;
+  TransportManifest[3U + (2U * TransportManifest[1])] = len;
+  TransportManifest[1]++;
+
+  TransportRegion[TransportRegionNum].ptr = (const uint8_t *)ptr;
+  TransportRegion[TransportRegionNum].len = len;
+  TransportRegionNum++;
+}
+
+/**
+  Copy part of the transferred data (directly from the regions).
+  \param[in]    ofs             offset in the transferred data
+  \param[out]   dst             pointer to destination
+  \param[in]    len             number of bytes to copy
+*/
+static void TransportCopy (uint32_t ofs, uint8_t *dst, uint32_t len) {
+  uint32_t i, num;
+
+  for (i = 0U; (i < TransportRegionNum) && (len != 0U); i++) {
+    if (ofs >= TransportRegion[i].len) {
+      ofs -= TransportRegion[i].len;
+    } else {
+      num = TransportRegion[i].len - ofs;
+      if (num > len) {
+        num = len;
+      }
+      memcpy(dst, &TransportRegion[i].ptr[ofs], num);
+      dst += num;
+      len -= num;
+      ofs  = 0U;
+    }
+  }
+}
+
+/**
+  Number of chunks not acknowledged yet.
+  \return       number of chunks
+*/
+static int32_t TransportRemaining (void) {
+  uint32_t num = TransportChunkNum - TransportState.base;
+  uint32_t i;
+
+  for (i = 1U; (i < 32U) && (i < num); i++) {
+    if ((TransportState.acked & (1UL << i)) != 0U) {
+      num--;
+    }
+  }
+
+  return (int32_t)num;
+}
+#endif
+
+/**
+  Attach data (for example a snapshot of application state) to the transferred record.
+  Attachments must be registered (in the same order) before each FaultRecordTransportStart,
+  also after reset, and must stay unchanged until the transfer is completed.
+  \param[in]    data            pointer to data
+  \param[in]    len             data length in bytes
+  \return       0 on success, -1 on error (too many attachments or transport disabled)
+*/
+int32_t FaultRecordTransportAttach (const void *data, uint32_t len) {
+#if ((FR_TRANSPORT_WINDOW != 0U) && (FR_TRANSPORT_ATTACH_NUM != 0U))
+  if ((data == NULL) || (TransportAttachNum >= FR_TRANSPORT_ATTACH_NUM)) {
+    return -1;
+  }
+
+  TransportAttach[TransportAttachNum].ptr = (const uint8_t *)data;
+  TransportAttach[TransportAttachNum].len = len;
+  TransportAttachNum++;
+
+  return 0;
+#else
+  (void)data;
+  (void)len;
+  return -1;
+#endif
+}
+
+/**
+  Start or resume the chunked transfer of the recorded fault information.
+  Transferred data: manifest (magic number, number of regions, ID and length of each
+  region), fault information of all cores, nested fault records, fault history and stack
+  near-miss records (if enabled) and attachments. Data is read directly from no-init RAM
+  when chunks are built.
+  The transfer is resumed from the acknowledged chunks if the same data was partially
+  transferred before (also before reset), otherwise a new session is started.
+  \param[in]    mtu             maximum packet size in bytes (FR_TRANSPORT_OVERHEAD + 1 .. + 255)
+  \return       number of chunks still to be transferred (0 = transfer complete)
+                or -1 if there is no fault information or mtu is invalid
+*/
+int32_t FaultRecordTransportStart (uint32_t mtu) {
+#if (FR_TRANSPORT_WINDOW != 0U)
+  uint32_t session, total, chunk_size, i, valid;
+
+  if ((mtu <= FR_TRANSPORT_OVERHEAD) || (mtu > (FR_TRANSPORT_OVERHEAD + 255U))) {
+    return -1;
+  }
+  chunk_size = mtu - FR_TRANSPORT_OVERHEAD;
+
+  valid = 0U;
+  for (i = 0U; i < FR_CORE_NUM; i++) {
+    if (FR_FAULT_INFO_COMPLETE(&FaultInfo[i])) {
+      valid = 1U;
+    }
+  }
+  if (valid == 0U) {
+    return -1;
+  }
+
+  // Build region list and manifest
+  TransportRegionNum   = 0U;
+  TransportManifest[0] = FR_TRANSPORT_MAGIC;
+  TransportManifest[1] = 0U;
+  TransportRegion[TransportRegionNum].ptr = (const uint8_t *)TransportManifest;
+  TransportRegionNum++;
+  TransportAddRegion(1U, FaultInfo,    sizeof(FaultInfo));
+  TransportAddRegion(2U, FaultNested,  sizeof(FaultNested));
+#if (FR_HISTORY_SIZE != 0U)
+  TransportAddRegion(3U, &FaultHistory, sizeof(FaultHistory));
+#endif
+#if (FR_STACK_MONITOR_EXIST != 0)
+  TransportAddRegion(4U, StackNearMiss, sizeof(StackNearMiss));
+#endif
+#if (FR_TRANSPORT_ATTACH_NUM != 0U)
+  for (i = 0U; i < TransportAttachNum; i++) {
+    TransportAddRegion(FR_TRANSPORT_REGION_ID_ATTACH + i, TransportAttach[i].ptr, TransportAttach[i].len);
+  }
+#endif
+  TransportRegion[0].len = (2U + (2U * TransportManifest[1])) * 4U;
+
+  // Session is identified by the CRC-32 of the transferred data
+  session = FR_CRC32_INIT_VAL;
+  total   = 0U;
+  for (i = 0U; i < TransportRegionNum; i++) {
+    session = CalcCRC32(session, TransportRegion[i].ptr, TransportRegion[i].len, FR_CRC32_POLYNOM);
+    total  += TransportRegion[i].len;
+  }
+  TransportChunkNum = (total + chunk_size - 1U) / chunk_size;
+  if (TransportChunkNum > 0xFFFFU) {
+    return -1;
+  }
+
+  // Resume previous session or start a new one
+  if ((TransportState.magic_number != FR_TRANSPORT_MAGIC)    ||
+      (TransportState.check        != TransportStateCheck()) ||
+      (TransportState.session      != session)               ||
+      (TransportState.total        != total)                 ||
+      (TransportState.chunk_size   != chunk_size)            ||
+      (TransportState.base          > TransportChunkNum)) {
+    TransportState.magic_number = FR_TRANSPORT_MAGIC;
+    TransportState.session      = session;
+    TransportState.total        = total;
+    TransportState.chunk_size   = chunk_size;
+    TransportState.base         = 0U;
+    TransportState.acked        = 0U;
+    TransportState.check        = TransportStateCheck();
+  }
+  TransportNext = TransportState.base;
+
+  return TransportRemaining();
+#else
+  (void)mtu;
+  return -1;
+#endif
+}
+
+/**
+  Build the next chunk packet to be sent.
+  Chunks within the window (FR_TRANSPORT_WINDOW chunks from the first unacknowledged
+  one) that are not acknowledged are sent in turn, so unacknowledged chunks are
+  repeated until the acknowledgement arrives. Does not block.
+  Chunk packet: type ("C"), chunk size, sequence number (16-bit), session, total length
+  (32-bit, little-endian), payload (chunk size or less for the last chunk) and CRC-32
+  of the preceding bytes.
+  \param[out]   pkt             pointer to buffer for packet
+  \param[in]    size            buffer size in bytes (mtu used with FaultRecordTransportStart)
+  \return       packet length in bytes, 0 if transfer is complete
+                or -1 if transfer was not started or buffer is too small
+*/
+int32_t FaultRecordTransportNext (uint8_t *pkt, uint32_t size) {
+#if (FR_TRANSPORT_WINDOW != 0U)
+  uint32_t seq, end, ofs, len, crc, i;
+  uint16_t seq16;
+
+  if ((TransportChunkNum == 0U) || (TransportState.magic_number != FR_TRANSPORT_MAGIC)) {
+    return -1;
+  }
+  if (TransportState.base >= TransportChunkNum) {
+    return 0;
+  }
+
+  // Find next unacknowledged chunk in the window
+  end = TransportState.base + FR_TRANSPORT_WINDOW;
+  if (end > TransportChunkNum) {
+    end = TransportChunkNum;
+  }
+  seq = TransportNext;
+  for (i = 0U; i < FR_TRANSPORT_WINDOW; i++) {
+    if ((seq < TransportState.base) || (seq >= end)) {
+      seq = TransportState.base;
+    }
+    if ((TransportState.acked & (1UL << (seq - TransportState.base))) == 0U) {
+      break;
+    }
+    seq++;
+  }
+  TransportNext = seq + 1U;
+
+  ofs = seq * TransportState.chunk_size;
+  len = TransportState.total - ofs;
+  if (len > TransportState.chunk_size) {
+    len = TransportState.chunk_size;
+  }
+  if (size < (FR_TRANSPORT_OVERHEAD + len)) {
+    return -1;
+  }
+
+  seq16  = (uint16_t)seq;
+  pkt[0] = FR_TRANSPORT_CHUNK;
+  pkt[1] = (uint8_t)TransportState.chunk_size;
+  memcpy(&pkt[2], &seq16,                  2U);
+  memcpy(&pkt[4], &TransportState.session, 4U);
+  memcpy(&pkt[8], &TransportState.total,   4U);
+  TransportCopy(ofs, &pkt[FR_TRANSPORT_HDR_LEN], len);
+  len += FR_TRANSPORT_HDR_LEN;
+  crc  = CalcCRC32(FR_CRC32_INIT_VAL, pkt, len, FR_CRC32_POLYNOM);
+  memcpy(&pkt[len], &crc, 4U);
+
+  return (int32_t)(len + 4U);
+#else
+  (void)pkt;
+  (void)size;
+  return -1;
+#endif
+}
+
+/**
+  Process an acknowledgement packet received from the receiver.
+  Acknowledgement packet: type ("A"), 0, base (16-bit, all chunks before base were
+  received), session, bitmap (32-bit, bit n = chunk base + n was received) and CRC-32
+  of the preceding bytes. The acknowledged state is kept over resets.
+  \param[in]    pkt             pointer to packet
+  \param[in]    len             packet length in bytes
+  \return       number of chunks still to be transferred (0 = transfer complete)
+                or -1 if packet is invalid or does not belong to the current session
+*/
+int32_t FaultRecordTransportAck (const uint8_t *pkt, uint32_t len) {
+#if (FR_TRANSPORT_WINDOW != 0U)
+  uint32_t session, bitmap, crc, base, shift;
+  uint16_t base16;
+
+  if ((TransportChunkNum == 0U) || (len != FR_TRANSPORT_ACK_LEN) || (pkt[0] != FR_TRANSPORT_ACK)) {
+    return -1;
+  }
+  memcpy(&crc, &pkt[12], 4U);
+  if (crc != CalcCRC32(FR_CRC32_INIT_VAL, pkt, 12U, FR_CRC32_POLYNOM)) {
+    return -1;
+  }
+  memcpy(&base16,  &pkt[2], 2U);
+  memcpy(&session, &pkt[4], 4U);
+  memcpy(&bitmap,  &pkt[8], 4U);
+  if ((session != TransportState.session) || (base16 > TransportChunkNum)) {
+    return -1;
+  }
+  base = base16;
+
+  // Align bitmaps to the new base and merge them
+  if (base > TransportState.base) {
+    shift = base - TransportState.base;
+    TransportState.acked = (shift < 32U) ? (TransportState.acked >> shift) : 0U;
+    TransportState.base  = base;
+  } else {
+    shift  = TransportState.base - base;
+    bitmap = (shift < 32U) ? (bitmap >> shift) : 0U;
+  }
+  TransportState.acked |= bitmap;
+
+  // Advance base over chunks acknowledged in sequence
+  while ((TransportState.acked & 1U) != 0U) {
+    TransportState.acked >>= 1;
+    TransportState.base++;
+  }
+  if (TransportState.base > TransportChunkNum) {
+    TransportState.base = TransportChunkNum;
+  }
+  TransportState.check = TransportStateCheck();
+
+  return TransportRemaining();
+#else
+  (void)pkt;
+  (void)len;
+  return -1;
+#endif
+}
+
+// Non-secure callable functions -----------------------------------------------
+
+#if (FR_NS_ACCESS_EXIST != 0)
+#include <arm_cmse.h>
+
+#define FR_NS_ENTRY            __attribute__((cmse_nonsecure_entry))
+
+/**
+  Check that a buffer provided by the Non-secure caller is Non-secure memory
+  writable by the caller (with the caller's privilege level).
+  \param[in]    buf             pointer to buffer
+  \param[in]    size            buffer size in bytes
+  \return       0 if buffer is accessible or -1 otherwise
+*/
+static int32_t NsBufferCheck (void *buf, uint32_t size) {
+  int flags = CMSE_NONSECURE | CMSE_MPU_READWRITE;
+
+  if (size == 0U) {
+    return 0;
+  }
+  if ((__get_IPSR() == 0U) && ((__TZ_get_CONTROL_NS() & CONTROL_nPRIV_Msk) != 0U)) {
+    flags |= CMSE_MPU_UNPRIV;           // Caller is unprivileged Non-secure thread
+  }
+  if (cmse_check_address_range(buf, size, flags) == NULL) {
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+  Get summary of the recorded fault information (Non-secure callable).
+  Does not change the record or the boot counters (unlike FaultRecordCheck).
+  \param[out]   summary         pointer to summary (in Non-secure memory) of the most recent
+                                valid fault record and of the boot counters
+  \return       number of valid fault records (0 = none) or -1 if summary is not accessible
+*/
+FR_NS_ENTRY int32_t FaultRecordSummary_S (FaultRecordSummary_t *summary) {
+  const FaultInfo_Type *ptr_fi = NULL;
+  uint32_t              order[FR_CORE_NUM];
+  uint32_t              num, i, cnt;
+
+  if ((summary == NULL) || (NsBufferCheck(summary, sizeof(FaultRecordSummary_t)) != 0)) {
+    return -1;
+  }
+
+  num = FaultInfoOrder(order);
+  cnt = 0U;
+  for (i = 0U; i < num; i++) {
+    if (FaultInfo[order[i]].crc32 == CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(&FaultInfo[order[i]]), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM)) {
+      ptr_fi = &FaultInfo[order[i]];
+      cnt++;
+    }
+  }
+
+  if (ptr_fi != NULL) {
+    summary->exception = ptr_fi->common_registers.xPSR & IPSR_ISR_Msk;
+    summary->pc        = ptr_fi->state_context.ReturnAddress;
+    summary->hang      = ptr_fi->type.hang;
+  } else {
+    summary->exception = 0U;
+    summary->pc        = 0U;
+    summary->hang      = 0U;
+  }
+  summary->interrupted = 0U;
+  if ((BootInfo.magic_number == FR_MAGIC_NUMBER) && (BootInfo.check == BootInfoCheck())) {
+    summary->boot_count  = BootInfo.boot_count;
+    summary->fault_count = BootInfo.fault_count;
+  } else {
+    summary->boot_count  = 0U;
+    summary->fault_count = 0U;
+  }
+
+  return (int32_t)cnt;
+}
+
+/**
+  Encode the recorded fault information as CBOR into a Non-secure buffer (Non-secure callable).
+  The buffer is checked and then written once by the encoder, the record is not copied.
+  \param[out]   buf             pointer to buffer (in Non-secure memory, NULL if size is 0)
+  \param[in]    size            buffer size in bytes (0 = only return the encoded size)
+  \return       see FaultRecordEncodeCBOR, -1 also if buffer is not accessible
+*/
+FR_NS_ENTRY int32_t FaultRecordEncodeCBOR_S (uint8_t *buf, uint32_t size) {
+
+  if (NsBufferCheck(buf, size) != 0) {
+    return -1;
+  }
+
+  return FaultRecordEncodeCBOR(buf, size);
+}
+
+/**
+  Encode the recorded fault information as JSON into a Non-secure buffer (Non-secure callable).
+  \param[out]   buf             pointer to buffer (in Non-secure memory, NULL if size is 0)
+  \param[in]    size            buffer size in bytes (0 = only return the encoded length)
+  \return       see FaultRecordEncodeJSON, -1 also if buffer is not accessible
+*/
+FR_NS_ENTRY int32_t FaultRecordEncodeJSON_S (char *buf, uint32_t size) {
+
+  if (NsBufferCheck(buf, size) != 0) {
+    return -1;
+  }
+
+  return FaultRecordEncodeJSON(buf, size);
+}
+
+/**
+  Clear the recorded fault information (Non-secure callable).
+*/
+FR_NS_ENTRY void FaultRecordClear_S (void) {
+  FaultRecordClear();
+}
+#endif
+
+// Helper functions
+
+#if ((FR_EXIT_ACTIONS_EXIST != 0) || (FR_STACK_MONITOR_EXIST != 0))
+/**
+  Determine the FaultInfo slot of the core executing this code (same as FaultRecord).
+  \return       slot index (core ID, limited to FR_CORE_NUM - 1)
+*/
+static uint32_t CoreSlot (void) {
+#if (FR_CORE_NUM > 1U)
+  uint32_t id = ((*(volatile const uint32_t *)(FR_CORE_ID_ADDR)) >> FR_CORE_ID_POS) & FR_CORE_ID_MSK;
+
+  if (id > (FR_CORE_NUM - 1U)) {
+    id = FR_CORE_NUM - 1U;
+  }
+
+  return id;
+#else
+  return 0U;
+#endif
+}
+#endif
+
+#ifdef __ICCARM__
+#pragma diag_suppress=Pe940
+#endif
+
+#if (FR_HISTORY_SIZE != 0U)
+/**
+  Encode one fault history entry.
+  \param[in]    tag             FR_HISTORY_TAG_KEYFRAME or FR_HISTORY_TAG_DELTA
+  \param[in]    ref             reference (previous) record, not used for keyframe
+  \param[in]    rec             record to encode
+  \param[out]   ptr_entry       pointer to buffer for entry (FR_HISTORY_ENTRY_MAX bytes)
+  \return       size of entry in bytes
+*/
+static uint32_t HistoryEncodeEntry (      uint8_t   tag,
+                                    const uint32_t *ref,
+                                    const uint32_t *rec,
+                                          uint8_t  *ptr_entry) {
+  uint32_t ofs, i, val;
+
+  ptr_entry[0] = tag;
+  memset(&ptr_entry[1], 0, FR_HISTORY_MASK_LEN);
+  ofs = 1U + FR_HISTORY_MASK_LEN;
+
+  for (i = 0U; i < FR_HISTORY_REC_WORDS; i++) {
+    val = rec[i];
+    if (tag == FR_HISTORY_TAG_DELTA) {
+      val ^= ref[i];
+    }
+    if (val != 0U) {
+      ptr_entry[1U + (i / 8U)] |= (uint8_t)(1U << (i % 8U));
+      while (val >= 0x80U) {
+        ptr_entry[ofs++] = (uint8_t)(val | 0x80U);
+        val >>= 7;
+      }
+      ptr_entry[ofs++] = (uint8_t)val;
+    }
+  }
+
+  return ofs;
+}
+
+/**
+  Decode one fault history entry.
+  \param[in]     ptr_entry      pointer to entry
+  \param[in]     len            number of bytes available at ptr_entry
+  \param[in,out] rec            previous record on input, decoded record on output
+  \return        size of entry in bytes or 0 if entry is invalid
+*/
+static uint32_t HistoryDecodeEntry (const uint8_t  *ptr_entry,
+                                          uint32_t  len,
+                                          uint32_t *rec) {
+  uint32_t ofs, i, val, shift;
+  uint8_t  byte;
+
+  if (len < (1U + FR_HISTORY_MASK_LEN)) {
+    return 0U;
+  }
+  if (ptr_entry[0] == FR_HISTORY_TAG_KEYFRAME) {
+    memset(rec, 0, FR_HISTORY_REC_WORDS * 4U);
+  } else if (ptr_entry[0] != FR_HISTORY_TAG_DELTA) {
+    return 0U;
+  }
+  ofs = 1U + FR_HISTORY_MASK_LEN;
+
+  for (i = 0U; i < FR_HISTORY_REC_WORDS; i++) {
+    if ((ptr_entry[1U + (i / 8U)] & (1U << (i % 8U))) != 0U) {
+      val   = 0U;
+      shift = 0U;
+      do {
+        if ((ofs >= len) || (shift > 28U)) {
+          return 0U;
+        }
+        byte   = ptr_entry[ofs++];
+        val   |= (uint32_t)(byte & 0x7FU) << shift;
+        shift += 7U;
+      } while ((byte & 0x80U) != 0U);
+      rec[i] ^= val;
+    }
+  }
+
+  return ofs;
+}
 #endif
 
 //lint ++flb "Library Begin (excluded from MISRA check)"
@@ -0,0 +1,13 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    RTE_Components.h
+ * Purpose: Component configuration of the host build of FaultRecorder.c
+ *----------------------------------------------------------------------------*/
+
+#ifndef RTE_COMPONENTS_H
+#define RTE_COMPONENTS_H
+
+#define CMSIS_device_header "host_device.h"
+
+#endif /* RTE_COMPONENTS_H */
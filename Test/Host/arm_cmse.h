@@ -0,0 +1,37 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    arm_cmse.h
+ * Purpose: CMSE intrinsics used by FaultRecorder.c, for the host build
+ *----------------------------------------------------------------------------*/
+
+/* cmse_check_address_range accepts a range unless it overlaps the range set in
+   HostNsDenied (memory not accessible for the Non-secure caller) and records the
+   flags of the last check in HostCmseFlags. */
+
+#ifndef ARM_CMSE_H
+#define ARM_CMSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CMSE_MPU_UNPRIV         (4)
+#define CMSE_MPU_READWRITE      (1)
+#define CMSE_MPU_READ           (8)
+#define CMSE_NONSECURE          (0x10000)
+#define CMSE_AU_NONSECURE       (2)
+
+static uintptr_t HostNsDenied[2];       // Start and end (exclusive) of the denied range
+static int       HostCmseFlags;
+
+static inline void *cmse_check_address_range (void *p, size_t s, int flags) {
+  uintptr_t a = (uintptr_t)p;
+
+  HostCmseFlags = flags;
+  if ((a < HostNsDenied[1]) && ((a + s) > HostNsDenied[0])) {
+    return NULL;
+  }
+  return p;
+}
+
+#endif /* ARM_CMSE_H */
@@ -0,0 +1,130 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    host_device.h
+ * Purpose: CMSIS-Core subset used by FaultRecorder.c, for the host build
+ *----------------------------------------------------------------------------*/
+
+/* The system control block is a variable (HostSCB) that tests can preset,
+   core registers read by C code return the values of the Host* variables.
+   The architecture is selected with the __ARM_ARCH_* define of the test build. */
+
+#ifndef HOST_DEVICE_H
+#define HOST_DEVICE_H
+
+#include <stdint.h>
+
+#define __ASM                   __asm
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#define __IM                    volatile const
+#define __IOM                   volatile
+#define __OM                    volatile
+
+// System Control Block (same register offsets as on the device)
+typedef struct {
+  __IM  uint32_t CPUID;
+  __IOM uint32_t ICSR;
+  __IOM uint32_t VTOR;
+  __IOM uint32_t AIRCR;
+  __IOM uint32_t SCR;
+  __IOM uint32_t CCR;
+  __IOM uint8_t  SHPR[12];
+  __IOM uint32_t SHCSR;
+  __IOM uint32_t CFSR;
+  __IOM uint32_t HFSR;
+  __IOM uint32_t DFSR;
+  __IOM uint32_t MMFAR;
+  __IOM uint32_t BFAR;
+  __IOM uint32_t AFSR;
+        uint32_t RESERVED0[18];
+  __IOM uint32_t CPACR;
+        uint32_t RESERVED1[22];
+  __IOM uint32_t SFSR;
+  __IOM uint32_t SFAR;
+        uint32_t RESERVED2[70];
+  __IOM uint32_t RFSR;
+} SCB_Type;
+
+// Floating-point extension registers
+typedef struct {
+        uint32_t RESERVED0;
+  __IOM uint32_t FPCCR;
+  __IOM uint32_t FPCAR;
+  __IOM uint32_t FPDSCR;
+} FPU_Type;
+
+#define SCS_BASE                (0xE000E000UL)
+#define SCB_BASE                (SCS_BASE + 0x0D00UL)
+#define FPU_BASE                (SCS_BASE + 0x0F30UL)
+#define SCS_BASE_NS             (0xE002E000UL)
+#define SCB_BASE_NS             (SCS_BASE_NS + 0x0D00UL)
+#define FPU_BASE_NS             (SCS_BASE_NS + 0x0F30UL)
+
+static SCB_Type HostSCB;
+#define SCB                     (&HostSCB)
+
+#define IPSR_ISR_Msk            (0x1FFUL)
+#define CONTROL_nPRIV_Msk       (1UL)
+#define EXC_RETURN_S            (0x00000040UL)
+#define EXC_RETURN_DCRS         (0x00000020UL)
+
+#define SCB_HFSR_VECTTBL_Msk    (1UL << 1)
+#define SCB_HFSR_FORCED_Msk     (1UL << 30)
+#define SCB_HFSR_DEBUGEVT_Msk   (1UL << 31)
+#define SCB_CFSR_IACCVIOL_Msk   (1UL << 0)
+#define SCB_CFSR_DACCVIOL_Msk   (1UL << 1)
+#define SCB_CFSR_MUNSTKERR_Msk  (1UL << 3)
+#define SCB_CFSR_MSTKERR_Msk    (1UL << 4)
+#define SCB_CFSR_MLSPERR_Msk    (1UL << 5)
+#define SCB_CFSR_MMARVALID_Msk  (1UL << 7)
+#define SCB_CFSR_IBUSERR_Msk    (1UL << 8)
+#define SCB_CFSR_PRECISERR_Msk  (1UL << 9)
+#define SCB_CFSR_IMPRECISERR_Msk (1UL << 10)
+#define SCB_CFSR_UNSTKERR_Msk   (1UL << 11)
+#define SCB_CFSR_STKERR_Msk     (1UL << 12)
+#define SCB_CFSR_LSPERR_Msk     (1UL << 13)
+#define SCB_CFSR_BFARVALID_Msk  (1UL << 15)
+#define SCB_CFSR_UNDEFINSTR_Msk (1UL << 16)
+#define SCB_CFSR_INVSTATE_Msk   (1UL << 17)
+#define SCB_CFSR_INVPC_Msk      (1UL << 18)
+#define SCB_CFSR_NOCP_Msk       (1UL << 19)
+#if (defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__))
+#define SCB_CFSR_STKOF_Msk      (1UL << 20)
+#endif
+#define SCB_CFSR_UNALIGNED_Msk  (1UL << 24)
+#define SCB_CFSR_DIVBYZERO_Msk  (1UL << 25)
+#if defined(__ARM_ARCH_8_1M_MAIN__)
+#define SCB_RFSR_V_Pos          (31U)
+#define SCB_RFSR_V_Msk          (1UL << SCB_RFSR_V_Pos)
+#define SCB_RFSR_IS_Pos         (16U)
+#define SCB_RFSR_IS_Msk         (0x7FFFUL << SCB_RFSR_IS_Pos)
+#define SCB_RFSR_UET_Pos        (0U)
+#define SCB_RFSR_UET_Msk        (3UL)
+#endif
+
+// Core register values returned to C code
+static uint32_t HostIPSR;
+static uint32_t HostCONTROL_NS;
+
+static inline uint32_t __get_MSP        (void) { return 0U; }
+static inline uint32_t __get_PSP        (void) { return 0U; }
+static inline uint32_t __get_MSPLIM     (void) { return 0U; }
+static inline uint32_t __get_PSPLIM     (void) { return 0U; }
+static inline uint32_t __get_xPSR       (void) { return HostIPSR; }
+static inline uint32_t __get_IPSR       (void) { return HostIPSR; }
+static inline uint32_t __get_CONTROL    (void) { return 0U; }
+static inline uint32_t __get_PRIMASK    (void) { return 0U; }
+static inline void     __set_PRIMASK    (uint32_t v) { (void)v; }
+static inline uint32_t __TZ_get_MSP_NS  (void) { return 0U; }
+static inline uint32_t __TZ_get_PSP_NS  (void) { return 0U; }
+static inline uint32_t __TZ_get_CONTROL_NS (void) { return HostCONTROL_NS; }
+static inline void     __disable_irq    (void) { }
+static inline void     __enable_irq     (void) { }
+static inline void     __DSB            (void) { }
+static inline void     __ISB            (void) { }
+static inline void     __DMB            (void) { }
+__NO_RETURN static inline void NVIC_SystemReset (void) { for (;;) { } }
+
+#endif /* HOST_DEVICE_H */
@@ -0,0 +1,19 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    stdio.h
+ * Purpose: Declarations used by FaultRecorder.c, for the thumb_sim.py compile
+ *----------------------------------------------------------------------------*/
+
+#ifndef STDIO_H
+#define STDIO_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+int printf    (const char *format, ...);
+int snprintf  (char *s, size_t n, const char *format, ...);
+int vsnprintf (char *s, size_t n, const char *format, va_list arg);
+int putchar   (int c);
+
+#endif /* STDIO_H */
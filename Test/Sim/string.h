@@ -0,0 +1,19 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    string.h
+ * Purpose: Declarations used by FaultRecorder.c, for the thumb_sim.py compile
+ *----------------------------------------------------------------------------*/
+
+#ifndef STRING_H
+#define STRING_H
+
+#include <stddef.h>
+
+void  *memset  (void *s, int c, size_t n);
+void  *memcpy  (void *s1, const void *s2, size_t n);
+void  *memmove (void *s1, const void *s2, size_t n);
+int    memcmp  (const void *s1, const void *s2, size_t n);
+size_t strlen  (const char *s);
+
+#endif /* STRING_H */
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - host build of FaultRecorder.c for the tests
+#
+# The C parts of FaultRecorder.c (print, encoders, history, transport, boot
+# check, Non-secure callable functions, ...) are built and run on the host
+# with gcc: the bodies of the naked assembler functions (fault entries) are
+# removed and CalcCRC32 gets a C body. Device and CMSE definitions come from
+# Test/Host.
+#
+# A test is a C file that includes the generated FaultRecorder_host.c, so it
+# can set up and check the static data of FaultRecorder.c directly. Test
+# programs are linked without PIE, so the addresses of static data fit the
+# 32-bit address fields of the records (use static buffers for addresses).
+#
+# Usage (as module):
+#   import host_build
+#   exe = host_build.build('transport_sender.c', ['-D__ARM_ARCH_7EM__', ...], out_dir)
+# -----------------------------------------------------------------------------
+
+import os
+import re
+import subprocess
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(TEST_DIR)
+SOURCE = os.path.join(ROOT, 'Source', 'FaultRecorder.c')
+
+CRC32_BODY = '''
+  uint32_t n;
+
+  while (data_len-- != 0U) {
+    init_val ^= (uint32_t)(*data_ptr++) << 24;
+    for (n = 0U; n < 8U; n++) {
+      init_val = ((init_val & 0x80000000U) != 0U) ? ((init_val << 1) ^ polynom) : (init_val << 1);
+    }
+  }
+  return init_val;
+}'''
+
+
+def host_source(out_dir):
+    """Write FaultRecorder_host.c (host build of FaultRecorder.c) to out_dir and return its path."""
+    with open(SOURCE) as f:
+        src = f.read()
+    out = []
+    pos = 0
+    naked = re.compile(r'__NAKED\s+(?:void|uint32_t)\s+(\w+)\s*\([^;{]*?\)\s*\{', re.S)
+    while True:
+        m = naked.search(src, pos)
+        if not m:
+            out.append(src[pos:])
+            break
+        out.append(src[pos:m.start()] + m.group(0).replace('__NAKED', ''))
+        depth, end = 1, m.end()
+        while depth:
+            depth += {'{': 1, '}': -1}.get(src[end], 0)
+            end += 1
+        out.append(CRC32_BODY if m.group(1) == 'CalcCRC32' else '\n}')
+        pos = end
+    src = ''.join(out).replace('__attribute__((cmse_nonsecure_entry))', '')
+    path = os.path.join(out_dir, 'FaultRecorder_host.c')
+    with open(path, 'w') as f:
+        f.write('// Host build of %s (generated by host_build.py)\n' % os.path.relpath(SOURCE, out_dir))
+        f.write(src)
+    return path
+
+
+def build(test, defines, out_dir, name=None):
+    """Build test C file (name relative to Test) with the defines, return the path of the executable."""
+    os.makedirs(out_dir, exist_ok=True)
+    host_source(out_dir)
+    exe = os.path.join(out_dir, name or os.path.splitext(os.path.basename(test))[0])
+    # uint32_t is unsigned int and pointers are 64-bit on the host: format and pointer cast warnings are expected
+    cmd = ['gcc', '-std=gnu99', '-g', '-fno-pie', '-no-pie', '-Wall', '-Wno-unused-function', '-Wno-unused-variable',
+           '-Wno-format', '-Wno-int-to-pointer-cast', '-Wno-pointer-to-int-cast', '-I' + os.path.join(ROOT, 'Include'), '-I' + os.path.join(TEST_DIR, 'Host'),
+           '-I' + out_dir] + list(defines) + [os.path.join(TEST_DIR, test), '-o', exe]
+    subprocess.run(cmd, check=True)
+    return exe
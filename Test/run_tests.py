@@ -0,0 +1,421 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - host tests
+#
+# Builds test programs from FaultRecorder.c with host_build.py and runs them
+# in several configurations. The configurations are selected with the
+# __ARM_ARCH_* and FR_* defines. The fault entries (assembler) are run by
+# thumb_sim.py; the records they write are then loaded into a host build
+# (test_records.c) and checked in the FaultRecordPrint and JSON outputs.
+#
+# Requirements: python3, gcc (host). Simulator tests additionally need gcc
+# -m32 code generation and the LLVM tools (see thumb_sim.py); without them
+# these tests are reported as skipped.
+#
+# Usage:
+#   run_tests.py [-k name] [--build-dir dir]
+# -----------------------------------------------------------------------------
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import host_build
+import thumb_sim
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+SCRIPTS_DIR = os.path.join(host_build.ROOT, 'Scripts')
+
+FR_MAGIC_NUMBER = 0x52746C46          # "FltR"
+CORE_ID_ADDR = 0xD0000000               # Core ID register (FR_CORE_ID_ADDR) of the simulated devices
+CYCCNT_ADDR = 0xE0001004                # DWT->CYCCNT (FR_TIMESTAMP_ADDR)
+SCB_CFSR = 0xE000ED28
+SCB_CPACR = 0xE000ED88
+SCB_RFSR = 0xE000EF04
+FPU_FPCCR = 0xE000EF34
+
+TESTS = []
+
+
+class Skip(Exception):
+    pass
+
+
+def test(func):
+    TESTS.append(func)
+    return func
+
+
+def run(cmd):
+    """Run command, return (exit code, output)."""
+    p = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    return p.returncode, p.stdout
+
+
+def run_test(test, configs, out_dir):
+    """Build and run test C file in each configuration, return errors."""
+    errors = []
+    for name, defines in configs.items():
+        rc, log = run([host_build.build(test, defines, os.path.join(out_dir, name))])
+        if rc != 0:
+            errors.append('%s:\n%s' % (name, log))
+    return errors
+
+
+def require_sim(out_dir):
+    """Raise Skip if the tools of thumb_sim.py are not available."""
+    missing = [t for t in ('llvm-mc', 'llvm-objcopy', 'llvm-objdump', 'llvm-nm', 'llvm-readelf') if not shutil.which(t)]
+    if missing:
+        raise Skip('%s not found' % ', '.join(missing))
+    os.makedirs(out_dir, exist_ok=True)
+    probe = os.path.join(out_dir, 'm32.c')
+    with open(probe, 'w') as f:
+        f.write('int probe;\n')
+    if run(['gcc', '-m32', '-ffreestanding', '-S', probe, '-o', probe + '.s'])[0] != 0:
+        raise Skip('gcc -m32 not supported')
+
+
+def sim_fault(cpu, entry, exception, frame, core_id=0, timestamp=0, exc_return=0xFFFFFFF9, regs=None):
+    """Simulate fault exception on core core_id and run entry until it calls a C function."""
+    cpu.r = [0] * 16
+    for n, val in (regs or {}).items():
+        cpu.r[n] = val
+    cpu.wr(CORE_ID_ADDR, core_id)
+    cpu.wr(CYCCNT_ADDR, timestamp)
+    cpu.exception(exception, frame, msp=0x20070000, psp=0x20060000, exc_return=exc_return)
+    return cpu.run(entry)
+
+
+def sim_records(cpu, image, exe, out_dir):
+    """Report the records in the simulator memory with test_records, return (exit code, output, JSON maps)."""
+    images = []
+    for name in ('FaultInfo', 'FaultNested'):
+        path = os.path.join(out_dir, name + '.bin')
+        with open(path, 'wb') as f:
+            f.write(cpu.dump(*image.data[name]))
+        images.append(path)
+    rc, log = run([exe] + images)
+    line = [l for l in log.split('\n') if l.startswith('JSON: ')]
+    maps = json.loads(line[0][6:]) if line and line[0] != 'JSON: -1' else []
+    return rc, log, maps
+
+
+@test
+def transport_loopback(out_dir):
+    """FaultRecordTransportStart/Next/Ack against fr_transport.py receive, with packet loss and resets."""
+    configs = {
+        'm0':   ['-D__ARM_ARCH_6M__', '-DFR_TRANSPORT_WINDOW=4U'],
+        'm4':   ['-D__ARM_ARCH_7EM__', '-DFR_TRANSPORT_WINDOW=8U', '-DFR_TRANSPORT_ATTACH_NUM=1U',
+                 '-DFR_HISTORY_SIZE=256U', '-DFR_STACK_MONITOR_HEADROOM=256U'],
+        'm33':  ['-D__ARM_ARCH_8M_MAIN__', '-DFR_TRANSPORT_WINDOW=32U', '-DFR_TRANSPORT_ATTACH_NUM=2U',
+                 '-DFR_HISTORY_SIZE=512U'],
+    }
+    errors = []
+    for name, defines in configs.items():
+        exe = host_build.build('transport_sender.c', defines, os.path.join(out_dir, name))
+        for seed, mtu, loss in ((1, 17, 0.0), (2, 32, 0.3), (3, 64, 0.5), (4, 271, 0.3)):
+            rc, log = run([sys.executable, os.path.join(SCRIPTS_DIR, 'fr_transport.py'), 'loopback',
+                           '--sender', exe, '--seed', str(seed), '--mtu', str(mtu), '--loss', str(loss),
+                           '--resets', '3'])
+            if rc != 0:
+                errors.append('%s mtu %u loss %.1f:\n%s' % (name, mtu, loss, log))
+    return errors
+
+
+@test
+def ns_access(out_dir):
+    """Non-secure callable functions and NsBufferCheck (Test/test_ns_access.c)."""
+    secure = ['-D__ARM_FEATURE_CMSE=3', '-DFR_NS_ACCESS=1']
+    return run_test('test_ns_access.c', {
+        'm23':  ['-D__ARM_ARCH_8M_BASE__'] + secure,
+        'm33':  ['-D__ARM_ARCH_8M_MAIN__'] + secure,
+        'm55':  ['-D__ARM_ARCH_8_1M_MAIN__', '-DFR_HISTORY_SIZE=256U'] + secure,
+    }, out_dir)
+
+
+@test
+def multicore(out_dir):
+    """Per-core FaultInfo slots written by the fault entry (thumb_sim.py), ordered print, history."""
+    require_sim(out_dir)
+    mc = ['-DFR_TIMESTAMP_ADDR=0x%XU' % CYCCNT_ADDR, '-DFR_CORE_ID_ADDR=0x%XU' % CORE_ID_ADDR]
+    configs = {
+        'm0':   (['-D__ARM_ARCH_6M__', '-DFR_CORE_NUM=2U'] + mc, 0, 0xFF),
+        'm4':   (['-D__ARM_ARCH_7EM__', '-DFR_CORE_NUM=2U', '-DFR_CORE_ID_POS=8U', '-DFR_CORE_ID_MSK=0xFU',
+                  '-DFR_HISTORY_SIZE=512U'] + mc, 8, 0xF),
+        'm33':  (['-D__ARM_ARCH_8M_MAIN__', '-DFR_CORE_NUM=3U', '-DFR_HISTORY_SIZE=512U'] + mc, 0, 0xFF),
+    }
+    errors = []
+    for name, (defines, pos, msk) in configs.items():
+        cfg_dir = os.path.join(out_dir, name)
+        image = thumb_sim.build(defines[0][2:], defines[1:], os.path.join(cfg_dir, 'sim'))
+        exe = host_build.build('test_records.c', defines, cfg_dir)
+        cores = int(defines[1].split('=')[1].rstrip('U'))
+        fi, size = image.data['FaultInfo']
+        slot = size // cores
+
+        def check(cond, msg):
+            if not cond:
+                errors.append('%s: %s' % (name, msg))
+
+        # Each core records into its own slot; register bits outside the core ID are ignored
+        cpu = thumb_sim.CPU(image)
+        records = []
+        for n, core in enumerate([1, 0] + list(range(2, cores))):
+            pc = 0x08001000 + 0x100 * core
+            ret = sim_fault(cpu, 'FaultRecord', 3, [core, 0, 0, 0, 0, 0x08000F01, pc, 0x01000000],
+                            core_id=(core << pos) | (~(msk << pos) & 0xA5A5A5A5), timestamp=0xFFFFFFF0 + 0x10 * n)
+            check(ret == 'FaultRecordOnExit', 'core %u: entry stopped at %s' % (core, ret))
+            for other in range(cores):
+                magic = cpu.rd(fi + other * slot)
+                recorded = other == core or other in [r for r, _ in records]
+                check((magic == FR_MAGIC_NUMBER) == recorded,
+                      'core %u: slot %u magic 0x%08X' % (core, other, magic))
+            records.append((core, pc))
+        rc, log, maps = sim_records(cpu, image, exe, cfg_dir)
+        check(rc == 0, 'test_records failed:\n' + log)
+        # Oldest first: timestamps of the cores wrap around after the first recording
+        check([(m.get('core_id'), m.get('ReturnAddress')) for m in maps] == records,
+              'JSON records %s, expected %s' % ([(m.get('core_id'), m.get('ReturnAddress')) for m in maps], records))
+        printed = [int(l.split()[-1]) for l in log.split('\n') if l.strip().startswith('Core:')]
+        check(printed == [core for core, _ in records], 'printed core IDs %s' % printed)
+        if '-DFR_HISTORY_SIZE=512U' in defines:
+            check('(%u entries' % cores in log, 'history does not hold one entry per core:\n' + log)
+
+        # Core ID out of range: last slot
+        cpu = thumb_sim.CPU(image)
+        ret = sim_fault(cpu, 'FaultRecord', 3, [0, 0, 0, 0, 0, 0, 0x08002000, 0x01000000], core_id=(cores + 3) << pos)
+        rc, log, maps = sim_records(cpu, image, exe, cfg_dir)
+        check(cpu.rd(fi + (cores - 1) * slot) == FR_MAGIC_NUMBER and len(maps) == 1 and
+              maps[0].get('core_id') == cores - 1, 'core ID %u not recorded in last slot' % (cores + 3))
+    return errors
+
+
+@test
+def hang(out_dir):
+    """FaultRecordHang from a watchdog pre-timeout interrupt (thumb_sim.py): hang mark in record, print and JSON."""
+    require_sim(out_dir)
+    configs = {
+        'm0':   ['-D__ARM_ARCH_6M__'],
+        'm4':   ['-D__ARM_ARCH_7EM__', '-DFR_CORE_NUM=2U', '-DFR_CORE_ID_ADDR=0x%XU' % CORE_ID_ADDR,
+                 '-DFR_HISTORY_SIZE=256U'],
+        'm33':  ['-D__ARM_ARCH_8M_MAIN__', '-DFR_HISTORY_SIZE=256U'],
+    }
+    wdt_irq = 16 + 5                    # Watchdog early warning interrupt (IRQ 5)
+    errors = []
+    for name, defines in configs.items():
+        cfg_dir = os.path.join(out_dir, name)
+        image = thumb_sim.build(defines[0][2:], defines[1:], os.path.join(cfg_dir, 'sim'))
+        exe = host_build.build('test_records.c', defines, cfg_dir)
+        fi, size = image.data['FaultInfo']
+        core = 1 if '-DFR_CORE_NUM=2U' in defines else 0
+        slot = fi + core * (size // (core + 1))
+
+        def check(cond, msg):
+            if not cond:
+                errors.append('%s: %s' % (name, msg))
+
+        # Hang: interrupted thread code at pc, R4 of the interrupted code is not the hang mark
+        # Fault: R4 bit 31 set by the application must not mark a hang
+        for entry, exception, r4, is_hang in (('FaultRecordHang', wdt_irq, 0x00000000, True),
+                                              ('FaultRecord', 3, 0x80000000, False)):
+            cpu = thumb_sim.CPU(image)
+            pc, lr = 0x08003000, 0x08002F01
+            ret = sim_fault(cpu, entry, exception, [1, 2, 3, 4, 12, lr, pc, 0x01000000],
+                            core_id=core, exc_return=0xFFFFFFFD, regs={4: r4})
+            check(ret == 'FaultRecordOnExit', '%s: entry stopped at %s' % (entry, ret))
+            check(cpu.rd(slot) == FR_MAGIC_NUMBER, '%s: no record in slot %u' % (entry, core))
+            check(bool(cpu.rd(slot + 8) & (1 << 22)) == is_hang, '%s: type 0x%08X' % (entry, cpu.rd(slot + 8)))
+            rc, log, maps = sim_records(cpu, image, exe, cfg_dir)
+            check(rc == 0, 'test_records failed:\n' + log)
+            check(('Check: 1 exception %u pc 0x%08X hang %u ' % (exception, pc, is_hang)) in log,
+                  '%s: summary:\n%s' % (entry, log))
+            check(('Hang:              code at 0x%08X (LR = 0x%08X) did not service the watchdog' % (pc, lr) in log)
+                  == is_hang, '%s: Hang line:\n%s' % (entry, log))
+            if is_hang:
+                check('Watchdog early warning, exception number = %u' % wdt_irq in log,
+                      'exception not printed as watchdog early warning:\n' + log)
+            check(len(maps) == 1 and maps[0].get('hang') is is_hang and maps[0].get('exception') == exception and
+                  maps[0].get('ReturnAddress') == pc and maps[0].get('core_id', 0) == core, '%s: JSON %s' % (entry, maps))
+    return errors
+
+
+@test
+def ext_context(out_dir):
+    """Floating-point/MVE context recorded by FaultRecord (thumb_sim.py): stacked, partial, lazy, no access."""
+    require_sim(out_dir)
+    fp = ['-D__FPU_USED=1U', '-DFR_EXT_CONTEXT=1']
+    configs = {
+        'm4f':  ['-D__ARM_ARCH_7EM__'] + fp,
+        'm33f': ['-D__ARM_ARCH_8M_MAIN__'] + fp,
+        'm55':  ['-D__ARM_ARCH_8_1M_MAIN__', '-D__MVE_USED=1U'] + fp,
+    }
+    stacked = [0x3F800000 + i for i in range(16)] + [0x03000010, 0x0000FFFF]    # S0..S15, FPSCR, VPR
+    regs = [0x40000000 + i for i in range(32)]                                  # S0..S31
+    fpscr, vpr = 0x0300009F, 0x00FF00FF
+    errors = []
+    for name, defines in configs.items():
+        cfg_dir = os.path.join(out_dir, name)
+        image = thumb_sim.build(defines[0][2:], defines[1:], os.path.join(cfg_dir, 'sim'))
+        exe = host_build.build('test_records.c', defines, cfg_dir)
+        mve = '-D__MVE_USED=1U' in defines
+
+        def check(cond, msg):
+            if not cond:
+                errors.append('%s %s: %s' % (name, case, msg))
+
+        # (case, EXC_RETURN, FPCCR.LSPACT, CPACR CP10/CP11 access, state, S0..S31, FPSCR, VPR)
+        for case, exc_return, lspact, cpacr, state, s_exp, fpscr_exp, vpr_exp in (
+                ('stacked',   0xFFFFFFED, 0, 0x00F00000, 1, stacked[:16] + regs[16:], stacked[16], stacked[17]),
+                ('partial',   0xFFFFFFED, 0, 0x00000000, 3, stacked[:16] + [0] * 16, stacked[16], stacked[17]),
+                ('lazy',      0xFFFFFFED, 1, 0x00F00000, 2, regs, fpscr, vpr),
+                ('no access', 0xFFFFFFED, 1, 0x00000000, 4, [0] * 32, 0, 0),
+                ('basic',     0xFFFFFFFD, 0, 0x00F00000, 0, [0] * 32, 0, 0)):
+            cpu = thumb_sim.CPU(image)
+            cpu.s = list(regs)
+            cpu.sysregs.update(fpscr=fpscr, vpr=vpr)
+            cpu.wr(FPU_FPCCR, 0xC0000000 | lspact)
+            cpu.wr(SCB_CPACR, cpacr)
+            cpu.wr(SCB_CFSR, 0x00000100)                                        # UNDEFINSTR
+            frame = [0, 1, 2, 3, 12, 0x08000F01, 0x08004000, 0x01000000] + (stacked if state != 0 else [])
+            ret = sim_fault(cpu, 'FaultRecord', 6, frame, exc_return=exc_return)
+            check(ret == 'FaultRecordOnExit', 'entry stopped at %s' % ret)
+            check((cpu.rd(FPU_FPCCR) & 1) == (state == 4), 'FPCCR.LSPACT %u' % (cpu.rd(FPU_FPCCR) & 1))
+            rc, log, maps = sim_records(cpu, image, exe, cfg_dir)
+            check(rc == 0 and len(maps) == 1, 'test_records failed:\n' + log)
+            if not maps:
+                continue
+            m = maps[0]
+            if not mve:
+                vpr_exp = 0
+            got = ([m.get('ext_context')] + [m.get('S%u' % i) for i in range(32)] + [m.get('FPSCR')] +
+                   [m.get('VPR', 0)])
+            check(got == [state] + s_exp + [fpscr_exp, vpr_exp],
+                  'JSON %s, expected %s' % ([hex(v) for v in got], [hex(v) for v in [state] + s_exp + [fpscr_exp, vpr_exp]]))
+            text = {1: '  Floating-point context:\n', 3: '   - S16..S31:       not available (FPU access disabled)',
+                    2: '  Floating-point context (read from registers, lazy state preservation pending):',
+                    4: '  Floating-point context: not available (lazy state preservation pending, FPU access disabled)'}
+            if state == 0:
+                check('Floating-point context' not in log, 'context printed:\n' + log)
+            else:
+                check(text[state] in log, 'print:\n' + log)
+            if state in (1, 2):
+                line = ('   - Q4:             0x%08X%08X%08X%08X' % tuple(s_exp[19:15:-1]) if mve else
+                        '   - S16:            0x%08X' % s_exp[16])
+                check(line in log and '   - FPSCR:          0x%08X' % fpscr_exp in log, 'registers:\n' + log)
+    return errors
+
+
+@test
+def armv81m(out_dir):
+    """Armv8.1-M CONTROL (PACBTI enables) and RFSR recorded by the fault entries (thumb_sim.py), decoded."""
+    require_sim(out_dir)
+    configs = {
+        'm55':  ['-D__ARM_ARCH_8_1M_MAIN__'],
+        'm85':  ['-D__ARM_ARCH_8_1M_MAIN__', '-D__FPU_USED=1U', '-D__MVE_USED=1U', '-DFR_EXT_CONTEXT=1'],
+    }
+    bti = '  PACBTI:            Branch target identification failure'
+    pac = '  PACBTI:            Pointer authentication failure likely'
+    ras = '  Fault:             RAS error - restartable error (UET), syndrome 0x0123'
+    rfsr = 0x80000000 | (0x0123 << 16) | 2
+    errors = []
+    for name, defines in configs.items():
+        cfg_dir = os.path.join(out_dir, name)
+        image = thumb_sim.build(defines[0][2:], defines[1:], os.path.join(cfg_dir, 'sim'))
+        exe = host_build.build('test_records.c', defines, cfg_dir)
+
+        def check(cond, msg):
+            if not cond:
+                errors.append('%s %s: %s' % (name, case, msg))
+
+        # (case, entry, exception, CFSR, EXC_RETURN, CONTROL, xPSR, RFSR recorded, decode lines printed)
+        for case, entry, exception, cfsr, exc_return, control, xpsr, rfsr_exp, lines in (
+                ('BTI',             'FaultRecordUsageFault', 6, 0x00020000, 0xFFFFFFF9, 0x10, 0x01200000, 0, [bti]),
+                ('BTI not enabled', 'FaultRecordUsageFault', 6, 0x00020000, 0xFFFFFFF9, 0x40, 0x01200000, 0, [pac]),
+                ('UPAC',            'FaultRecord',           6, 0x00020000, 0xFFFFFFFD, 0x81, 0x01000000, rfsr, [pac, ras]),
+                ('PAC privileged',  'FaultRecord',           6, 0x00020000, 0xFFFFFFFD, 0x41, 0x01000000, rfsr, [ras]),
+                ('PAC handler',     'FaultRecord',           6, 0x00020000, 0xFFFFFFF1, 0x41, 0x01000000, rfsr, [pac, ras]),
+                ('RAS',             'FaultRecordBusFault',   5, 0x00000000, 0xFFFFFFF9, 0x00, 0x01000000, rfsr, [ras]),
+                ('RAS in HardFault', 'FaultRecord',          3, 0x00000000, 0xFFFFFFF9, 0x00, 0x01000000, rfsr, [ras])):
+            cpu = thumb_sim.CPU(image)
+            cpu.sysregs['control'] = control
+            cpu.wr(SCB_CFSR, cfsr)
+            cpu.wr(SCB_RFSR, rfsr)
+            ret = sim_fault(cpu, entry, exception, [0, 1, 2, 3, 12, 0x08000F01, 0x08005000, xpsr],
+                            exc_return=exc_return)
+            check(ret == 'FaultRecordOnExit', 'entry stopped at %s' % ret)
+            rc, log, maps = sim_records(cpu, image, exe, cfg_dir)
+            check(rc == 0 and len(maps) == 1, 'test_records failed:\n' + log)
+            if not maps:
+                continue
+            check((maps[0].get('CONTROL'), maps[0].get('RFSR')) == (control, rfsr_exp),
+                  'JSON CONTROL %s RFSR %s' % (maps[0].get('CONTROL'), maps[0].get('RFSR')))
+            for text in (bti, pac, ras):
+                check((text in log) == (text in lines), '"%s" %sprinted:\n%s' % (text.strip(), 'not ' if text in lines else '', log))
+    return errors
+
+
+@test
+def entry_stubs(out_dir):
+    """Instructions from the fault entry points to the shared recording code (thumb_sim.py) as in README.md."""
+    require_sim(out_dir)
+    # Table row: (architecture, defines, EXC_RETURN of Thread mode using PSP)
+    configs = {
+        'Cortex-M4':                ('__ARM_ARCH_7EM__',       [],                         0xFFFFFFFD),
+        'Cortex-M33 Non-secure':    ('__ARM_ARCH_8M_MAIN__',   [],                         0xFFFFFFBC),
+        'Cortex-M33 Secure':        ('__ARM_ARCH_8M_MAIN__',   ['-D__ARM_FEATURE_CMSE=3'], 0xFFFFFFFD),
+        'Cortex-M55 Secure':        ('__ARM_ARCH_8_1M_MAIN__', ['-D__ARM_FEATURE_CMSE=3'], 0xFFFFFFFD),
+    }
+    entries = (('FaultRecord', 3), ('FaultRecordMemManage', 4), ('FaultRecordBusFault', 5),
+               ('FaultRecordUsageFault', 6), ('FaultRecordSecureFault', 7))
+    table = {}
+    with open(os.path.join(host_build.ROOT, 'README.md')) as f:
+        for line in f:
+            cols = [c.strip() for c in line.strip().strip('|').split('|')]
+            if len(cols) == len(entries) + 1 and cols[0] in configs:
+                table[cols[0]] = cols[1:]
+    errors = []
+    for name, (arch, defines, exc_return) in configs.items():
+        image = thumb_sim.build(arch, defines, os.path.join(out_dir, name.replace(' ', '_')))
+        row = []
+        for entry, exception in entries:
+            if entry not in image.labels:
+                row.append('-')
+                continue
+            cpu = thumb_sim.CPU(image)
+            cpu.exception(exception, [0, 1, 2, 3, 12, 0x08000F01, 0x08001000, 0x01000000],
+                          msp=0x20070000, psp=0x20060000, exc_return=exc_return)
+            ret = cpu.run(entry, stop='fault_record_tail')
+            row.append(str(cpu.steps) if ret == 'fault_record_tail' else ret)
+        if table.get(name) != row:
+            errors.append('%s: README %s, measured %s' % (name, table.get(name), row))
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Fault Recorder host tests.')
+    parser.add_argument('-k', dest='name', help='run only tests containing name')
+    parser.add_argument('--build-dir', help='directory for test programs (default: temporary directory)')
+    args = parser.parse_args()
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for func in TESTS:
+            if args.name and args.name not in func.__name__:
+                continue
+            try:
+                errors = func(os.path.join(args.build_dir or tmp, func.__name__))
+            except Skip as e:
+                print('SKIP %s (%s)' % (func.__name__, e))
+                continue
+            print('%s %s' % ('FAIL' if errors else 'PASS', func.__name__))
+            for err in errors:
+                print('  ' + err.rstrip().replace('\n', '\n  '))
+            failed += bool(errors)
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
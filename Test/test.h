@@ -0,0 +1,47 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    test.h
+ * Purpose: Host build of FaultRecorder.c and check helpers for the tests
+ *----------------------------------------------------------------------------*/
+
+/* Include in the test C file instead of FaultRecorder_host.c. CHECK reports a failed
+   condition with its line and continues, the test returns TestResult() from main. */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FaultRecorder_host.c"
+
+static uint32_t TestFailed;
+
+#define CHECK(cond)             do { if (!(cond)) { TestFail(__FILE__, __LINE__, #cond); } } while (0)
+#define CHECK_EQ(val, exp)      do { uint32_t v_ = (uint32_t)(val), e_ = (uint32_t)(exp);            \
+                                     if (v_ != e_) { TestFailEq(__FILE__, __LINE__, #val, v_, e_); } \
+                                } while (0)
+#define CHECK_STR(str, sub)     CHECK(strstr((str), (sub)) != NULL)
+
+static void TestFail (const char *file, int line, const char *cond) {
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+  TestFailed++;
+}
+
+static void TestFailEq (const char *file, int line, const char *val, uint32_t v, uint32_t e) {
+  fprintf(stderr, "%s:%d: check failed: %s = 0x%08X, expected 0x%08X\n", file, line, val, v, e);
+  TestFailed++;
+}
+
+static int TestResult (void) {
+  return (TestFailed != 0U) ? 1 : 0;
+}
+
+/* Complete the fault record in slot of FaultInfo as FaultRecord does (CRC-32 and magic number) */
+static void TestRecordComplete (FaultInfo_Type *ptr_fi) {
+  ptr_fi->crc32 = CalcCRC32(FR_CRC32_INIT_VAL, FR_CRC32_DATA_PTR(ptr_fi), FR_CRC32_DATA_LEN, FR_CRC32_POLYNOM);
+  ptr_fi->magic_number = FR_MAGIC_NUMBER;
+}
+
+#endif /* TEST_H */
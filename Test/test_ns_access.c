@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    test_ns_access.c
+ * Purpose: Non-secure callable functions (FR_NS_ACCESS) and NsBufferCheck
+ *----------------------------------------------------------------------------*/
+
+/* Built as Secure image (__ARM_FEATURE_CMSE = 3, FR_NS_ACCESS = 1). Buffers are
+   denied with HostNsDenied, the caller state is set with HostIPSR and HostCONTROL_NS. */
+
+#include "test.h"
+
+static uint8_t  CborBuf[1024], CborRef[1024];
+static char     JsonBuf[2048], JsonRef[2048];
+
+static void RecordSet (uint32_t exception, uint32_t pc) {
+  FaultInfo_Type *ptr_fi = &FaultInfo[0];
+  uint32_t        type   = FR_FAULT_INFO_TYPE;
+
+  memset(ptr_fi, 0, sizeof(FaultInfo_Type));
+  memcpy(&ptr_fi->type, &type, sizeof(type));
+  ptr_fi->common_registers.xPSR        = 0x01000000U | exception;
+  ptr_fi->state_context.ReturnAddress  = pc;
+#if (FR_FAULT_REGS_EXIST != 0)
+  ptr_fi->fault_registers.SCB_CFSR     = 0x00008200U;
+  ptr_fi->fault_registers.SCB_BFAR     = 0x2007F000U;
+#endif
+  TestRecordComplete(ptr_fi);
+}
+
+static void Deny (const void *ptr, uint32_t len) {
+  HostNsDenied[0] = (uintptr_t)ptr;
+  HostNsDenied[1] = (uintptr_t)ptr + len;
+}
+
+int main (void) {
+  FaultRecordSummary_t summary;
+  int32_t              len;
+
+  memset(FaultInfo,   0, sizeof(FaultInfo));
+  memset(FaultNested, 0, sizeof(FaultNested));
+  memset(&BootInfo,   0, sizeof(BootInfo));
+
+  // No record
+  memset(&summary, 0xA5, sizeof(summary));
+  CHECK_EQ(FaultRecordSummary_S(&summary), 0);
+  CHECK_EQ(summary.exception, 0U);
+  CHECK_EQ(summary.pc,        0U);
+  CHECK_EQ(FaultRecordEncodeJSON_S(JsonBuf, sizeof(JsonBuf)), -1);
+
+  // Record: summary and outputs same as FaultRecordEncodeJSON/CBOR
+  RecordSet(5U, 0x10001234U);
+  CHECK_EQ(FaultRecordCheck(NULL), FAULT_RECORD_CHECK_FAULT);
+  CHECK_EQ(FaultRecordSummary_S(&summary), 1);
+  CHECK_EQ(summary.exception,   5U);
+  CHECK_EQ(summary.pc,          0x10001234U);
+  CHECK_EQ(summary.hang,        0U);
+  CHECK_EQ(summary.interrupted, 0U);
+  CHECK_EQ(summary.boot_count,  1U);
+  CHECK_EQ(summary.fault_count, 1U);
+  CHECK_EQ(FaultRecordCheck(NULL), FAULT_RECORD_CHECK_NONE);   // Next boot: not marked as checked by FaultRecordSummary_S
+
+  len = FaultRecordEncodeJSON(JsonRef, sizeof(JsonRef));
+  CHECK(len > 0);
+  CHECK_EQ(FaultRecordEncodeJSON_S(NULL, 0U), len);
+  CHECK_EQ(FaultRecordEncodeJSON_S(JsonBuf, sizeof(JsonBuf)), len);
+  CHECK(strcmp(JsonBuf, JsonRef) == 0);
+  CHECK_STR(JsonBuf, "\"secure\":true");
+#if (FR_FAULT_REGS_EXIST != 0)
+  CHECK_STR(JsonBuf, "\"faults\":[\"CFSR.PRECISERR\",\"CFSR.BFARVALID\"]");
+#endif
+
+  len = FaultRecordEncodeCBOR(CborRef, sizeof(CborRef));
+  CHECK(len > 0);
+  CHECK_EQ(FaultRecordEncodeCBOR_S(NULL, 0U), len);
+  CHECK_EQ(FaultRecordEncodeCBOR_S(CborBuf, sizeof(CborBuf)), len);
+  CHECK(memcmp(CborBuf, CborRef, (size_t)len) == 0);
+
+  // Buffer checked for Non-secure read/write access with the privilege level of the caller
+  HostIPSR = 0U; HostCONTROL_NS = 0U;                           // Privileged thread
+  FaultRecordSummary_S(&summary);
+  CHECK_EQ(HostCmseFlags, CMSE_NONSECURE | CMSE_MPU_READWRITE);
+  HostIPSR = 0U; HostCONTROL_NS = CONTROL_nPRIV_Msk;            // Unprivileged thread
+  FaultRecordEncodeJSON_S(JsonBuf, sizeof(JsonBuf));
+  CHECK_EQ(HostCmseFlags, CMSE_NONSECURE | CMSE_MPU_READWRITE | CMSE_MPU_UNPRIV);
+  FaultRecordEncodeCBOR_S(CborBuf, sizeof(CborBuf));
+  CHECK_EQ(HostCmseFlags, CMSE_NONSECURE | CMSE_MPU_READWRITE | CMSE_MPU_UNPRIV);
+  HostIPSR = 16U;                                               // Handler (always privileged)
+  FaultRecordSummary_S(&summary);
+  CHECK_EQ(HostCmseFlags, CMSE_NONSECURE | CMSE_MPU_READWRITE);
+  HostIPSR = 0U; HostCONTROL_NS = 0U;
+
+  // Buffer not accessible (also partly): -1, buffer not written
+  memset(JsonBuf, 0xEE, sizeof(JsonBuf));
+  memset(CborBuf, 0xEE, sizeof(CborBuf));
+  memset(&summary, 0xEE, sizeof(summary));
+  Deny(&summary, sizeof(summary));
+  CHECK_EQ(FaultRecordSummary_S(&summary), -1);
+  CHECK_EQ(summary.exception, 0xEEEEEEEEU);
+  Deny(&JsonBuf[sizeof(JsonBuf) - 1U], 1U);
+  CHECK_EQ(FaultRecordEncodeJSON_S(JsonBuf, sizeof(JsonBuf)), -1);
+  CHECK_EQ((uint8_t)JsonBuf[0], 0xEEU);
+  Deny(&CborBuf[0], 1U);
+  CHECK_EQ(FaultRecordEncodeCBOR_S(CborBuf, sizeof(CborBuf)), -1);
+  CHECK_EQ(CborBuf[0], 0xEEU);
+  CHECK_EQ(FaultRecordEncodeCBOR_S(CborBuf, 0U), len);          // Size 0: nothing written, not checked
+  CHECK_EQ(FaultRecordSummary_S(NULL), -1);
+  Deny(NULL, 0U);
+
+  // Corrupted record is not counted, cleared record is gone
+  FaultInfo[0].state_context.ReturnAddress ^= 1U;
+  CHECK_EQ(FaultRecordSummary_S(&summary), 0);
+  RecordSet(6U, 0x10002000U);
+  CHECK_EQ(FaultRecordSummary_S(&summary), 1);
+  CHECK_EQ(summary.pc, 0x10002000U);
+  FaultRecordClear_S();
+  CHECK_EQ(FaultRecordSummary_S(&summary), 0);
+  CHECK_EQ(FaultRecordEncodeJSON_S(JsonBuf, sizeof(JsonBuf)), -1);
+  CHECK_EQ(summary.boot_count,  2U);                            // Boot counters kept
+  CHECK_EQ(summary.fault_count, 0U);
+
+  return TestResult();
+}
@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    test_records.c
+ * Purpose: Report the records written by the fault entries in thumb_sim.py
+ *----------------------------------------------------------------------------*/
+
+/* Usage: test_records <FaultInfo image> [<FaultNested image>]
+   Loads FaultInfo (and FaultNested) as written by a thumb_sim.py run of the fault
+   entries (no-init RAM after reset) and prints:
+     Check: <FaultRecordCheck result> <summary fields>
+     the FaultRecordPrint report
+     JSON: <FaultRecordEncodeJSON output>
+     the FaultRecordHistoryPrint report after two FaultRecordHistoryAdd calls
+   The images must have the size of the host build regions (same layout). */
+
+#include "test.h"
+
+static char Json[8192];
+
+static int Load (const char *name, void *data, uint32_t size) {
+  FILE *f = fopen(name, "rb");
+  long  len;
+
+  if (f == NULL) {
+    fprintf(stderr, "%s: cannot open\n", name);
+    return -1;
+  }
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if ((len != (long)size) || (fread(data, 1U, size, f) != size)) {
+    fprintf(stderr, "%s: %ld bytes, expected %u\n", name, len, size);
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+  return 0;
+}
+
+int main (int argc, char **argv) {
+  FaultRecordSummary_t summary;
+  int32_t              ret;
+
+  if ((argc < 2) || (Load(argv[1], FaultInfo, sizeof(FaultInfo)) != 0) ||
+      ((argc > 2) && (Load(argv[2], FaultNested, sizeof(FaultNested)) != 0))) {
+    return 2;
+  }
+
+  ret = FaultRecordCheck(&summary);
+  printf("Check: %d exception %u pc 0x%08X hang %u interrupted %u\n", ret,
+         summary.exception, summary.pc, summary.hang, summary.interrupted);
+  FaultRecordPrint();
+  ret = FaultRecordEncodeJSON(Json, sizeof(Json));
+  printf("JSON: %s\n", (ret > 0) ? Json : "-1");
+  FaultRecordHistoryAdd();
+  FaultRecordHistoryAdd();
+  FaultRecordHistoryPrint();
+
+  return 0;
+}
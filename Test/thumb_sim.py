@@ -0,0 +1,374 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# Fault Recorder - Thumb simulator for the fault entries
+#
+# Runs the naked assembler functions of FaultRecorder.c (FaultRecord, the
+# per-exception entries, FaultRecordHang, CalcCRC32, ...) for the host tests.
+# FaultRecorder.c is compiled with gcc -m32 -S (32-bit layout, so the "i"
+# operands get the offsets and sizes of the device build), the inline
+# assembler is extracted from the output and assembled with llvm-mc for the
+# selected architecture. The C functions are not translated: each gets a
+# BKPT, so a call into C code stops the simulation.
+#
+# Data symbols (FaultInfo, FaultNested, ...) are placed from RAM_BASE, the
+# code from address 0. CPU interprets the Thumb instructions used by the
+# entries; memory not written reads as 0, core registers read with MRS (and
+# FPSCR, VPR read with VMRS) come from CPU.sysregs, floating-point registers
+# S0..S31 from CPU.s. Floating-point arithmetic is not interpreted.
+#
+# Requirements: gcc with 32-bit x86 code generation (-m32, no libraries
+# needed), llvm-mc, llvm-objcopy, llvm-objdump, llvm-nm, llvm-readelf.
+#
+# Usage (as module):
+#   import thumb_sim
+#   image = thumb_sim.build('__ARM_ARCH_7EM__', ['-DFR_CORE_NUM=2U', ...], out_dir)
+#   cpu = thumb_sim.CPU(image)
+#   cpu.exception(5, [r0, r1, r2, r3, r12, lr, pc, xpsr], msp=0x20010000)
+#   cpu.run('FaultRecordBusFault')      # returns name of the C function called
+#   cpu.steps                           # number of instructions executed
+# -----------------------------------------------------------------------------
+
+import os
+import re
+import struct
+import subprocess
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(TEST_DIR)
+SOURCE_DIR = os.path.join(ROOT, 'Source')
+
+RAM_BASE = 0x20000000
+TRIPLE = {'__ARM_ARCH_6M__': 'thumbv6m', '__ARM_ARCH_7M__': 'thumbv7m', '__ARM_ARCH_7EM__': 'thumbv7em',
+          '__ARM_ARCH_8M_BASE__': 'thumbv8m.base', '__ARM_ARCH_8M_MAIN__': 'thumbv8m.main',
+          '__ARM_ARCH_8_1M_MAIN__': 'thumbv8.1m.main'}
+MATTR = {'__ARM_ARCH_7EM__': '+vfp4d16sp', '__ARM_ARCH_8M_MAIN__': '+fp-armv8d16sp',
+         '__ARM_ARCH_8_1M_MAIN__': '+fp-armv8d16sp,+mve.fp'}
+
+
+def asm_for_gcc(text):
+    """Make the inline assembler of the Arm source acceptable for the x86 compile:
+    clobbers of Arm registers become "cc", braces of register lists are escaped."""
+    text = re.sub(r'"(r[0-9]+|lr|sp)"(\s*[,)])', r'"cc"\2', text)
+    return '\n'.join(re.sub(r'([{}])', r'%\1', line) if '\\n"' in line else line for line in text.split('\n'))
+
+
+class Image:
+    """Assembled entries: code, instructions by address, labels and data symbols (address, size)."""
+
+    def __init__(self, code, insns, labels, data):
+        self.code, self.insns, self.labels, self.data = code, insns, labels, data
+        self.names = {addr: name for name, addr in labels.items()}
+
+    def addr(self, name, ofs=0):
+        return self.data[name][0] + ofs
+
+
+def build(arch, defines, out_dir):
+    """Compile FaultRecorder.c for arch with defines, return Image of its assembler functions."""
+    os.makedirs(out_dir, exist_ok=True)
+    for name in ('FaultRecorder.c', 'FaultRecorderEntry.inc'):
+        with open(os.path.join(SOURCE_DIR, name)) as f:
+            text = asm_for_gcc(f.read())
+        with open(os.path.join(out_dir, name), 'w') as f:
+            f.write(text)
+    gcc_inc = subprocess.check_output(['gcc', '-print-file-name=include'], universal_newlines=True).strip()
+    x86 = os.path.join(out_dir, 'x86.s')
+    subprocess.check_call(['gcc', '-m32', '-ffreestanding', '-nostdinc', '-isystem', gcc_inc,
+                           '-isystem', os.path.join(TEST_DIR, 'Sim'), '-std=gnu99', '-w', '-O1', '-fno-pie',
+                           '-fno-pic', '-I' + os.path.join(ROOT, 'Include'), '-I' + os.path.join(TEST_DIR, 'Host'),
+                           '-D' + arch] + list(defines) +
+                          ['-S', os.path.join(out_dir, 'FaultRecorder.c'), '-o', x86])
+
+    # Extract assembler blocks and labels, collect data objects
+    lines, data, funcs = [], [], []
+    app = False
+    with open(x86) as f:
+        for line in f:
+            if '#APP' in line:
+                app = True
+            elif '#NO_APP' in line:
+                app = False
+            elif app:
+                if not re.match(r'^\s*#', line):
+                    lines.append(re.sub(r'\$(-?[0-9])', r'#\1', line))
+            else:
+                m = re.match(r'^\s*\.comm\s+(\w+),\s*(\d+)', line) or re.match(r'^\s*\.size\s+(\w+),\s*(\d+)\s*$', line)
+                if m:
+                    data.append((m.group(1), int(m.group(2))))
+                m = re.match(r'^([A-Za-z_]\w*):\s*$', line)
+                if m:
+                    funcs.append(len(lines))
+                    lines.append(line)
+    # C functions (label not followed by assembler) stop the simulation
+    for i in reversed(funcs):
+        if i + 1 >= len(lines) or re.match(r'^[A-Za-z_]\w*:\s*$', lines[i + 1]):
+            lines.insert(i + 1, '\tbkpt #0\n')
+    addr, syms = RAM_BASE, {}
+    for name, size in data:
+        syms[name] = (addr, size)
+        addr = (addr + size + 31) & ~31
+    arm = os.path.join(out_dir, 'arm.s')
+    with open(arm, 'w') as f:
+        f.write('.syntax unified\n.thumb\n')
+        f.writelines('.set %s, 0x%08X\n' % (name, a) for name, (a, _) in syms.items())
+        f.writelines(lines)
+
+    triple = '--triple=%s-none-eabi' % TRIPLE[arch]
+    mattr = ['-mattr=' + MATTR[arch]] if arch in MATTR else []
+    obj, binary = os.path.join(out_dir, 'arm.o'), os.path.join(out_dir, 'arm.bin')
+    subprocess.check_call(['llvm-mc', triple] + mattr + ['-filetype=obj', arm, '-o', obj])
+    subprocess.check_call(['llvm-objcopy', '-O', 'binary', '--only-section=.text', obj, binary])
+    with open(binary, 'rb') as f:
+        code = bytearray(f.read())
+    for line in subprocess.check_output(['llvm-readelf', '-r', obj], universal_newlines=True).split('\n'):
+        p = line.split()
+        if len(p) >= 4 and p[2] == 'R_ARM_ABS32':
+            ofs = int(p[0], 16)
+            val = int(p[3], 16) + struct.unpack_from('<I', code, ofs)[0]
+            struct.pack_into('<I', code, ofs, val & 0xFFFFFFFF)
+    labels, insns = {}, {}
+    dis = subprocess.check_output(['llvm-objdump', '-d', triple] + ['-' + a for a in mattr] + [obj],
+                                  universal_newlines=True)
+    for line in dis.split('\n'):
+        m = re.match(r'^\s+([0-9a-f]+):\s+((?:[0-9a-f]{2} )+)\s*\t(\S+)\s*(.*)$', line)
+        if m:
+            insns[int(m.group(1), 16)] = (len(m.group(2).split()), m.group(3), m.group(4).split('@')[0].strip())
+    for line in subprocess.check_output(['llvm-nm', obj], universal_newlines=True).split('\n'):
+        p = line.split()
+        if len(p) == 3 and p[1] in 'tT':
+            labels[p[2]] = int(p[0], 16)
+    return Image(bytes(code), insns, labels, syms)
+
+
+class CPU:
+    """Interpreter of the Thumb instructions used by the assembler functions."""
+
+    def __init__(self, image):
+        self.image = image
+        self.mem = {}
+        self.load(0, image.code)
+        self.r = [0] * 16
+        self.s = [0] * 32
+        self.N = self.Z = self.C = self.V = 0
+        self.sysregs = {}
+        self.steps = 0
+
+    # Memory (little-endian, unwritten memory reads as 0)
+    def rd(self, a, n=4):
+        return int.from_bytes(bytes(self.mem.get((a + i) & 0xFFFFFFFF, 0) for i in range(n)), 'little')
+
+    def wr(self, a, v, n=4):
+        for i in range(n):
+            self.mem[(a + i) & 0xFFFFFFFF] = (v >> (8 * i)) & 0xFF
+
+    def load(self, a, data):
+        for i, b in enumerate(data):
+            self.mem[a + i] = b
+
+    def dump(self, a, n):
+        return bytes(self.mem.get(a + i, 0) for i in range(n))
+
+    def exception(self, number, frame, msp, psp=0, exc_return=0xFFFFFFF9):
+        """Enter exception: push the stack frame (R0-R3, R12, LR, ReturnAddress, xPSR, followed
+        by S0..S15, FPSCR, VPR for an extended frame) to the stack selected by exc_return (MSP
+        or PSP), set IPSR, SP and LR."""
+        sp = psp if (exc_return & 4) != 0 else msp
+        for i, val in enumerate(frame):
+            self.wr(sp + 4 * i, val)
+        self.sysregs.update(msp=msp, psp=psp, xpsr=number, ipsr=number)
+        self.r[13] = msp
+        self.r[14] = exc_return
+
+    # Operands
+    @staticmethod
+    def reg(s):
+        s = s.strip()
+        return {'sp': 13, 'lr': 14, 'pc': 15}[s] if not s.startswith('r') else int(s[1:])
+
+    @staticmethod
+    def imm(s):
+        return int(s.strip().lstrip('#'), 0) & 0xFFFFFFFF
+
+    def val(self, s):
+        s = s.strip()
+        return self.imm(s) if s.startswith('#') else self.r[self.reg(s)]
+
+    def setnz(self, v):
+        v &= 0xFFFFFFFF
+        self.N, self.Z = v >> 31, int(v == 0)
+        return v
+
+    def addflags(self, a, b, carry=0):
+        res = a + b + carry
+        r = res & 0xFFFFFFFF
+        self.C = int(res > 0xFFFFFFFF)
+        self.V = int((a >> 31) == (b >> 31) and (r >> 31) != (a >> 31))
+        return self.setnz(r)
+
+    def cond(self, c):
+        return {'eq': self.Z, 'ne': not self.Z, 'hs': self.C, 'cs': self.C, 'lo': not self.C, 'cc': not self.C,
+                'mi': self.N, 'pl': not self.N, 'hi': self.C and not self.Z, 'ls': (not self.C) or self.Z,
+                'ge': self.N == self.V, 'lt': self.N != self.V, 'gt': (not self.Z) and self.N == self.V,
+                'le': self.Z or self.N != self.V, 'vs': self.V, 'vc': not self.V}[c]
+
+    def addr(self, ops, pc):
+        m = re.match(r'\[(\w+)(?:,\s*(#?-?\w+))?\]', ops)
+        base = self.reg(m.group(1))
+        val = ((pc + 4) & ~3) if base == 15 else self.r[base]
+        if m.group(2):
+            val += self.imm(m.group(2)) if m.group(2).startswith('#') else self.r[self.reg(m.group(2))]
+        return val & 0xFFFFFFFF
+
+    def reglist(self, s):
+        out = []
+        reg = self.reg if not s.strip('{ ').startswith('s') else (lambda p: int(p.strip()[1:]))
+        for p in s.strip('{} ').split(','):
+            if '-' in p:
+                a, b = p.split('-')
+                out += list(range(reg(a), reg(b) + 1))
+            else:
+                out.append(reg(p))
+        return out
+
+    def run(self, start, max_steps=200000, stop=None):
+        """Execute from label or address until a C function (BKPT) is called, the exception
+        returns or label stop is reached, return the function name, 'exception return' or stop."""
+        pc = self.image.labels[start] if isinstance(start, str) else start
+        stop_pc = self.image.labels[stop] if stop else None
+        for _ in range(max_steps):
+            if pc == stop_pc:
+                self.r[15] = pc
+                return stop
+            ln, m, ops = self.image.insns[pc]
+            self.steps += 1
+            npc = pc + ln
+            args = [a.strip() for a in re.split(r',(?![^\[{]*[\]}])', ops)] if ops else []
+            if m == 'bkpt':
+                self.r[15] = pc
+                return self.image.names.get(pc, hex(pc))
+            elif m in ('mov', 'movs', 'mov.w', 'movw'):
+                v = self.val(args[1])
+                self.r[self.reg(args[0])] = v
+                if m == 'movs':
+                    self.setnz(v)
+            elif m in ('adds', 'add', 'subs', 'sub', 'add.w', 'sub.w', 'adcs', 'sbcs'):
+                if len(args) == 2:
+                    args = [args[0]] + args
+                a, b = self.val(args[1]), self.val(args[2])
+                if args[1] == 'pc':
+                    a = (pc + 4) & ~3
+                if m.startswith('sub') or m == 'sbcs':
+                    carry = 1 if m != 'sbcs' else self.C
+                    res = self.addflags(a, (~b) & 0xFFFFFFFF, carry) if m in ('subs', 'sbcs') else (a - b) & 0xFFFFFFFF
+                else:
+                    carry = self.C if m == 'adcs' else 0
+                    res = self.addflags(a, b, carry) if m in ('adds', 'adcs') else (a + b) & 0xFFFFFFFF
+                self.r[self.reg(args[0])] = res
+            elif m == 'tst':
+                self.setnz(self.val(args[0]) & self.val(args[1]))
+            elif m in ('cmp', 'cmn'):
+                a, b = self.val(args[0]), self.val(args[1])
+                if m == 'cmp':
+                    self.addflags(a, (~b) & 0xFFFFFFFF, 1)
+                else:
+                    self.addflags(a, b)
+            elif m in ('lsrs', 'lsls', 'asrs', 'lsr', 'lsl', 'lsr.w', 'lsl.w'):
+                if len(args) == 2:
+                    args = [args[0]] + args
+                a, sh = self.val(args[1]), self.val(args[2]) & 0xFF
+                if m.startswith('lsr'):
+                    res = a >> sh if sh < 32 else 0
+                    if sh and m == 'lsrs':
+                        self.C = (a >> (sh - 1)) & 1 if sh <= 32 else 0
+                elif m.startswith('lsl'):
+                    res = (a << sh) & 0xFFFFFFFF if sh < 32 else 0
+                    if sh and m == 'lsls':
+                        self.C = (a >> (32 - sh)) & 1 if sh <= 32 else 0
+                else:
+                    sa = a - (1 << 32) if a >> 31 else a
+                    res = (sa >> min(sh, 31)) & 0xFFFFFFFF
+                    if sh:
+                        self.C = (sa >> min(sh - 1, 31)) & 1
+                self.r[self.reg(args[0])] = res
+                if m.endswith('s'):
+                    self.setnz(res)
+            elif m == 'mvns':
+                self.r[self.reg(args[0])] = self.setnz(~self.val(args[1]))
+            elif m in ('ands', 'orrs', 'eors', 'bics', 'muls', 'and', 'orr'):
+                if len(args) == 2:
+                    args = [args[0]] + args
+                a, b = self.val(args[1]), self.val(args[2])
+                res = {'ands': a & b, 'and': a & b, 'orrs': a | b, 'orr': a | b, 'eors': a ^ b,
+                       'bics': a & ~b, 'muls': a * b}[m] & 0xFFFFFFFF
+                self.r[self.reg(args[0])] = res
+                if m.endswith('s'):
+                    self.setnz(res)
+            elif m in ('ldr', 'ldrh', 'ldrb', 'ldr.w'):
+                n = {'ldrh': 2, 'ldrb': 1}.get(m, 4)
+                self.r[self.reg(args[0])] = self.rd(self.addr(args[1], pc), n)
+            elif m in ('str', 'strh', 'strb', 'str.w'):
+                n = {'strh': 2, 'strb': 1}.get(m, 4)
+                self.wr(self.addr(args[1], pc), self.r[self.reg(args[0])], n)
+            elif m in ('ldm', 'ldmia', 'stm', 'stmia'):
+                rn = self.reg(args[0].rstrip('!'))
+                a = self.r[rn]
+                for rr in self.reglist(args[1]):
+                    if m.startswith('ld'):
+                        self.r[rr] = self.rd(a)
+                    else:
+                        self.wr(a, self.r[rr])
+                    a += 4
+                if args[0].endswith('!'):
+                    self.r[rn] = a & 0xFFFFFFFF
+            elif m in ('vstm', 'vstmia'):
+                rn = self.reg(args[0].rstrip('!'))
+                a = self.r[rn]
+                for sr in self.reglist(args[1]):
+                    self.wr(a, self.s[sr])
+                    a += 4
+                if args[0].endswith('!'):
+                    self.r[rn] = a & 0xFFFFFFFF
+            elif m == 'vmrs':
+                self.r[self.reg(args[0])] = self.sysregs.get({'p0': 'vpr'}.get(args[1], args[1]), 0)
+            elif m == 'push':
+                rl = self.reglist(args[0])
+                self.r[13] -= 4 * len(rl)
+                for i, rr in enumerate(rl):
+                    self.wr(self.r[13] + 4 * i, self.r[rr])
+            elif m == 'pop':
+                rl = self.reglist(args[0])
+                for i, rr in enumerate(rl):
+                    v = self.rd(self.r[13] + 4 * i)
+                    if rr == 15:
+                        npc = v & ~1
+                    else:
+                        self.r[rr] = v
+                self.r[13] += 4 * len(rl)
+            elif m == 'mrs':
+                self.r[self.reg(args[0])] = self.sysregs.get(args[1], 0)
+            elif m == 'msr':
+                self.sysregs[args[0]] = self.val(args[1])
+                if args[0] == 'msp':
+                    self.r[13] = self.val(args[1])
+            elif m in ('b', 'b.w'):
+                npc = int(args[0].split()[0], 0)
+            elif m == 'bl':
+                self.r[14] = npc | 1
+                npc = int(args[0].split()[0], 0)
+            elif m in ('bx', 'blx'):
+                t = self.val(args[0])
+                if m == 'blx':
+                    self.r[14] = npc | 1
+                npc = t & ~1
+            elif re.match(r'^b(eq|ne|hs|cs|lo|cc|mi|pl|hi|ls|ge|lt|gt|le|vs|vc)(\.w)?$', m):
+                if self.cond(m[1:3]):
+                    npc = int(args[0].split()[0], 0)
+            elif m in ('nop', 'dsb', 'isb', 'dmb', 'cpsid', 'cpsie'):
+                pass
+            else:
+                raise RuntimeError('unsupported instruction %s %s at 0x%X' % (m, ops, pc))
+            self.r[15] = npc
+            pc = npc
+            if pc >= 0xF0000000:
+                return 'exception return'
+        raise RuntimeError('step limit reached')
@@ -0,0 +1,152 @@
+/*------------------------------------------------------------------------------
+ * Fault Recorder host tests
+ *------------------------------------------------------------------------------
+ * Name:    transport_sender.c
+ * Purpose: FaultRecordTransportNext/Ack sender for fr_transport.py loopback
+ *----------------------------------------------------------------------------*/
+
+/* Usage: transport_sender <state file> <expected data file> <mtu>
+   Fills the fault record regions (and one attachment if FR_TRANSPORT_ATTACH_NUM != 0)
+   with fixed pseudo-random data, writes the data the receiver must reassemble (manifest
+   and regions) to the expected data file and transfers it with
+   FaultRecordTransportStart/Next/Ack.
+   Frames on stdin/stdout have a 16-bit little-endian length:
+     - 'R'           -> reply: remaining chunks, number of chunks (int32 each)
+     - 'N'           -> reply: remaining chunks (int32) and the next chunk packet
+     - 16 bytes      -> acknowledgement packet passed to FaultRecordTransportAck
+   TransportState (no-init RAM on the device) is kept in the state file, so a new
+   process resumes the transfer like the device after a reset. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FaultRecorder_host.c"
+
+static uint8_t  Attachment[300];
+static uint8_t  Packet[4U + FR_TRANSPORT_OVERHEAD + 255U];
+static int32_t  Remaining;
+static uint32_t Random = 0x12345678U;
+
+static void Fill (void *data, uint32_t len) {
+  uint8_t *ptr = (uint8_t *)data;
+
+  while (len-- != 0U) {
+    Random = (Random * 1103515245U) + 12345U;
+    *ptr++ = (uint8_t)(Random >> 16);
+  }
+}
+
+static int ReadFrame (uint8_t *buf, uint32_t size) {
+  uint16_t len;
+
+  if ((fread(&len, 2U, 1U, stdin) != 1U) || (len > size) || (fread(buf, 1U, len, stdin) != len)) {
+    return -1;
+  }
+  return len;
+}
+
+static void WriteFrame (const void *data, uint32_t len) {
+  uint16_t len16 = (uint16_t)len;
+
+  fwrite(&len16, 2U, 1U, stdout);
+  fwrite(data, 1U, len, stdout);
+  fflush(stdout);
+}
+
+static void SaveState (const char *name) {
+  FILE *f = fopen(name, "wb");
+
+  if (f != NULL) {
+    fwrite(&TransportState, sizeof(TransportState), 1U, f);
+    fclose(f);
+  }
+}
+
+static void WriteExpected (const char *name) {
+  static const struct { uint32_t id; const void *ptr; uint32_t len; } region[] = {
+    { 1U, FaultInfo,     sizeof(FaultInfo)     },
+    { 2U, FaultNested,   sizeof(FaultNested)   },
+#if (FR_HISTORY_SIZE != 0U)
+    { 3U, &FaultHistory, sizeof(FaultHistory)  },
+#endif
+#if (FR_STACK_MONITOR_EXIST != 0)
+    { 4U, StackNearMiss, sizeof(StackNearMiss) },
+#endif
+#if (FR_TRANSPORT_ATTACH_NUM != 0U)
+    { 0x10U, Attachment, sizeof(Attachment)    },
+#endif
+  };
+  uint32_t num = sizeof(region) / sizeof(region[0]);
+  uint32_t magic = FR_TRANSPORT_MAGIC, i;
+  FILE    *f = fopen(name, "wb");
+
+  fwrite(&magic, 4U, 1U, f);
+  fwrite(&num,   4U, 1U, f);
+  for (i = 0U; i < num; i++) {
+    fwrite(&region[i].id,  4U, 1U, f);
+    fwrite(&region[i].len, 4U, 1U, f);
+  }
+  for (i = 0U; i < num; i++) {
+    fwrite(region[i].ptr, 1U, region[i].len, f);
+  }
+  fclose(f);
+}
+
+int main (int argc, char **argv) {
+  uint8_t frame[64];
+  int32_t reply[2], len;
+  FILE   *f;
+
+  if (argc != 4) {
+    fprintf(stderr, "usage: transport_sender <state file> <expected data file> <mtu>\n");
+    return 2;
+  }
+
+  // No-init RAM: fault record regions and the transport state kept over resets
+  Fill(FaultInfo,     sizeof(FaultInfo));
+  Fill(FaultNested,   sizeof(FaultNested));
+#if (FR_HISTORY_SIZE != 0U)
+  Fill(&FaultHistory, sizeof(FaultHistory));
+#endif
+#if (FR_STACK_MONITOR_EXIST != 0)
+  Fill(StackNearMiss, sizeof(StackNearMiss));
+#endif
+  Fill(Attachment,    sizeof(Attachment));
+  FaultInfo[0].magic_number = FR_MAGIC_NUMBER;
+  WriteExpected(argv[2]);
+  f = fopen(argv[1], "rb");
+  if ((f == NULL) || (fread(&TransportState, sizeof(TransportState), 1U, f) != 1U)) {
+    Fill(&TransportState, sizeof(TransportState));
+  }
+  if (f != NULL) {
+    fclose(f);
+  }
+
+  FaultRecordTransportAttach(Attachment, sizeof(Attachment));
+  Remaining = FaultRecordTransportStart((uint32_t)atoi(argv[3]));
+  if (Remaining < 0) {
+    fprintf(stderr, "FaultRecordTransportStart failed\n");
+    return 1;
+  }
+  SaveState(argv[1]);
+
+  while ((len = ReadFrame(frame, sizeof(frame))) >= 0) {
+    if ((len == 1) && (frame[0] == 'R')) {
+      reply[0] = Remaining;
+      reply[1] = (int32_t)TransportChunkNum;
+      WriteFrame(reply, 8U);
+    } else if ((len == 1) && (frame[0] == 'N')) {
+      len = FaultRecordTransportNext(&Packet[4], sizeof(Packet) - 4U);
+      memcpy(Packet, &Remaining, 4U);
+      WriteFrame(Packet, 4U + (uint32_t)((len > 0) ? len : 0));
+    } else {
+      len = FaultRecordTransportAck(frame, (uint32_t)len);
+      if (len >= 0) {
+        Remaining = len;
+        SaveState(argv[1]);
+      }
+    }
+  }
+
+  return 0;
+}